@@ -9,6 +9,9 @@
 #include "sdmmc_cmd.h"
 #include "driver/sdspi_host.h"
 #include "esp_error.hpp"
+#include "esp_heap_caps.h"
+
+#include <cstring>
 
 #include "Driver/sdspi.h"
 #include "src/Config.h"
@@ -63,6 +66,14 @@ sdmmc_host_t  host_config = SDSPI_HOST_DEFAULT();
 sdmmc_card_t* card        = NULL;
 const char*   base_path   = "/sd";
 
+// Clock tuning state.  The card is mounted and unmounted often, so the
+// result of tuning is remembered and reused for the same card.
+static uint32_t base_khz     = 0;
+static uint32_t max_khz      = 0;
+static uint32_t clock_khz    = 0;
+static uint32_t tuned_khz    = 0;
+static uint32_t tuned_serial = 0;
+
 static void call_host_deinit(const sdmmc_host_t* host_config) {
     if (host_config->flags & SDMMC_HOST_FLAG_DEINIT_ARG) {
         host_config->deinit_p(host_config->slot);
@@ -86,6 +97,8 @@ bool sd_init_slot(uint32_t freq_hz, int cs_pin, int cd_pin, int wp_pin) {
     sdspi_device_config_t slot_config;
 
     host_config.max_freq_khz = freq_hz / 1000;
+    base_khz                 = freq_hz / 1000;
+    clock_khz                = base_khz;
 
     err = host_config.init();
     CHECK_EXECUTE_RESULT(err, "host init failed");
@@ -121,6 +134,70 @@ cleanup:
     return false;
 }
 
+// cppcheck-suppress unusedFunction
+void sd_autotune(uint32_t max_freq_hz) {
+    max_khz   = max_freq_hz / 1000;
+    tuned_khz = 0;
+}
+
+// cppcheck-suppress unusedFunction
+uint32_t sd_clock_hz() {
+    return clock_khz * 1000;
+}
+
+// Reads the first sectors of the card, the size of a multi-block transfer
+static const size_t probe_sectors = 8;
+
+static bool read_matches(uint8_t* buf, const uint8_t* reference) {
+    for (int pass = 0; pass < 2; ++pass) {
+        if (sdmmc_read_sectors(card, buf, 0, probe_sectors) != ESP_OK || memcmp(buf, reference, probe_sectors * 512)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Chooses the highest clock at which the card returns the same data
+// as it does at the configured clock.  Clock rates that the SPI
+// peripheral cannot produce exactly round down, so the candidates are
+// the rates that it can.
+static void tune_clock() {
+    if (max_khz <= base_khz) {
+        return;
+    }
+    if (tuned_khz && tuned_serial == card->cid.serial) {
+        if (sdspi_host_set_card_clk(host_config.slot, tuned_khz) == ESP_OK) {
+            clock_khz = tuned_khz;
+        }
+        return;
+    }
+
+    auto reference = static_cast<uint8_t*>(heap_caps_malloc(probe_sectors * 512, MALLOC_CAP_DMA));
+    auto buf       = static_cast<uint8_t*>(heap_caps_malloc(probe_sectors * 512, MALLOC_CAP_DMA));
+
+    uint32_t chosen = base_khz;
+    if (reference && buf && sdmmc_read_sectors(card, reference, 0, probe_sectors) == ESP_OK) {
+        const uint32_t candidates[] = { 40000, 26667, 20000, 16000, 13333, 10000 };
+        for (auto khz : candidates) {
+            if (khz > max_khz || khz <= base_khz) {
+                continue;
+            }
+            if (sdspi_host_set_card_clk(host_config.slot, khz) == ESP_OK && read_matches(buf, reference)) {
+                chosen = khz;
+                break;
+            }
+        }
+    }
+    free(buf);
+    free(reference);
+
+    sdspi_host_set_card_clk(host_config.slot, chosen);
+    clock_khz    = chosen;
+    tuned_khz    = chosen;
+    tuned_serial = card->cid.serial;
+    log_info("SD clock " << chosen << " kHz");
+}
+
 #if 0
 bool init_spi_bus(int mosi_pin, int miso_pin, int clk_pin) {
     spi_bus_config_t bus_cfg = {
@@ -167,6 +244,8 @@ std::error_code sd_mount(int max_files) {
     err = sdmmc_card_init(&host_config, card);
     CHECK_EXECUTE_RESULT(err, "sdmmc_card_init failed");
 
+    tune_clock();
+
     err = mount_to_vfs_fat(max_files, card, pdrv, base_path);
     CHECK_EXECUTE_RESULT(err, "mount_to_vfs failed");
 
@@ -197,6 +276,11 @@ void sd_unmount() {
     card = NULL;
 }
 
+// cppcheck-suppress unusedFunction
+uint32_t sd_card_serial() {
+    return card ? card->cid.serial : 0;
+}
+
 // cppcheck-suppress unusedFunction
 void sd_deinit_slot() {
     sdspi_host_remove_device(host_config.slot);
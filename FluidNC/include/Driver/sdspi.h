@@ -1,7 +1,17 @@
 #include <system_error>
+#include <cstdint>
 
 bool sd_init_slot(uint32_t freq_hz, int cs_pin, int cd_pin = -1, int wp_pin = -1);
 void sd_unmount();
 void sd_deinit_slot();
 
 std::error_code sd_mount(int max_files = 1);
+
+// At mount, use the fastest clock up to max_freq_hz that reads reliably
+void sd_autotune(uint32_t max_freq_hz);
+
+// The SPI clock rate in use
+uint32_t sd_clock_hz();
+
+// The serial number of the mounted card, or 0 if none is mounted
+uint32_t sd_card_serial();
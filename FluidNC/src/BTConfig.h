@@ -35,6 +35,7 @@ namespace WebUI {
 
         bool realtimeOkay(char c) override;
         bool lineComplete(char* line, char c) override;
+        bool scanLine(char* line, std::string_view& span) override { return scanLineBytewise(line, span); }
 
         Error pollLine(char* line) override;
     };
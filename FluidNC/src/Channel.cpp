@@ -13,8 +13,31 @@
 void Channel::flushRx() {
     _linelen   = 0;
     _lastWasCR = false;
-    while (_queue.size()) {
-        _queue.pop();
+    _queue.clear();
+    _queueHead = 0;
+
+    // A reset ends windowed flow control, so a sender that does not ask
+    // for it again gets the standard acks
+    _window       = 0;
+    _rxSeq        = 0;
+    _ackedSeq     = 0;
+    _lineWindowed = false;
+    _resendSent   = false;
+}
+
+void Channel::consume(size_t len) {
+    _queueHead += len;
+    if (_queueHead >= _queue.size()) {
+        // Reuse the allocation instead of letting the buffer creep forward
+        _queue.clear();
+        _queueHead = 0;
+    } else if (_queueHead > _queue.capacity() / 2) {
+        // A streaming sender can keep the queue from ever emptying, so drop
+        // the consumed prefix before the buffer grows with the whole job.
+        // The bytes moved are fewer than those consumed since the last
+        // erase, so the cost per byte stays constant.
+        _queue.erase(0, _queueHead);
+        _queueHead = 0;
     }
 }
 
@@ -68,6 +91,68 @@ bool Channel::lineComplete(char* line, char ch) {
     return false;
 }
 
+bool Channel::scanLineBytewise(char* line, std::string_view& span) {
+    while (span.length()) {
+        char ch = span.front();
+        span.remove_prefix(1);
+        if (lineComplete(line, ch)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// This is equivalent to calling the base lineComplete() for each character,
+// but ordinary characters are located with memchr-style searches and copied
+// as a block, and a line that arrives whole goes directly into line without
+// passing through _line.
+bool Channel::scanLine(char* line, std::string_view& span) {
+    while (span.length()) {
+        if (_lastWasCR && span.front() == '\n') {
+            // LF after CR; the line was already completed by the CR
+            span.remove_prefix(1);
+        }
+        _lastWasCR = false;
+
+        auto             end = span.find_first_of("\r\n\b");
+        std::string_view run = span.substr(0, end);
+
+        if (end != span.npos && span[end] != '\b' && _linelen == 0) {
+            size_t len = std::min(run.length(), size_t(Channel::maxLine - 1));
+            memcpy(line, run.data(), len);
+            line[len]  = '\0';
+            _lastWasCR = span[end] == '\r';
+            span.remove_prefix(end + 1);
+            return true;
+        }
+
+        // Characters past the end of a full line are dropped, as in lineComplete()
+        size_t len = std::min(run.length(), size_t(Channel::maxLine - 1) - _linelen);
+        memcpy(_line + _linelen, run.data(), len);
+        _linelen += len;
+
+        if (end == span.npos) {
+            span.remove_prefix(span.length());
+            return false;
+        }
+        char ch = span[end];
+        span.remove_prefix(end + 1);
+        if (ch == '\b') {
+            // Simple editing for interactive input - backspace erases
+            if (_linelen) {
+                --_linelen;
+            }
+            continue;
+        }
+        _lastWasCR      = ch == '\r';
+        _line[_linelen] = '\0';
+        strcpy(line, _line);
+        _linelen = 0;
+        return true;
+    }
+    return false;
+}
+
 uint32_t Channel::setReportInterval(uint32_t ms) {
     uint32_t actual = ms;
     if (actual) {
@@ -180,40 +265,67 @@ void Channel::handleRealtimeCharacter(uint8_t ch) {
 }
 
 void Channel::push(uint8_t byte) {
-    if (is_realtime_command(byte)) {
-        handleRealtimeCharacter(byte);
-    } else {
-        _queue.push(byte);
+    push(&byte, 1);
+}
+
+void Channel::push(const uint8_t* data, size_t length) {
+    queueBytes(data, length, false);
+}
+
+// Realtime characters are executed immediately.  The runs of ordinary
+// characters between them are appended to the queue as blocks.
+void Channel::queueBytes(const uint8_t* data, size_t length, bool fromDevice) {
+    const uint8_t* run = data;
+    for (const uint8_t* p = data; p < data + length; ++p) {
+        if ((!fromDevice || realtimeOkay(*p)) && is_realtime_command(*p)) {
+            _queue.append(reinterpret_cast<const char*>(run), p - run);
+            handleRealtimeCharacter(*p);
+            run = p + 1;
+        }
+    }
+    _queue.append(reinterpret_cast<const char*>(run), data + length - run);
+}
+
+size_t Channel::readSpan(uint8_t* buffer, size_t length) {
+    int ch = read();
+    if (ch < 0) {
+        return 0;
     }
+    *buffer = ch;
+    return 1;
 }
 
 Error Channel::pollLine(char* line) {
     handle();
     while (1) {
-        int ch = -1;
-        if (line && _queue.size()) {
-            ch = _queue.front();
-            _queue.pop();
-        } else {
-            ch = read();
-            if (ch < 0) {
-                break;
-            }
-            _active = true;
-            if (realtimeOkay(ch) && is_realtime_command(ch)) {
-                handleRealtimeCharacter((uint8_t)ch);
+        if (line && queued()) {
+            auto span = queuedSpan();
+            bool done = scanLine(line, span);
+            consume(queued() - span.length());
+            if (done) {
+                if (!_window) {
+                    _lineWindowed = false;
+                    return Error::Ok;
+                }
+                if (windowedLine(line)) {
+                    return Error::Ok;
+                }
                 continue;
             }
-            if (!line) {
-                _queue.push(ch);
-                continue;
-            }
-            // Fall through if line is non-null and it is not a realtime character
         }
-
-        if (lineComplete(line, ch)) {
-            return Error::Ok;
+        uint8_t buffer[128];
+        size_t  len = readSpan(buffer, sizeof(buffer));
+        if (len == 0) {
+            break;
         }
+        _active = true;
+        // If line is null, the bytes stay queued after realtime characters
+        // are handled, until a caller asks for a line.
+        queueBytes(buffer, len, true);
+    }
+    if (line && _window) {
+        // No line is waiting, so the sender may be blocked on acks
+        flushAcks();
     }
     if (_active) {
         autoReport();
@@ -254,7 +366,91 @@ void Channel::registerEvent(uint8_t code, EventPin* obj) {
     _events[code] = obj;
 }
 
+uint32_t Channel::setWindow(uint32_t credits) {
+    if (_lineWindowed) {
+        // Settle the lines before this command under the old window; the
+        // command itself gets a plain ok so the sender can resynchronize.
+        if (_ackedSeq != _rxSeq - 1) {
+            sendAck(_rxSeq - 1);
+        }
+        _lineWindowed = false;
+    }
+    _window     = std::min(credits, maxWindow);
+    _rxSeq      = 0;
+    _ackedSeq   = 0;
+    _resendSent = false;
+    return _window;
+}
+
+// Strips the optional "@<seq> " prefix and checks the sequence number.
+// Returns false if the line must not be executed.
+bool Channel::windowedLine(char* line) {
+    uint32_t seq = _rxSeq + 1;
+    if (*line == '@') {
+        char* endptr;
+        seq = strtoul(line + 1, &endptr, 10);
+        if (endptr == line + 1) {
+            // Not a sequence number; let the GCode parser reject it
+            seq = _rxSeq + 1;
+        } else {
+            while (*endptr == ' ') {
+                ++endptr;
+            }
+            memmove(line, endptr, strlen(endptr) + 1);
+        }
+    }
+    if (seq <= _rxSeq) {
+        // Retransmission of a line that has already been executed
+        flushAcks(true);
+        return false;
+    }
+    if (seq != _rxSeq + 1) {
+        // The lines after a gap are dropped until the missing one arrives;
+        // only the first of them asks for it.
+        if (!_resendSent) {
+            LogStream msg(*this, "resend:");
+            msg << _rxSeq + 1;
+            _resendSent = true;
+        }
+        return false;
+    }
+    _rxSeq        = seq;
+    _lineWindowed = true;
+    _resendSent   = false;
+    return true;
+}
+
+void Channel::sendAck(uint32_t seq) {
+    LogStream msg(*this, "ok:");
+    msg << seq << "," << _window;
+    _ackedSeq = seq;
+}
+
+void Channel::flushAcks(bool force) {
+    if (force || _ackedSeq != _rxSeq) {
+        sendAck(_rxSeq);
+    }
+}
+
 void Channel::ack(Error status) {
+    if (_lineWindowed) {
+        if (status != Error::Ok) {
+            if (_ackedSeq != _rxSeq - 1) {
+                sendAck(_rxSeq - 1);
+            }
+            _ackedSeq = _rxSeq;
+            {
+                LogStream msg(*this, "error:");
+                msg << static_cast<int>(status) << "," << _rxSeq;
+            }
+            if (config->_verboseErrors) {
+                log_error_to(*this, errorString(status));
+            }
+        } else if (_rxSeq - _ackedSeq >= std::max(_window / 2, uint32_t(1))) {
+            flushAcks();
+        }
+        return;
+    }
     if (status == Error::Ok) {
         sendLine(MsgLevelNone, "ok");
         return;
@@ -13,6 +13,21 @@
 // overrunning input buffers.  The default implementation of ack() sends
 // "ok" and "error:" messages via the standard Grbl serial protocol, but it
 // could be implemented in other ways for different channel protocols.
+//
+// $Channel/Window=<n> turns on windowed flow control for a channel.  The
+// sender may then have up to n lines outstanding beyond the last one that
+// was acknowledged, and may prefix each line with "@<seq> " where seq
+// counts up from 1; unprefixed lines take the next number.  Successful
+// lines are acknowledged cumulatively with "ok:<seq>,<n>", sent when half
+// the window is pending or when no further line is waiting.  A failed line
+// gets "error:<code>,<seq>" after the acks for the lines before it.  A line
+// whose number was already received is not executed again, so a sender can
+// retransmit lines it has not seen acknowledged.  A gap in the numbering
+// gets one "resend:<seq>" naming the first missing line, and the lines
+// after the gap are dropped until that one arrives.  A reset, or a new
+// connection, returns the channel to per-line ok/error acks with the
+// numbering restarted, so a sender that reconnects must turn windowing on
+// again and cannot resume the numbering of the old connection.
 
 #pragma once
 
@@ -27,7 +42,7 @@
 
 #include <Stream.h>
 #include <freertos/FreeRTOS.h>  // TickType_T
-#include <queue>
+#include <string_view>
 
 class Channel : public Stream {
 private:
@@ -55,7 +70,20 @@ protected:
     bool        _addCR         = false;
     char        _lastWasCR     = false;
 
-    std::queue<uint8_t> _queue;
+    // Received bytes that have not yet been consumed as lines.  They are
+    // kept contiguous so that pollLine() can scan and copy whole spans
+    // instead of handling one byte at a time.
+    std::string _queue;
+    size_t      _queueHead = 0;
+
+    size_t           queued() const { return _queue.size() - _queueHead; }
+    std::string_view queuedSpan() const { return std::string_view(_queue).substr(_queueHead); }
+    void             consume(size_t len);
+
+    // Appends data to the queue, executing realtime characters as they are
+    // seen.  Bytes read from the device also check realtimeOkay(); bytes
+    // that other code, such as WSChannel, hands to push() do not.
+    void queueBytes(const uint8_t* data, size_t length, bool fromDevice);
 
     uint32_t _reportInterval = 0;
     int32_t  _nextReportTime = 0;
@@ -76,6 +104,19 @@ protected:
 
     Cmd _last_rt_cmd = Cmd::None;
 
+    // Windowed flow control state
+    static constexpr uint32_t maxWindow = 32;
+
+    uint32_t _window       = 0;      // Line credits advertised to the sender; 0 for per-line acks
+    uint32_t _rxSeq        = 0;      // Sequence number of the most recent line
+    uint32_t _ackedSeq     = 0;      // Highest sequence number acknowledged to the sender
+    bool     _lineWindowed = false;  // The most recent line arrived while windowing was on
+    bool     _resendSent   = false;  // A resend was requested for the line after _rxSeq
+
+    bool windowedLine(char* line);
+    void sendAck(uint32_t seq);
+    void flushAcks(bool force = false);
+
     std::map<int, EventPin*> _events;
     std::map<int, bool*>     _pin_values;
 
@@ -106,6 +147,8 @@ public:
     size_t _line_number = 0;
 
     std::string _progress;
+    float       _percent   = -1;  // Progress of a file job, for displays that do not want text
+    float       _remaining = -1;  // Estimated seconds left in a file job that has been scanned
 
     // rx_buffer_available() is the number of bytes that can be sent without overflowing
     // a reception buffer, even if the system is busy.  Channels that can handle external
@@ -113,7 +156,7 @@ public:
     // the remaining space that mechanism has available.
     // The queue can handle more than 256 characters but we don't want it to get too
     // large, so we report a limited size.
-    virtual int rx_buffer_available() { return std::max(0, 256 - int(_queue.size())); }
+    virtual int rx_buffer_available() { return std::max(0, 256 - int(queued())); }
 
     // flushRx() discards any characters that have already been received.  It is used
     // after a reset, so that anything already sent will not be processed.
@@ -132,6 +175,18 @@ public:
     // end is seen.
     virtual bool lineComplete(char* line, char c);
 
+    // scanLine() consumes characters from the front of span until a line end
+    // is seen, returning true with the line in line.  The default copies runs
+    // of ordinary characters in bulk; channels that do line editing override
+    // it with scanLineBytewise() so that lineComplete() sees every character.
+    virtual bool scanLine(char* line, std::string_view& span);
+    bool         scanLineBytewise(char* line, std::string_view& span);
+
+    // readSpan() reads up to length bytes that are already available from the
+    // device, returning the number read.  The default reads one byte with read(),
+    // which lets realtimeOkay() track line editing state between characters.
+    virtual size_t readSpan(uint8_t* buffer, size_t length);
+
     virtual size_t timedReadBytes(char* buffer, size_t length, TickType_t timeout) {
         setTimeout(timeout);
         return readBytes(buffer, length);
@@ -155,28 +210,23 @@ public:
 
     int peek() override { return -1; }
     int read() override { return -1; }
-    int available() override { return _queue.size(); }
+    int available() override { return queued(); }
 
     virtual void print_msg(MsgLevel level, const char* msg);
 
     void print_msg(MsgLevel level, const std::string& msg) { print_msg(level, msg.c_str()); }
 
+    uint32_t setWindow(uint32_t credits);
+    uint32_t getWindow() { return _window; }
+
     uint32_t     setReportInterval(uint32_t ms);
     uint32_t     getReportInterval() { return _reportInterval; }
     virtual void autoReport();
     void         autoReportGCodeState();
 
     void push(uint8_t byte);
-    void push(const uint8_t* data, size_t length) {
-        while (length--) {
-            push(*data++);
-        }
-    }
-    void push(std::string_view data) {
-        for (auto const& c : data) {
-            push((uint8_t)c);
-        }
-    }
+    void push(const uint8_t* data, size_t length);
+    void push(std::string_view data) { push(reinterpret_cast<const uint8_t*>(data.data()), data.length()); }
     void push(const std::string& s) { push(reinterpret_cast<const uint8_t*>(s.c_str()), s.length()); }
 
     void end() { _ended = true; }
@@ -23,7 +23,7 @@ Some features should not be changed. See notes below.
 // machine.h is #included below, after some definitions
 // that the machine file might choose to undefine.
 
-const int MAX_N_AXIS = 6;
+#include "NAxis.h"  // MAX_N_AXIS
 
 const int MAX_MESSAGE_LINE = 256;
 
@@ -46,6 +46,11 @@ const int C2_AXIS = (C_AXIS + MAX_N_AXIS);
 
 const int SUPPORT_TASK_CORE = 0;  // Reference: CONFIG_ARDUINO_RUNNING_CORE = 1
 
+// Step segment preparation runs away from the G-code parser, which runs on
+// CONFIG_ARDUINO_RUNNING_CORE, and above the other support tasks
+const int SEGMENT_PREP_TASK_CORE     = SUPPORT_TASK_CORE;
+const int SEGMENT_PREP_TASK_PRIORITY = 5;
+
 // Serial baud rate
 // OK to change, but the ESP32 boot text is 115200, so you will not see that is your
 // serial monitor, sender, etc uses a different value than 115200
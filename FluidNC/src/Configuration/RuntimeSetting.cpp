@@ -20,6 +20,11 @@ namespace Configuration {
         std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);
     }
 
+    RuntimeSetting::RuntimeSetting(const char* key, const char* value, Channel& out, const char* start) :
+        RuntimeSetting(key, value, out) {
+        start_ = start;
+    }
+
     std::string RuntimeSetting::setting_prefix() {
         std::string s("$/");
         s += setting_;
@@ -32,6 +32,9 @@ namespace Configuration {
 
     public:
         RuntimeSetting(const char* key, const char* value, Channel& out);
+        // For use with SectionIndex; start is the component of key to match
+        // against the section that the handler is given
+        RuntimeSetting(const char* key, const char* value, Channel& out, const char* start);
 
         void item(const char* name, bool& value) override;
         void item(const char* name, int32_t& value, const int32_t minValue, const int32_t maxValue) override;
@@ -0,0 +1,81 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "SectionIndex.h"
+
+#include "Configurable.h"
+#include "../Machine/MachineConfig.h"  // config
+
+#include <cctype>
+#include <cstring>
+
+namespace Configuration {
+    std::unordered_map<std::string, Configurable*> SectionIndex::_sections;
+    bool                                           SectionIndex::_valid = false;
+
+    static void append_lower(std::string& s, const char* name, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            s += char(tolower(name[i]));
+        }
+    }
+
+    void SectionIndex::enterSection(const char* name, Configurable* value) {
+        auto previous = _path.length();
+        if (previous) {
+            _path += '/';
+        }
+        append_lower(_path, name, strlen(name));
+
+        auto [it, inserted] = _sections.emplace(_path, value);
+        if (!inserted) {
+            // Two sections with the same path, as with some factory lists;
+            // only a full tree walk handles those correctly.
+            it->second = nullptr;
+        }
+        value->group(*this);
+
+        _path.resize(previous);
+    }
+
+    void SectionIndex::build() {
+        _sections.clear();
+        _sections.emplace("", config);
+
+        SectionIndex indexer;
+        config->group(indexer);
+        _valid = true;
+    }
+
+    bool SectionIndex::find(const char* path, Configurable*& section, const char*& leaf) {
+        if (!config) {
+            return false;
+        }
+        if (!_valid) {
+            build();
+        }
+
+        if (*path == '/') {
+            ++path;
+        }
+        // A trailing / selects a whole section, which belongs to its parent
+        auto len = strlen(path);
+        if (len && path[len - 1] == '/') {
+            --len;
+        }
+        auto slash = len;
+        while (slash && path[slash - 1] != '/') {
+            --slash;
+        }
+        leaf = path + slash;
+
+        std::string key;
+        append_lower(key, path, slash ? slash - 1 : 0);
+
+        auto it = _sections.find(key);
+        if (it == _sections.end()) {
+            return false;
+        }
+        section = it->second;
+        return true;
+    }
+}
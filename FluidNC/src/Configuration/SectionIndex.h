@@ -0,0 +1,60 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include "HandlerBase.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace Configuration {
+    class Configurable;
+
+    // SectionIndex maps the path of every configuration section, such as
+    // "axes/x/motor0", to the section object, so a $/path command can hand
+    // the RuntimeSetting handler straight to the section that holds the
+    // item instead of walking the whole tree.  The index is built on first
+    // use and must be invalidated whenever afterParse() may have changed
+    // the shape of the tree.
+    class SectionIndex : public HandlerBase {
+        SectionIndex(const SectionIndex&) = delete;
+        SectionIndex& operator=(const SectionIndex&) = delete;
+
+        std::string _path;
+
+        static std::unordered_map<std::string, Configurable*> _sections;
+        static bool                                           _valid;
+
+        SectionIndex() = default;
+
+        static void build();
+
+    protected:
+        void        enterSection(const char* name, Configurable* value) override;
+        bool        matchesUninitialized(const char* name) override { return false; }
+        HandlerType handlerType() override { return HandlerType::Runtime; }
+
+    public:
+        void item(const char* name, bool& value) override {}
+        void item(const char* name, int32_t& value, const int32_t minValue, const int32_t maxValue) override {}
+        void item(const char* name, uint32_t& value, const uint32_t minValue, const uint32_t maxValue) override {}
+        void item(const char* name, float& value, const float minValue, const float maxValue) override {}
+        void item(const char* name, std::vector<speedEntry>& value) override {}
+        void item(const char* name, std::vector<float>& value) override {}
+        void item(const char* name, UartData& wordLength, UartParity& parity, UartStop& stopBits) override {}
+        void item(const char* name, std::string& value, const int minLength, const int maxLength) override {}
+        void item(const char* name, Pin& value) override {}
+        void item(const char* name, Macro& value) override {}
+        void item(const char* name, IPAddress& value) override {}
+        void item(const char* name, int& value, const EnumItem* e) override {}
+
+        // Looks up the section that contains the last component of path.
+        // On success, leaf points to that component within path.  Returns
+        // false if no such section exists.  A true return with a null section
+        // means the path is ambiguous and the whole tree must be searched.
+        static bool find(const char* path, Configurable*& section, const char*& leaf);
+
+        static void invalidate() { _valid = false; }
+    };
+}
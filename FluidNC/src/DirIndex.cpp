@@ -0,0 +1,170 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "DirIndex.h"
+#include "Driver/sdspi.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace stdfs = std::filesystem;
+
+std::map<std::string, DirIndex::Dir> DirIndex::_dirs;
+uint32_t                             DirIndex::_uses = 0;
+std::mutex                           DirIndex::_mutex;
+
+static std::string key(const stdfs::path& path) {
+    std::string s = path.string();
+    while (s.length() > 1 && s.back() == '/') {
+        s.pop_back();
+    }
+    return s;
+}
+
+// A card swap must not return the listing of the previous card
+static uint32_t volume_id(const stdfs::path& path) {
+    auto it = path.begin();
+    if (it != path.end() && ++it != path.end() && *it == "sd") {
+        return sd_card_serial();
+    }
+    return 0;
+}
+
+bool DirIndex::parse_options(const char* value, std::string& path, Options& options) {
+    std::string_view rest(value ? value : "");
+    auto             semi = rest.find(';');
+    path                  = rest.substr(0, semi);
+
+    while (semi != std::string_view::npos) {
+        rest.remove_prefix(semi + 1);
+        semi                  = rest.find(';');
+        std::string_view item = rest.substr(0, semi);
+
+        auto             equals = item.find('=');
+        std::string_view name   = item.substr(0, equals);
+        std::string      arg    = equals == std::string_view::npos ? "" : std::string(item.substr(equals + 1));
+
+        if (name == "refresh") {
+            options.refresh = true;
+        } else if (name == "start" || name == "count") {
+            char* end;
+            auto  n = strtoul(arg.c_str(), &end, 10);
+            if (arg.empty() || *end) {
+                return false;
+            }
+            (name == "start" ? options.start : options.count) = n;
+        } else if (name == "sort") {
+            options.reverse = !arg.empty() && arg[0] == '-';
+            if (options.reverse) {
+                arg.erase(0, 1);
+            }
+            if (arg == "name") {
+                options.order = Order::Name;
+            } else if (arg == "size") {
+                options.order = Order::Size;
+            } else if (arg == "time") {
+                options.order = Order::Time;
+            } else {
+                return false;
+            }
+        } else if (!name.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<const DirIndex::Entries> DirIndex::get(const stdfs::path& dir, std::error_code& ec, bool refresh) {
+    auto     k      = key(dir);
+    uint32_t volume = volume_id(dir);
+
+    // The lock is held while reading the directory so that an invalidate()
+    // in the meantime cannot be undone by caching the old contents
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto found = _dirs.find(k);
+    if (found != _dirs.end()) {
+        if (!refresh && found->second.volume == volume) {
+            found->second.lastUse = ++_uses;
+            return found->second.entries;
+        }
+        _dirs.erase(found);
+    }
+
+    auto iter = stdfs::directory_iterator { dir, ec };
+    if (ec) {
+        return nullptr;
+    }
+
+    // One stat() per entry gets the type, size and time together
+    auto entries = std::make_shared<Entries>();
+    for (auto const& dir_entry : iter) {
+        struct stat st;
+        if (stat(dir_entry.path().c_str(), &st)) {
+            continue;
+        }
+        entries->push_back({ dir_entry.path().filename().string(), S_ISDIR(st.st_mode) ? -1 : int64_t(st.st_size), st.st_mtime });
+    }
+
+    if (_dirs.size() >= maxDirs) {
+        auto oldest = std::min_element(
+            _dirs.begin(), _dirs.end(), [](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+        _dirs.erase(oldest);
+    }
+    _dirs[k] = { entries, volume, ++_uses };
+    return entries;
+}
+
+std::vector<const DirIndex::Entry*> DirIndex::select(const Entries& entries, const Options& options) {
+    std::vector<const Entry*> selected;
+    selected.reserve(entries.size());
+    for (auto const& entry : entries) {
+        selected.push_back(&entry);
+    }
+
+    auto order = options.order;
+    if (order != Order::None) {
+        // Directories come first, then the chosen key, then the name as a tiebreaker
+        std::stable_sort(selected.begin(), selected.end(), [order, &options](const Entry* a, const Entry* b) {
+            if (a->is_dir() != b->is_dir()) {
+                return a->is_dir();
+            }
+            if (options.reverse) {
+                std::swap(a, b);
+            }
+            if (order == Order::Size && a->size != b->size) {
+                return a->size < b->size;
+            }
+            if (order == Order::Time && a->mtime != b->mtime) {
+                return a->mtime < b->mtime;
+            }
+            return strcasecmp(a->name.c_str(), b->name.c_str()) < 0;
+        });
+    }
+
+    size_t start = std::min(options.start, selected.size());
+    size_t end   = start + std::min(options.count, selected.size() - start);
+    return std::vector<const Entry*>(selected.begin() + start, selected.begin() + end);
+}
+
+void DirIndex::invalidate(const stdfs::path& path) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _dirs.erase(key(path.parent_path()));
+
+    // If path is a directory, it and its subdirectories are stale too
+    auto prefix = key(path);
+    for (auto it = _dirs.lower_bound(prefix); it != _dirs.end() && it->first.compare(0, prefix.length(), prefix) == 0;) {
+        if (it->first.length() == prefix.length() || it->first[prefix.length()] == '/') {
+            it = _dirs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DirIndex::invalidate_all() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _dirs.clear();
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+#include <system_error>
+#include <ctime>
+#include <cstdint>
+
+// DirIndex caches directory listings so that repeated and paged listings
+// of large directories do not enumerate and stat every file each time.
+// A directory is read from the filesystem the first time it is listed
+// and the cached copy is used until something that FluidNC does changes
+// it - a write, delete, rename or mkdir - or a different SD card is
+// mounted.  Changes made elsewhere, e.g. by editing the card on a PC,
+// are picked up by listing with the refresh option.
+//
+// Listings are made and invalidated from several tasks - commands, the
+// web server and the job scanner - so the cache is guarded by a mutex.
+// The entries are returned as shared pointers to constant vectors, so a
+// caller can keep using a listing after it has been dropped from the cache.
+
+class DirIndex {
+public:
+    struct Entry {
+        std::string name;
+        int64_t     size;  // -1 for directories
+        time_t      mtime;
+
+        bool is_dir() const { return size < 0; }
+    };
+    using Entries = std::vector<Entry>;
+
+    enum class Order { None, Name, Size, Time };
+
+    // Listing options parsed from the tail of a command argument,
+    // e.g. "/sd/jobs;start=100;count=50;sort=-time;refresh"
+    struct Options {
+        size_t start   = 0;
+        size_t count   = SIZE_MAX;
+        Order  order   = Order::None;
+        bool   reverse = false;
+        bool   refresh = false;
+    };
+
+    // Splits the options from the path in value; returns false if an option is invalid
+    static bool parse_options(const char* value, std::string& path, Options& options);
+
+    // The entries of dir, read from the filesystem only if there is no cached copy
+    static std::shared_ptr<const Entries> get(const std::filesystem::path& dir, std::error_code& ec, bool refresh = false);
+
+    // The entries selected by the sort order, start and count of options
+    static std::vector<const Entry*> select(const Entries& entries, const Options& options);
+
+    // Call after the file or directory at path is created, written, renamed or deleted
+    static void invalidate(const std::filesystem::path& path);
+    static void invalidate_all();
+
+private:
+    // Only the most recently used directories are kept
+    static const size_t maxDirs = 8;
+
+    struct Dir {
+        std::shared_ptr<const Entries> entries;
+        uint32_t                       volume;
+        uint32_t                       lastUse;
+    };
+    static std::map<std::string, Dir> _dirs;
+    static uint32_t                   _uses;
+    static std::mutex                 _mutex;
+};
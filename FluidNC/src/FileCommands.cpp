@@ -11,8 +11,13 @@
 #include "src/Protocol.h"   // pollingPaused
 
 #include "src/HashFS.h"
+#include "src/DirIndex.h"
+#include "src/JobScanner.h"
+#include "Driver/sdspi.h"        // sd_clock_hz()
+#include "Driver/delay_usecs.h"  // getCpuTicks()
 
 #include <charconv>
+#include <vector>
 
 static Error localFSSize(const char* parameter, AuthenticationLevel auth_level, Channel& out) {  // ESP720
     try {
@@ -30,6 +35,7 @@ static Error localFSSize(const char* parameter, AuthenticationLevel auth_level,
 }
 
 static Error formatLocalFS(const char* parameter, AuthenticationLevel auth_level, Channel& out) {  // ESP710
+    DirIndex::invalidate_all();
     if (localfs_format(parameter)) {
         return Error::FsFailedFormat;
     }
@@ -269,6 +275,31 @@ static Error runSDFile(const char* parameter, AuthenticationLevel auth_level, Ch
     return runFile("sd", parameter, auth_level, out);
 }
 
+// Reports the estimated run time and extent of a file, scanning it
+// in the background first if it has not been scanned since it changed
+static Error scanSDFile(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
+    if (!parameter || !*parameter) {
+        log_error_to(out, "Missing file name");
+        return Error::InvalidValue;
+    }
+    std::string path(parameter);
+    if (path[0] != '/') {
+        path = "/" + path;
+    }
+    try {
+        FluidPath fpath { path.c_str(), sdName };
+        JobScan   scan;
+        if (JobScanner::load(fpath.c_str(), scan)) {
+            JobScanner::report(fpath.c_str(), scan, out);
+            return Error::Ok;
+        }
+    } catch (std::filesystem::filesystem_error const& ex) {
+        log_error_to(out, ex.what());
+        return Error::FsFailedMount;
+    }
+    return JobScanner::start(path.c_str(), out);
+}
+
 // Used by js/controls.js
 static Error runLocalFile(const char* parameter, AuthenticationLevel auth_level, Channel& out) {  // ESP700
     return runFile("", parameter, auth_level, out);
@@ -289,6 +320,7 @@ static Error deleteObject(const char* fs, const char* name, Channel& out) {
         } else {
             stdfs::remove(fpath);
         }
+        DirIndex::invalidate(fpath);
         HashFS::delete_file(fpath);
     } catch (std::filesystem::filesystem_error const& ex) {
         log_error_to(out, ex.what());
@@ -306,20 +338,40 @@ static Error deleteLocalFile(const char* parameter, AuthenticationLevel auth_lev
     return deleteObject(localfsName, parameter, out);
 }
 
+static void listDirectory(const stdfs::path& dir, const DirIndex::Options& options, int depth, Channel& out) {
+    std::error_code ec;
+    auto            entries = DirIndex::get(dir, ec, options.refresh);
+    if (ec) {
+        log_error_to(out, dir.c_str() << " " << ec.message());
+        return;
+    }
+
+    // Paging applies to the top level; subdirectories are listed in full
+    auto subOptions  = options;
+    subOptions.start = 0;
+    subOptions.count = SIZE_MAX;
+
+    std::string indent(depth, ' ');
+    for (auto entry : DirIndex::select(*entries, options)) {
+        if (entry->is_dir()) {
+            log_stream(out, "[DIR:" << indent << entry->name);
+            listDirectory(dir / entry->name, subOptions, depth + 1, out);
+        } else {
+            log_stream(out, "[FILE: " << indent << entry->name << "|SIZE:" << uint64_t(entry->size));
+        }
+    }
+}
+
 static Error listFilesystem(const char* fs, const char* value, AuthenticationLevel auth_level, Channel& out) {
+    std::string       path;
+    DirIndex::Options options;
+    if (!DirIndex::parse_options(value, path, options)) {
+        return Error::InvalidValue;
+    }
     try {
-        FluidPath fpath { value, fs };
-        auto      iter  = stdfs::recursive_directory_iterator { fpath };
+        FluidPath fpath { path.c_str(), fs };
         auto      space = stdfs::space(fpath);
-        for (auto const& dir_entry : iter) {
-            if (dir_entry.is_directory()) {
-                log_stream(out, "[DIR:" << std::string(iter.depth(), ' ').c_str() << dir_entry.path().filename());
-            } else {
-                log_stream(out,
-                           "[FILE: " << std::string(iter.depth(), ' ').c_str() << dir_entry.path().filename()
-                                     << "|SIZE:" << dir_entry.file_size());
-            }
-        }
+        listDirectory(fpath, options, 0, out);
         auto totalBytes = space.capacity;
         auto freeBytes  = space.available;
         auto usedBytes  = totalBytes - freeBytes;
@@ -343,28 +395,40 @@ static Error listLocalFiles(const char* parameter, AuthenticationLevel auth_leve
 }
 
 static Error listFilesystemJSON(const char* fs, const char* value, AuthenticationLevel auth_level, Channel& out) {
+    std::string       path;
+    DirIndex::Options options;
+    if (!DirIndex::parse_options(value, path, options)) {
+        return Error::InvalidValue;
+    }
     try {
-        FluidPath fpath { value, fs };
-        auto      space = stdfs::space(fpath);
-        auto      iter  = stdfs::directory_iterator { fpath };
+        FluidPath       fpath { path.c_str(), fs };
+        auto            space = stdfs::space(fpath);
+        std::error_code ec;
+        auto            entries = DirIndex::get(fpath, ec, options.refresh);
+        if (ec) {
+            throw stdfs::filesystem_error("Cannot list", fpath, ec);
+        }
 
         JSONencoder j(false, &out);
         j.begin();
 
         j.begin_array("files");
-        for (auto const& dir_entry : iter) {
+        for (auto entry : DirIndex::select(*entries, options)) {
             j.begin_object();
-            j.member("name", dir_entry.path().filename());
-            j.member("size", dir_entry.is_directory() ? -1 : dir_entry.file_size());
+            j.member("name", entry->name);
+            j.member("size", std::to_string(entry->size));
+            j.member("mtime", int(entry->mtime));
             j.end_object();
         }
         j.end_array();
+        j.member("start", int(options.start));
+        j.member("entries", int(entries->size()));
 
         auto totalBytes = space.capacity;
         auto freeBytes  = space.available;
         auto usedBytes  = totalBytes - freeBytes;
 
-        j.member("path", value);
+        j.member("path", path);
         j.member("total", formatBytes(totalBytes));
         j.member("used", formatBytes(usedBytes + 1));
 
@@ -391,38 +455,53 @@ static Error listLocalFilesJSON(const char* parameter, AuthenticationLevel auth_
 static Error listGCodeFiles(const char* parameter, AuthenticationLevel auth_level, Channel& out) {  // No ESP command
     const char* error = "";
 
+    std::string       path;
+    DirIndex::Options options;
+    if (!DirIndex::parse_options(parameter, path, options)) {
+        return Error::InvalidValue;
+    }
+
     JSONencoder j(true, &out);  // Encapsulated JSON
     j.begin();
 
     std::error_code ec;
 
-    FluidPath fpath { parameter, sdName, ec };
+    FluidPath fpath { path.c_str(), sdName, ec };
     if (ec) {
         error = "No volume";
     }
 
+    size_t visible = 0;
     j.begin_array("files");
     if (!*error) {  // Array is empty for failure to open the volume
-        auto iter = stdfs::directory_iterator { fpath, ec };
+        auto entries = DirIndex::get(fpath, ec, options.refresh);
         if (ec) {
             // Array is empty for failure to open the path
             error = "Bad path";
         } else {
-            for (auto const& dir_entry : iter) {
-                auto fn     = dir_entry.path().filename();
-                auto is_dir = dir_entry.is_directory();
-                if (out.is_visible(fn.stem(), fn.extension(), is_dir)) {
-                    j.begin_object();
-                    j.member("name", dir_entry.path().filename());
-                    j.member("size", is_dir ? -1 : dir_entry.file_size());
-                    j.end_object();
+            // Page through the visible files, not all of them
+            DirIndex::Entries shown;
+            for (auto const& entry : *entries) {
+                stdfs::path fn(entry.name);
+                if (out.is_visible(fn.stem(), fn.extension(), entry.is_dir())) {
+                    shown.push_back(entry);
                 }
             }
+            visible = shown.size();
+            for (auto entry : DirIndex::select(shown, options)) {
+                j.begin_object();
+                j.member("name", entry->name);
+                j.member("size", std::to_string(entry->size));
+                j.member("mtime", int(entry->mtime));
+                j.end_object();
+            }
         }
     }
     j.end_array();
 
-    j.member("path", parameter);
+    j.member("path", path);
+    j.member("start", int(options.start));
+    j.member("entries", int(visible));
     if (*error) {
         j.member("error", error);
     }
@@ -462,6 +541,8 @@ static Error renameObject(const char* fs, const char* parameter, AuthenticationL
         FluidPath inPath { ipath, fs };
         FluidPath outPath { opath, fs };
         std::filesystem::rename(inPath, outPath);
+        DirIndex::invalidate(inPath);
+        DirIndex::invalidate(outPath);
         HashFS::rename_file(inPath, outPath, true);
     } catch (std::filesystem::filesystem_error const& ex) {
         log_error_to(out, ex.what());
@@ -511,6 +592,7 @@ static Error copyDir(const char* iDir, const char* oDir, Channel& out) {  // No
                 log_error_to(out, "Cannot create " << oDir);
                 return Error::FsFailedOpenDir;
             }
+            DirIndex::invalidate(outDir);
         }
     }
 
@@ -570,6 +652,7 @@ static Error migrateLocalFS(const char* parameter, AuthenticationLevel auth_leve
         return err;
     }
     log_info("Reformatting local filesystem to " << newfs);
+    DirIndex::invalidate_all();
     if (localfs_format(newfs)) {
         return Error::FsFailedFormat;
     }
@@ -590,6 +673,89 @@ static Error showSDStatus(const char* parameter, AuthenticationLevel auth_level,
     return Error::Ok;
 }
 
+// Measures sequential write and read speed and random read latency by
+// writing and reading back a scratch file, by default 1 MB long
+static Error benchSD(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
+    uint32_t kbytes = 1024;
+    if (parameter && *parameter) {
+        auto [ptr, ec] = std::from_chars(parameter, parameter + strlen(parameter), kbytes);
+        if (ec != std::errc() || *ptr || kbytes == 0 || kbytes > 65536) {
+            log_error_to(out, "Size must be 1 to 65536 KB");
+            return Error::InvalidValue;
+        }
+    }
+
+    const char*          name = "/sd/.bench.tmp";
+    const size_t         size = kbytes * 1024;
+    std::vector<uint8_t> buf(4096);
+    for (size_t i = 0; i < buf.size(); i++) {
+        buf[i] = i;
+    }
+
+    try {
+        FluidPath mounted { "", sdName };  // Keep the card mounted between phases
+
+        uint32_t start   = xTaskGetTickCount();
+        bool     written = true;
+        {
+            FileStream file { name, "w" };
+            for (size_t done = 0; written && done < size; done += buf.size()) {
+                written = file.write(buf.data(), buf.size()) == buf.size();
+            }
+        }
+        if (!written) {
+            std::error_code ec;
+            stdfs::remove(FluidPath { name, "" }, ec);
+            log_error_to(out, "Cannot write " << kbytes << " KB to " << name);
+            return Error::FsFailedCreateFile;
+        }
+        uint32_t writeMs = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+
+        start = xTaskGetTickCount();
+        {
+            FileStream file { name, "r" };
+            while (file.read(reinterpret_cast<char*>(buf.data()), buf.size()) > 0) {}
+        }
+        uint32_t readMs = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+
+        // Each read lands on a different sector so none are satisfied from the buffer
+        const int reads    = 32;
+        uint32_t  totalUs  = 0;
+        uint32_t  maxUs    = 0;
+        uint32_t  position = 0;
+        {
+            FileStream file { name, "r" };
+            for (int i = 0; i < reads; i++) {
+                position = (position * 1103515245 + 12345) % (size / 512);
+                int32_t t0 = getCpuTicks();
+                file.set_position(position * 512);
+                file.read(reinterpret_cast<char*>(buf.data()), 512);
+                uint32_t us = (getCpuTicks() - t0) / ticks_per_us;
+                totalUs += us;
+                maxUs = std::max(maxUs, us);
+            }
+        }
+
+        std::error_code ec;
+        stdfs::remove(FluidPath { name, "" }, ec);
+        DirIndex::invalidate(FluidPath { name, "" });
+
+        // Bytes per millisecond / 1000 is MB/s
+        float writeRate = writeMs ? size / 1000.0f / writeMs : 0.0f;
+        float readRate  = readMs ? size / 1000.0f / readMs : 0.0f;
+        log_info_to(out, "SD clock " << sd_clock_hz() / 1000 << " kHz, " << kbytes << " KB");
+        log_info_to(out, "SD write " << setprecision(2) << writeRate << " MB/s read " << setprecision(2) << readRate << " MB/s");
+        log_info_to(out, "SD read latency avg " << totalUs / reads << " us max " << maxUs << " us");
+    } catch (std::filesystem::filesystem_error const& ex) {
+        log_error_to(out, ex.what());
+        return Error::FsFailedMount;
+    } catch (const Error err) {
+        log_error_to(out, "Cannot create " << name);
+        return err;
+    }
+    return Error::Ok;
+}
+
 static Error xmodem_receive(const char* value, AuthenticationLevel auth_level, Channel& out) {
     if (!value || !*value) {
         value = "uploaded";
@@ -670,11 +836,13 @@ void make_file_commands() {
     new WebCommand("path", WEBCMD, WU, NULL, "File/ShowHash", fileShowHash);
     new WebCommand("path", WEBCMD, WU, "ESP221", "SD/Show", showSDFile);
     new WebCommand("path", WEBCMD, WU, "ESP220", "SD/Run", runSDFile, nullptr);
+    new WebCommand("path", WEBCMD, WU, NULL, "SD/Scan", scanSDFile);
     new WebCommand("file_or_directory_path", WEBCMD, WU, "ESP215", "SD/Delete", deleteSDObject);
     new WebCommand("path", WEBCMD, WU, NULL, "SD/Rename", renameSDObject);
     new WebCommand(NULL, WEBCMD, WU, "ESP210", "SD/List", listSDFiles);
     new WebCommand("path", WEBCMD, WU, NULL, "SD/ListJSON", listSDFilesJSON);
     new WebCommand(NULL, WEBCMD, WU, "ESP200", "SD/Status", showSDStatus);
+    new WebCommand("kbytes", WEBCMD, WU, NULL, "SD/Bench", benchSD);
     new WebCommand("path", WEBCMD, WU, NULL, "Files/ListGCode", listGCodeFiles);
     new UserCommand("XR", "Xmodem/Receive", xmodem_receive, allowConfigStates);
     new UserCommand("XS", "Xmodem/Send", xmodem_send, notIdleOrAlarm);
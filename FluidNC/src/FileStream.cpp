@@ -3,6 +3,9 @@
 
 #include "FileStream.h"
 #include "Machine/MachineConfig.h"  // config->
+#include "DirIndex.h"
+
+#include <cstring>
 
 std::string FileStream::path() {
     return _fpath.c_str();
@@ -56,6 +59,7 @@ void FileStream::setup(const char* mode) {
         log_verbose("Cannot " << (opening ? "open" : "create") << " file " << _fpath.c_str());
         throw opening ? Error::FsFailedOpenFile : Error::FsFailedCreateFile;
     }
+    setvbuf(_fd, nullptr, _IOFBF, bufferSize);
     _size = stdfs::file_size(_fpath);
 }
 
@@ -81,6 +85,7 @@ void FileStream::save() {
 void FileStream::restore() {
     _fd = fopen(_fpath.c_str(), _mode);
     if (_fd) {
+        setvbuf(_fd, nullptr, _IOFBF, bufferSize);
         fseek(_fd, _saved_position, SEEK_SET);
     } else {
         // XXX need to unwind the job stack somehow
@@ -90,5 +95,8 @@ void FileStream::restore() {
 FileStream::~FileStream() {
     if (_fd) {
         fclose(_fd);
+        if (strpbrk(_mode, "wa+")) {
+            DirIndex::invalidate(_fpath);
+        }
     }
 }
@@ -28,6 +28,10 @@ class FileStream : public Channel {
     long        _saved_position;  // Used when the
     const char* _mode;
 
+    // A stdio buffer of several sectors lets FATFS move data with
+    // multi-block SD transfers instead of one sector at a time
+    static const size_t bufferSize = 4096;
+
     void setup(const char* mode);
 
 public:
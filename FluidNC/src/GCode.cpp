@@ -13,6 +13,7 @@
 #include "Protocol.h"             // protocol_buffer_synchronize
 #include "MotionControl.h"        // mc_override_ctrl_update
 #include "Machine/UserOutputs.h"  // setAnalogPercent
+#include "SyncActions.h"          // sync_action_queue
 #include "Platform.h"             // WEAK_LINK
 #include "Job.h"                  // Job::active() and Job::channel()
 
@@ -49,6 +50,7 @@ gc_modal_t modal_defaults = {
     // CutterCompensation::Disable,
     ToolLengthOffset::Cancel,
     CoordIndex::G54,
+    ControlMode::ExactPath,
     ProgramFlow::Running,
     {}, // 0, // CoolantState::M7,
     SpindleState::Disable,
@@ -69,6 +71,7 @@ void gc_init() {
     gc_state.modal          = modal_defaults;
     gc_state.modal.override = config->_start->_deactivateParking ? Override::Disabled : Override::ParkingMotion;
     coords[gc_state.modal.coord_select]->get(gc_state.coord_system);
+    gc_state.path_tolerance = config->_junctionDeviation;
     flowcontrol_init();
 }
 
@@ -224,6 +227,23 @@ void gc_wco_changed() {
     allChannels.notifyWco();
 }
 
+// Queues a synchronized output change to take effect when the motion that
+// is already buffered has been executed, so the planner does not have to
+// drain.  Returns false if the caller should perform the change now, either
+// because no motion is pending or because the queue was full and the motion
+// has been run to completion instead.
+static bool queue_sync_action(SyncActionType type, int io_num, float value) {
+    mc_flush_filters();
+    if (!plan_get_current_block() && !state_is(State::Cycle) && !sync_action_pending()) {
+        return false;
+    }
+    if (sync_action_queue(type, io_num, value)) {
+        return true;
+    }
+    protocol_buffer_synchronize();
+    return false;
+}
+
 // Executes one line of NUL-terminated G-Code.
 // The line may contain whitespace and comments, which are first removed,
 // and lower case characters, which are converted to upper case.
@@ -574,8 +594,12 @@ Error gc_execute_line(char* line) {
                         if (mantissa != 0) {
                             FAIL(Error::GcodeUnsupportedCommand);  // [G61.1 not supported]
                         }
-                        // gc_block.modal.control = ControlMode::ExactPath; // G61
-                        mg_word_bit = ModalGroup::MG13;
+                        gc_block.modal.control = ControlMode::ExactPath;  // G61
+                        mg_word_bit            = ModalGroup::MG13;
+                        break;
+                    case 64:
+                        gc_block.modal.control = ControlMode::Continuous;  // G64
+                        mg_word_bit            = ModalGroup::MG13;
                         break;
                     default:
                         FAIL(Error::GcodeUnsupportedCommand);  // [Unsupported G command]
@@ -1071,7 +1095,16 @@ Error gc_execute_line(char* line) {
             coords[gc_block.modal.coord_select]->get(block_coord_system);
         }
     }
-    // [16. Set path control mode ]: N/A. Only G61. G61.1 and G64 NOT SUPPORTED.
+    // [16. Set path control mode ]: G61.1 NOT SUPPORTED. The P word of G64 is the path tolerance.
+    float path_tolerance = gc_state.path_tolerance;
+    if (bitnum_is_true(command_words, ModalGroup::MG13) && gc_block.modal.control == ControlMode::Continuous &&
+        bitnum_is_true(value_words, GCodeWord::P)) {
+        path_tolerance = gc_block.values.p;
+        if (gc_block.modal.units == Units::Inches) {
+            path_tolerance *= MM_PER_INCH;
+        }
+        clear_bitnum(value_words, GCodeWord::P);
+    }
     // [17. Set distance mode ]: N/A. Only G91.1. G90.1 NOT SUPPORTED.
     // [18. Set retract mode ]: NOT SUPPORTED.
     // [19. Remaining non-modal actions ]: Check go to predefined position, set G10, or set axis offsets.
@@ -1628,11 +1661,15 @@ Error gc_execute_line(char* line) {
     if ((gc_block.modal.io_control == IoControl::DigitalOnSync) || (gc_block.modal.io_control == IoControl::DigitalOffSync) ||
         (gc_block.modal.io_control == IoControl::DigitalOnImmediate) || (gc_block.modal.io_control == IoControl::DigitalOffImmediate)) {
         if (gc_block.values.p < MaxUserDigitalPin) {
-            if ((gc_block.modal.io_control == IoControl::DigitalOnSync) || (gc_block.modal.io_control == IoControl::DigitalOffSync)) {
-                protocol_buffer_synchronize();
-            }
             bool turnOn = gc_block.modal.io_control == IoControl::DigitalOnSync || gc_block.modal.io_control == IoControl::DigitalOnImmediate;
-            if (!config->_userOutputs->setDigital((int)gc_block.values.p, turnOn)) {
+            if ((gc_block.modal.io_control == IoControl::DigitalOnSync) || (gc_block.modal.io_control == IoControl::DigitalOffSync)) {
+                if (!config->_userOutputs->canSetDigital((int)gc_block.values.p, turnOn)) {
+                    FAIL(Error::PParamMaxExceeded);
+                }
+                if (!queue_sync_action(SyncActionType::Digital, (int)gc_block.values.p, turnOn)) {
+                    config->_userOutputs->setDigital((int)gc_block.values.p, turnOn);
+                }
+            } else if (!config->_userOutputs->setDigital((int)gc_block.values.p, turnOn)) {
                 FAIL(Error::PParamMaxExceeded);
             }
         } else {
@@ -1647,9 +1684,13 @@ Error gc_execute_line(char* line) {
                 gc_block.values.q = 100.0f;
             }
             if (gc_block.modal.io_control == IoControl::SetAnalogSync) {
-                protocol_buffer_synchronize();
-            }
-            if (!config->_userOutputs->setAnalogPercent((int)gc_block.values.e, gc_block.values.q)) {
+                if (!config->_userOutputs->canSetAnalog((int)gc_block.values.e, gc_block.values.q)) {
+                    FAIL(Error::PParamMaxExceeded);
+                }
+                if (!queue_sync_action(SyncActionType::Analog, (int)gc_block.values.e, gc_block.values.q)) {
+                    config->_userOutputs->setAnalogPercent((int)gc_block.values.e, gc_block.values.q);
+                }
+            } else if (!config->_userOutputs->setAnalogPercent((int)gc_block.values.e, gc_block.values.q)) {
                 FAIL(Error::PParamMaxExceeded);
             }
         } else {
@@ -1695,8 +1736,9 @@ Error gc_execute_line(char* line) {
         copyAxes(gc_state.coord_system, block_coord_system);
         gc_wco_changed();
     }
-    // [16. Set path control mode ]: G61.1/G64 NOT SUPPORTED
-    // gc_state.modal.control = gc_block.modal.control; // NOTE: Always default.
+    // [16. Set path control mode ]: G61.1 NOT SUPPORTED
+    gc_state.modal.control  = gc_block.modal.control;
+    gc_state.path_tolerance = path_tolerance;
     // [17. Set distance mode ]:
     gc_state.modal.distance = gc_block.modal.distance;
     // [18. Set retract mode ]: NOT SUPPORTED
@@ -1750,7 +1792,8 @@ Error gc_execute_line(char* line) {
         if (axis_command == AxisCommand::MotionMode) {
             GCUpdatePos gc_update_pos = GCUpdatePos::Target;
             if (gc_state.modal.motion == Motion::Linear) {
-                mc_linear(gc_block.values.xyz, pl_data, gc_state.position);
+                float tolerance = gc_state.modal.control == ControlMode::Continuous ? gc_state.path_tolerance : 0;
+                mc_linear_filtered(gc_block.values.xyz, pl_data, gc_state.position, tolerance);
             } else if (gc_state.modal.motion == Motion::Seek) {
                 pl_data->motion.rapidMotion = 1;  // Set rapid motion flag.
                 mc_linear(gc_block.values.xyz, pl_data, gc_state.position);
@@ -128,7 +128,8 @@ enum class CutterCompensation : gcodenum_t {
 
 // Modal Group G13: Control mode
 enum class ControlMode : gcodenum_t {
-    ExactPath = 610,  // G61
+    ExactPath  = 610,  // G61 Default
+    Continuous = 640,  // G64
 };
 
 // GCodeCoolant is used by the parser, where at most one of
@@ -255,7 +256,7 @@ struct gc_modal_t {
     // CutterCompensation cutter_comp;  // {G40} NOTE: Don't track. Only default supported.
     ToolLengthOffset tool_length;   // {G43.1,G49}
     CoordIndex       coord_select;  // {G54,G55,G56,G57,G58,G59}
-    // uint8_t control;      // {G61} NOTE: Don't track. Only default supported.
+    ControlMode      control;       // {G61,G64}
     ProgramFlow   program_flow;  // {M0,M1,M2,M30}
     CoolantState  coolant;       // {M7,M8,M9}
     SpindleState  spindle;       // {M3,M4,M5}
@@ -296,6 +297,7 @@ struct parser_state_t {
     float coord_offset[MAX_N_AXIS];  // Retains the G92 coordinate offset (work coordinates) relative to
     // machine zero in mm. Non-persistent. Cleared upon reset and boot.
     float tool_length_offset;  // Tracks tool length offset value when enabled.
+    float path_tolerance;      // G64 P corner rounding tolerance in mm
     bool  skip_blocks;         // Skipping due to flow control
 };
 
@@ -0,0 +1,133 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "HeightMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+HeightMap heightMap;
+
+bool HeightMap::setup(float x0, float y0, float x1, float y1, size_t nx, size_t ny) {
+    clear();
+    if (nx < MIN_SIDE || nx > MAX_SIDE || ny < MIN_SIDE || ny > MAX_SIDE || x0 == x1 || y0 == y1) {
+        return false;
+    }
+    _x0 = x0;
+    _y0 = y0;
+    _dx = (x1 - x0) / (nx - 1);
+    _dy = (y1 - y0) / (ny - 1);
+    _nx = nx;
+    _ny = ny;
+    _z.assign(nx * ny, NAN);
+    return true;
+}
+
+void HeightMap::clear() {
+    _nx       = 0;
+    _ny       = 0;
+    _measured = 0;
+    _enabled  = false;
+    _z.clear();
+}
+
+void HeightMap::point(size_t n, size_t& i, size_t& j) const {
+    j = n / _nx;
+    i = n % _nx;
+    if (j & 1) {
+        i = _nx - 1 - i;
+    }
+}
+
+void HeightMap::set(size_t i, size_t j, float z) {
+    float& cell = _z[j * _nx + i];
+    if (std::isnan(cell)) {
+        ++_measured;
+    }
+    cell = z;
+}
+
+// Position of v along a grid axis as a cell index and a fraction of a cell.
+// Positions outside the grid are clamped to the edge.
+static void locate(float v, float v0, float dv, size_t n, size_t& index, float& frac) {
+    float f = (v - v0) / dv;
+    f       = std::min(std::max(f, 0.0f), float(n - 1));
+    index   = std::min(size_t(f), n - 2);
+    frac    = f - index;
+}
+
+float HeightMap::offset(float x, float y) const {
+    if (!valid()) {
+        return 0.0f;
+    }
+    size_t i, j;
+    float  tx, ty;
+    locate(x, _x0, _dx, _nx, i, tx);
+    locate(y, _y0, _dy, _ny, j, ty);
+
+    float z0 = z(i, j) + (z(i + 1, j) - z(i, j)) * tx;
+    float z1 = z(i, j + 1) + (z(i + 1, j + 1) - z(i, j + 1)) * tx;
+    return z0 + (z1 - z0) * ty - _z[0];
+}
+
+size_t HeightMap::segments(float x0, float y0, float x1, float y1) const {
+    if (!valid()) {
+        return 1;
+    }
+    float step = std::min(std::fabs(_dx), std::fabs(_dy)) / 2;
+    float dist = std::hypot(x1 - x0, y1 - y0);
+    return std::max(size_t(std::ceil(dist / step)), size_t(1));
+}
+
+std::string HeightMap::serialize() const {
+    std::string text;
+    char        buf[64];
+    snprintf(buf, sizeof(buf), "heightmap %.3f %.3f %.3f %.3f %u %u\n", _x0, _y0, x(_nx - 1), y(_ny - 1), unsigned(_nx), unsigned(_ny));
+    text += buf;
+    for (size_t j = 0; j < _ny; j++) {
+        for (size_t i = 0; i < _nx; i++) {
+            snprintf(buf, sizeof(buf), i ? " %.4f" : "%.4f", z(i, j));
+            text += buf;
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+bool HeightMap::parse(const std::string& text) {
+    const char* p   = text.c_str();
+    const char* tag = "heightmap";
+    if (strncmp(p, tag, strlen(tag))) {
+        return false;
+    }
+    p += strlen(tag);
+
+    float header[6];
+    for (auto& v : header) {
+        char* end;
+        v = strtof(p, &end);
+        if (end == p) {
+            return false;
+        }
+        p = end;
+    }
+    if (header[4] < MIN_SIDE || header[5] < MIN_SIDE || !setup(header[0], header[1], header[2], header[3], size_t(header[4]), size_t(header[5]))) {
+        return false;
+    }
+    for (size_t j = 0; j < _ny; j++) {
+        for (size_t i = 0; i < _nx; i++) {
+            char* end;
+            float v = strtof(p, &end);
+            if (end == p) {
+                clear();
+                return false;
+            }
+            set(i, j, v);
+            p = end;
+        }
+    }
+    return true;
+}
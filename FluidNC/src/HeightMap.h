@@ -0,0 +1,72 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A grid of probed surface heights used to compensate Z for a workpiece
+// or bed that is not flat or not square to the machine.
+//
+// The grid is in machine X/Y coordinates.  offset() returns the bilinear
+// interpolation of the measured heights, relative to the height at the
+// first probed point (the grid origin), so a work Z zero that was set at
+// the origin stays valid.  Outside the grid the nearest edge value is used.
+//
+// The kinematics wrapper applies the offset and
+// mc_probe_grid() fills in the heights.
+
+class HeightMap {
+    float              _x0 = 0;
+    float              _y0 = 0;
+    float              _dx = 0;
+    float              _dy = 0;
+    size_t             _nx = 0;
+    size_t             _ny = 0;
+    std::vector<float> _z;
+    size_t             _measured = 0;
+    bool               _enabled  = false;
+
+public:
+    static const size_t MIN_SIDE = 2;
+    static const size_t MAX_SIDE = 32;
+
+    // Define a new grid with corners (x0,y0) and (x1,y1), discarding any
+    // previous heights.  Returns false if the grid is degenerate.
+    bool setup(float x0, float y0, float x1, float y1, size_t nx, size_t ny);
+    void clear();
+
+    size_t nx() const { return _nx; }
+    size_t ny() const { return _ny; }
+    size_t points() const { return _nx * _ny; }
+    float  x(size_t i) const { return _x0 + i * _dx; }
+    float  y(size_t j) const { return _y0 + j * _dy; }
+    float  z(size_t i, size_t j) const { return _z[j * _nx + i]; }
+
+    // The n'th point of a serpentine probe sequence: rows are visited in
+    // order and alternate direction, so each move is a single grid step
+    void point(size_t n, size_t& i, size_t& j) const;
+
+    // The map becomes valid when every point has been set
+    void set(size_t i, size_t j, float z);
+
+    bool valid() const { return _nx && _measured == points(); }
+    bool active() const { return _enabled && valid(); }
+    bool enabled() const { return _enabled; }
+    void enable(bool on) { _enabled = on; }
+
+    // Z correction at machine position x,y
+    float offset(float x, float y) const;
+
+    // Number of pieces a move from (x0,y0) to (x1,y1) must be split into
+    // so that no piece spans more than half a grid cell
+    size_t segments(float x0, float y0, float x1, float y1) const;
+
+    // Text form used by $HeightMap/Save and $HeightMap/Load
+    std::string serialize() const;
+    bool        parse(const std::string& text);
+};
+
+extern HeightMap heightMap;
@@ -0,0 +1,121 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "I2SOStreamModel.h"
+
+#include <cstddef>
+#include <vector>
+
+I2SOStreamModel::I2SOStreamModel(uint32_t dmabuf_count, uint32_t dmabuf_len, uint32_t usec_per_sample) :
+    _dmabuf_count(dmabuf_count), _sample_count(dmabuf_len / sizeof(uint32_t)), _safe_count(20 / usec_per_sample),
+    _usec_per_sample(usec_per_sample) {}
+
+I2SOStreamModel::Result I2SOStreamModel::run(
+    uint32_t step_rate, uint32_t n_axes, uint32_t pulse_us, uint32_t duration_ms, const Costs& costs) const {
+    Result result;
+    if (step_rate == 0 || _dmabuf_count < 2) {
+        return result;
+    }
+
+    const float period_us  = 1000000.0f / step_rate;
+    const float pulse_cost = costs.pulse_base_us + costs.pulse_per_axis_us * n_axes;
+    const float end_us     = duration_ms * 1000.0f;
+
+    // Samples pushed by one pulse_func() call, as in i2s_out_push_sample()
+    uint32_t pulse_samples = pulse_us / _usec_per_sample;
+    if (pulse_samples == 0) {
+        pulse_samples = 1;
+    }
+
+    // play_end[i] is the time when the i'th buffer played by the DMA engine
+    // finishes.  The buffers initially hold idle samples.
+    std::vector<float> play_end;
+    float              t = 0;
+    for (uint32_t i = 0; i < _dmabuf_count; i++) {
+        t += _sample_count * _usec_per_sample;
+        play_end.push_back(t);
+    }
+
+    float producer_free = 0;
+    float busy_us       = 0;
+    float remain_us     = 0;  // i2s_out_remain_time_until_next_pulse
+
+    for (size_t released = 0; play_end[released] < end_us; released++) {
+        // The generator task wakes when the DMA engine releases a buffer
+        float start = play_end[released] > producer_free ? play_end[released] : producer_free;
+
+        // Replay the fill loop of i2s_fillout_dma_buffer()
+        uint32_t rw_pos = 0;
+        float    cost   = 0;
+        while (rw_pos < (_sample_count - _safe_count)) {
+            if (remain_us < _usec_per_sample) {
+                rw_pos += pulse_samples;
+                cost += pulse_cost;
+                ++result.steps;
+
+                // The pulse needs at least one idle sample after it so the
+                // step pin goes low before the next pulse
+                float used = float(pulse_samples * _usec_per_sample);
+                if (used + _usec_per_sample > period_us) {
+                    ++result.overlong;
+                    remain_us = 0;
+                } else {
+                    remain_us += period_us - used;
+                }
+                continue;
+            }
+            rw_pos++;
+            cost += costs.sample_us;
+            remain_us -= _usec_per_sample;
+        }
+
+        float done = start + cost;
+        busy_us += cost;
+        producer_free = done;
+        ++result.buffers;
+
+        float refill_us = done - play_end[released];
+        if (refill_us > result.max_refill_us) {
+            result.max_refill_us = refill_us;
+        }
+
+        // The refilled buffer plays after the other buffers in the ring.
+        // If it is not ready by then, the stream has a gap.
+        float play_start = play_end.back();
+        if (done > play_start) {
+            ++result.underruns;
+            play_start = done;
+        }
+        play_end.push_back(play_start + rw_pos * _usec_per_sample);
+    }
+
+    // The primed idle buffers do not count toward the achieved rate
+    float stepping_us = play_end.back() - play_end[_dmabuf_count - 1];
+    if (stepping_us > 0) {
+        result.cpu_load  = busy_us / stepping_us;
+        result.step_rate = result.steps * 1000000.0f / stepping_us;
+    }
+    return result;
+}
+
+uint32_t I2SOStreamModel::max_step_rate(uint32_t n_axes, uint32_t pulse_us, uint32_t duration_ms, const Costs& costs) const {
+    auto sustainable = [&](uint32_t rate) {
+        auto r = run(rate, n_axes, pulse_us, duration_ms, costs);
+        // A run that is too short can hide a producer that is slowly
+        // falling behind, so also require spare CPU time
+        return r.underruns == 0 && r.overlong == 0 && r.cpu_load < 1.0f && r.step_rate >= rate * 0.99f;
+    };
+
+    // The sample clock is the absolute upper bound
+    uint32_t lo = 0;
+    uint32_t hi = 1000000 / _usec_per_sample;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        if (sustainable(mid)) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
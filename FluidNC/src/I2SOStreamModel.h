@@ -0,0 +1,54 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+
+// Host-side model of the I2S_STREAM bitstream generator in I2SOut.cpp.
+//
+// The generator task refills each DMA buffer as soon as the DMA engine
+// releases it, calling Stepper::pulse_func() whenever the time until the
+// next pulse has elapsed.  The refill must finish before the DMA engine
+// comes back around the ring to that buffer, otherwise the I2S ISR sees
+// an underrun.  This model replays that loop with configurable CPU costs
+// so the maximum sustainable step rate can be estimated on a PC for a
+// given DMA buffer layout, axis count and pulse width.  It has no
+// hardware dependencies so it can be built by the native unit tests.
+
+class I2SOStreamModel {
+public:
+    // CPU time estimates, in microseconds.  The defaults are rough
+    // placeholders; calibrate them with the refill times that
+    // $I2SO/Stats reports on real hardware.
+    struct Costs {
+        float pulse_base_us     = 3.0f;   // One pulse_func() call, excluding per-axis work
+        float pulse_per_axis_us = 0.4f;   // Bresenham and pin work per axis per call
+        float sample_us         = 0.02f;  // Storing one idle sample
+    };
+
+    struct Result {
+        uint32_t steps         = 0;  // pulse_func() calls
+        uint32_t buffers       = 0;  // DMA buffers refilled
+        uint32_t underruns     = 0;  // Refills that finished after the DMA needed the buffer
+        uint32_t overlong      = 0;  // Pulses that left no idle sample before the next pulse
+        float    max_refill_us = 0;  // Longest time from buffer release to refill complete
+        float    cpu_load      = 0;  // Fraction of time the generator task was busy
+        float    step_rate     = 0;  // Achieved pulse_func() rate in Hz
+    };
+
+    I2SOStreamModel(uint32_t dmabuf_count, uint32_t dmabuf_len, uint32_t usec_per_sample = 4);
+
+    // Simulate stepping at step_rate for duration_ms
+    Result run(uint32_t step_rate, uint32_t n_axes, uint32_t pulse_us, uint32_t duration_ms, const Costs& costs) const;
+
+    // Highest step rate that runs for duration_ms with no underruns, spare
+    // CPU time, and an achieved rate within 1% of the requested rate
+    uint32_t max_step_rate(uint32_t n_axes, uint32_t pulse_us, uint32_t duration_ms, const Costs& costs) const;
+
+private:
+    uint32_t _dmabuf_count;
+    uint32_t _sample_count;  // samples per DMA buffer
+    uint32_t _safe_count;    // margin kept free so a pulse never spans two buffers
+    uint32_t _usec_per_sample;
+};
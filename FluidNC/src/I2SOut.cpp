@@ -37,6 +37,10 @@ int i2s_out_reset() {
 int i2s_out_init() {
     return -1;
 }
+void i2s_out_get_stats(i2s_out_stats_t& stats) {
+    stats = {};
+}
+void i2s_out_clear_stats() {}
 #else
 #    include "Config.h"
 #    include "Pin.h"
@@ -54,6 +58,7 @@ int i2s_out_init() {
 #    include <freertos/queue.h>
 #    include <soc/gpio_periph.h>
 #    include "Driver/fluidnc_gpio.h"
+#    include "Driver/delay_usecs.h"  // getCpuTicks()
 
 // The <atomic> library routines are not in IRAM so they can crash when called from FLASH
 // The GCC intrinsic versions which are prefixed with __ are compiled inline
@@ -80,22 +85,33 @@ static std::atomic<std::uint32_t> i2s_out_port_data = ATOMIC_VAR_INIT(0);
 //
 // Configrations for DMA connected I2S
 //
-// One DMA buffer transfer takes about 2 ms
-//   I2S_OUT_DMABUF_LEN / I2S_SAMPLE_SIZE x I2S_OUT_USEC_PER_PULSE
+// With the default layout, one DMA buffer transfer takes about 2 ms
+//   dmabuf_len / I2S_SAMPLE_SIZE x I2S_OUT_USEC_PER_PULSE
 //   = 2000 / 4 x 4
 //   = 2000us = 2ms
-// If I2S_OUT_DMABUF_COUNT is 5, it will take about 10 ms for all the DMA buffer transfers to finish.
+// If dmabuf_count is 5, it will take about 10 ms for all the DMA buffer transfers to finish.
 //
-// Increasing I2S_OUT_DMABUF_COUNT has the effect of preventing buffer underflow,
+// Increasing dmabuf_count has the effect of preventing buffer underflow,
 // but on the other hand, it leads to a delay with pulse and/or non-pulse-generated I/Os.
-// The number of I2S_OUT_DMABUF_COUNT should be chosen carefully.
+// The number of buffers should be chosen carefully; $I2SO/Stats shows whether
+// the refills are keeping up.
 //
 // Reference information:
 //   FreeRTOS task time slice = portTICK_PERIOD_MS = 1 ms (ESP32 FreeRTOS port)
 //
-const int I2S_SAMPLE_SIZE   = 4;                                    /* 4 bytes, 32 bits per sample */
-const int DMA_SAMPLE_COUNT  = I2S_OUT_DMABUF_LEN / I2S_SAMPLE_SIZE; /* number of samples per buffer */
-const int SAMPLE_SAFE_COUNT = (20 / I2S_OUT_USEC_PER_PULSE);        /* prevent buffer overrun ($0 should be less than or equal 20) */
+const int I2S_SAMPLE_SIZE   = 4;                              /* 4 bytes, 32 bits per sample */
+const int SAMPLE_SAFE_COUNT = (20 / I2S_OUT_USEC_PER_PULSE);  /* prevent buffer overrun ($0 should be less than or equal 20) */
+
+static uint32_t dmabuf_count     = I2S_OUT_DMABUF_COUNT;
+static uint32_t dmabuf_len       = I2S_OUT_DMABUF_LEN;                   /* bytes per buffer */
+static uint32_t dma_sample_count = I2S_OUT_DMABUF_LEN / I2S_SAMPLE_SIZE; /* number of samples per buffer */
+static uint32_t delay_dmabuf_ms  = 2;                                    /* time to play one buffer, rounded up */
+
+// Stream statistics
+static volatile uint32_t stat_underruns  = 0;
+static uint32_t          stat_refills    = 0;
+static uint32_t          stat_refill_max = 0;  // CPU ticks
+static uint64_t          stat_refill_sum = 0;  // CPU ticks
 
 typedef struct {
     uint32_t**   buffers;
@@ -190,26 +206,26 @@ static inline void i2s_out_reset_fifo_without_lock() {
 
 static int i2s_clear_dma_buffer(lldesc_t* dma_desc, uint32_t port_data) {
     uint32_t* buf = (uint32_t*)dma_desc->buf;
-    for (int i = 0; i < DMA_SAMPLE_COUNT; i++) {
+    for (uint32_t i = 0; i < dma_sample_count; i++) {
         buf[i] = port_data;
     }
     // Restore the buffer length.
     // The length may have been changed short when the data was filled in to prevent buffer overrun.
-    dma_desc->length = I2S_OUT_DMABUF_LEN;
+    dma_desc->length = dmabuf_len;
     return 0;
 }
 
 static int i2s_clear_o_dma_buffers(uint32_t port_data) {
-    for (int buf_idx = 0; buf_idx < I2S_OUT_DMABUF_COUNT; buf_idx++) {
+    for (uint32_t buf_idx = 0; buf_idx < dmabuf_count; buf_idx++) {
         // Initialize DMA descriptor
         o_dma.desc[buf_idx]->owner        = 1;
         o_dma.desc[buf_idx]->eof          = 1;  // set to 1 will trigger the interrupt
         o_dma.desc[buf_idx]->sosf         = 0;
-        o_dma.desc[buf_idx]->length       = I2S_OUT_DMABUF_LEN;
-        o_dma.desc[buf_idx]->size         = I2S_OUT_DMABUF_LEN;
+        o_dma.desc[buf_idx]->length       = dmabuf_len;
+        o_dma.desc[buf_idx]->size         = dmabuf_len;
         o_dma.desc[buf_idx]->buf          = (uint8_t*)o_dma.buffers[buf_idx];
         o_dma.desc[buf_idx]->offset       = 0;
-        o_dma.desc[buf_idx]->qe.stqe_next = (lldesc_t*)((buf_idx < (I2S_OUT_DMABUF_COUNT - 1)) ? (o_dma.desc[buf_idx + 1]) : o_dma.desc[0]);
+        o_dma.desc[buf_idx]->qe.stqe_next = (lldesc_t*)((buf_idx < (dmabuf_count - 1)) ? (o_dma.desc[buf_idx + 1]) : o_dma.desc[0]);
         i2s_clear_dma_buffer(o_dma.desc[buf_idx], port_data);
     }
     return 0;
@@ -355,7 +371,7 @@ static int i2s_fillout_dma_buffer(lldesc_t* dma_desc) {
         // and the pulse generation is postponed until the next buffer is filled.
         //
         o_dma.rw_pos = 0;
-        while (o_dma.rw_pos < (DMA_SAMPLE_COUNT - SAMPLE_SAFE_COUNT)) {
+        while (o_dma.rw_pos < (dma_sample_count - SAMPLE_SAFE_COUNT)) {
             // no data to read (buffer empty)
             if (i2s_out_remain_time_until_next_pulse < I2S_OUT_USEC_PER_PULSE) {
                 // pulser status may change in pulse phase func, so I need to check it every time.
@@ -379,7 +395,7 @@ static int i2s_fillout_dma_buffer(lldesc_t* dma_desc) {
                         // To prevent the pulse function from being called back,
                         // we assume that the buffer is already full.
                         i2s_out_remain_time_until_next_pulse = 0;                 // There is no need to fill the current buffer.
-                        o_dma.rw_pos                         = DMA_SAMPLE_COUNT;  // The buffer is full.
+                        o_dma.rw_pos                         = dma_sample_count;  // The buffer is full.
                         break;
                     }
                     continue;
@@ -436,6 +452,7 @@ static void IRAM_ATTR i2s_out_intr_handler(void* arg) {
             lldesc_t* front_desc;
             // Remove a descriptor from the DMA complete event queue
             xQueueReceiveFromISR(o_dma.queue, &front_desc, &high_priority_task_awoken);
+            stat_underruns = stat_underruns + 1;
             I2S_OUT_PULSER_ENTER_CRITICAL_ISR();
             uint32_t port_data = 0;
             if (i2s_out_pulser_status == STEPPING) {
@@ -446,11 +463,11 @@ static void IRAM_ATTR i2s_out_intr_handler(void* arg) {
             // lldesc_t.buf is const for S2.  Perhaps we can get by
             // without replacing the data in the buffer since we are
             // already in an error situation.
-            for (int i = 0; i < DMA_SAMPLE_COUNT; i++) {
+            for (uint32_t i = 0; i < dma_sample_count; i++) {
                 front_desc->buf[i] = port_data;
             }
 #    endif
-            front_desc->length = I2S_OUT_DMABUF_LEN;
+            front_desc->length = dmabuf_len;
         }
 
         // Send a DMA complete event to the I2S bitstreamer task with finished buffer
@@ -489,8 +506,16 @@ static void i2sOutTask(void* parameter) {
             // the generation of the buffer is interrupted (the buffer length is shortened slightly)
             // and the pulse generation is postponed until the next buffer is filled.
             //
+            int32_t start_ticks = getCpuTicks();
             i2s_fillout_dma_buffer(dma_desc);
             dma_desc->length = o_dma.rw_pos * I2S_SAMPLE_SIZE;
+
+            uint32_t refill_ticks = getCpuTicks() - start_ticks;
+            stat_refill_sum += refill_ticks;
+            if (refill_ticks > stat_refill_max) {
+                stat_refill_max = refill_ticks;
+            }
+            ++stat_refills;
         } else if (i2s_out_pulser_status == WAITING) {
             if (dma_desc->qe.stqe_next == NULL) {
                 // Tail of the DMA descriptor found
@@ -536,7 +561,7 @@ void i2s_out_delay() {
         // Just wait until the data now registered in the DMA descripter
         // is reflected in the I2S TX module via FIFO.
         // XXX perhaps just wait until I2SO.conf1.tx_start == 0
-        delay_ms(I2S_OUT_DELAY_MS);
+        delay_ms(delay_dmabuf_ms * (dmabuf_count + 1));
     }
     I2S_OUT_PULSER_EXIT_CRITICAL();
 }
@@ -606,7 +631,7 @@ int i2s_out_set_stepping() {
         // Wait for complete DMAs
         for (;;) {
             I2S_OUT_PULSER_EXIT_CRITICAL();
-            delay_ms(I2S_OUT_DELAY_DMABUF_MS);
+            delay_ms(delay_dmabuf_ms);
             I2S_OUT_PULSER_ENTER_CRITICAL();
             if (i2s_out_pulser_status == WAITING) {
                 continue;
@@ -640,6 +665,31 @@ int IRAM_ATTR i2s_out_set_pulse_period(uint32_t period) {
     return 0;
 }
 
+void i2s_out_get_stats(i2s_out_stats_t& stats) {
+    // Snapshot under the lock so the 64-bit sum is not read half updated
+    I2S_OUT_PULSER_ENTER_CRITICAL();
+    uint32_t underruns  = stat_underruns;
+    uint32_t refills    = stat_refills;
+    uint32_t refill_max = stat_refill_max;
+    uint64_t refill_sum = stat_refill_sum;
+    I2S_OUT_PULSER_EXIT_CRITICAL();
+
+    stats.underruns     = underruns;
+    stats.refills       = refills;
+    stats.refill_max_us = refill_max / ticks_per_us;
+    stats.refill_avg_us = refills ? uint32_t(refill_sum / refills) / ticks_per_us : 0;
+    stats.buffer_us     = dma_sample_count * I2S_OUT_USEC_PER_PULSE;
+}
+
+void i2s_out_clear_stats() {
+    I2S_OUT_PULSER_ENTER_CRITICAL();
+    stat_underruns  = 0;
+    stat_refills    = 0;
+    stat_refill_max = 0;
+    stat_refill_sum = 0;
+    I2S_OUT_PULSER_EXIT_CRITICAL();
+}
+
 int i2s_out_reset() {
     I2S_OUT_PULSER_ENTER_CRITICAL();
     i2s_out_stop();
@@ -669,6 +719,11 @@ int i2s_out_init(i2s_out_init_t& init_param) {
 
     ATOMIC_STORE(&i2s_out_port_data, init_param.init_val);
 
+    dmabuf_count     = init_param.dmabuf_count;
+    dmabuf_len       = init_param.dmabuf_len & ~(I2S_SAMPLE_SIZE - 1);  // whole samples only
+    dma_sample_count = dmabuf_len / I2S_SAMPLE_SIZE;
+    delay_dmabuf_ms  = (dma_sample_count * I2S_OUT_USEC_PER_PULSE + 999) / 1000;
+
     // To make sure hardware is enabled before any hardware register operations.
     periph_module_reset(PERIPH_I2S0_MODULE);
     periph_module_enable(PERIPH_I2S0_MODULE);
@@ -702,27 +757,27 @@ int i2s_out_init(i2s_out_init_t& init_param) {
    */
 
     // Allocate the array of pointers to the buffers
-    o_dma.buffers = (uint32_t**)malloc(sizeof(uint32_t*) * I2S_OUT_DMABUF_COUNT);
+    o_dma.buffers = (uint32_t**)malloc(sizeof(uint32_t*) * dmabuf_count);
     if (o_dma.buffers == nullptr) {
         return -1;
     }
 
     // Allocate each buffer that can be used by the DMA controller
-    for (int buf_idx = 0; buf_idx < I2S_OUT_DMABUF_COUNT; buf_idx++) {
-        o_dma.buffers[buf_idx] = (uint32_t*)heap_caps_calloc(1, I2S_OUT_DMABUF_LEN, MALLOC_CAP_DMA);
+    for (uint32_t buf_idx = 0; buf_idx < dmabuf_count; buf_idx++) {
+        o_dma.buffers[buf_idx] = (uint32_t*)heap_caps_calloc(1, dmabuf_len, MALLOC_CAP_DMA);
         if (o_dma.buffers[buf_idx] == nullptr) {
             return -1;
         }
     }
 
     // Allocate the array of DMA descriptors
-    o_dma.desc = (lldesc_t**)malloc(sizeof(lldesc_t*) * I2S_OUT_DMABUF_COUNT);
+    o_dma.desc = (lldesc_t**)malloc(sizeof(lldesc_t*) * dmabuf_count);
     if (o_dma.desc == nullptr) {
         return -1;
     }
 
     // Allocate each DMA descriptor that will be used by the DMA controller
-    for (int buf_idx = 0; buf_idx < I2S_OUT_DMABUF_COUNT; buf_idx++) {
+    for (uint32_t buf_idx = 0; buf_idx < dmabuf_count; buf_idx++) {
         o_dma.desc[buf_idx] = (lldesc_t*)heap_caps_malloc(sizeof(lldesc_t), MALLOC_CAP_DMA);
         if (o_dma.desc[buf_idx] == nullptr) {
             return -1;
@@ -733,7 +788,7 @@ int i2s_out_init(i2s_out_init_t& init_param) {
     i2s_clear_o_dma_buffers(init_param.init_val);
     o_dma.rw_pos  = 0;
     o_dma.current = NULL;
-    o_dma.queue   = xQueueCreate(I2S_OUT_DMABUF_COUNT, sizeof(uint32_t*));
+    o_dma.queue   = xQueueCreate(dmabuf_count, sizeof(uint32_t*));
 
     // Set the first DMA descriptor
     I2S0.out_link.addr = (uint32_t)o_dma.desc[0];
@@ -935,6 +990,8 @@ int i2s_out_init() {
         default_param.data_pin     = dataPin.getNative(Pin::Capabilities::Output | Pin::Capabilities::Native);
         default_param.pulse_period = I2S_OUT_USEC_PER_PULSE;
         default_param.init_val     = I2S_OUT_INIT_VAL;
+        default_param.dmabuf_count = i2so->_dmaBufferCount;
+        default_param.dmabuf_len   = i2so->_dmaBufferBytes;
 
         return i2s_out_init(default_param);
     }
@@ -32,11 +32,14 @@ const uint32_t I2S_STREAM_MAX_USEC_PER_PULSE = 20;
 
 constexpr uint32_t i2s_out_max_steps_per_sec = 1000000 / (2 * I2S_OUT_USEC_PER_PULSE);
 
+// Defaults for the DMA buffer layout, which can be overridden by the i2so config section
 const int I2S_OUT_DMABUF_COUNT = 5;    /* number of DMA buffers to store data */
 const int I2S_OUT_DMABUF_LEN   = 2000; /* maximum size in bytes (4092 is DMA's limit) */
 
-const int I2S_OUT_DELAY_DMABUF_MS = (I2S_OUT_DMABUF_LEN / sizeof(uint32_t) * I2S_OUT_USEC_PER_PULSE / 1000);
-const int I2S_OUT_DELAY_MS        = (I2S_OUT_DELAY_DMABUF_MS * (I2S_OUT_DMABUF_COUNT + 1));
+const int I2S_OUT_DMABUF_COUNT_MIN = 2;
+const int I2S_OUT_DMABUF_COUNT_MAX = 16;
+const int I2S_OUT_DMABUF_LEN_MIN   = 400;
+const int I2S_OUT_DMABUF_LEN_MAX   = 4092;
 
 typedef struct {
     /*
@@ -57,8 +60,18 @@ typedef struct {
     pinnum_t data_pin;
     uint32_t pulse_period;  // aka step rate.
     uint32_t init_val;
+    uint32_t dmabuf_count;  // number of DMA buffers
+    uint32_t dmabuf_len;    // size of each DMA buffer in bytes
 } i2s_out_init_t;
 
+typedef struct {
+    uint32_t underruns;      // DMA buffers that were played again because the refill was late
+    uint32_t refills;        // DMA buffers filled with step data
+    uint32_t refill_max_us;  // Longest time to fill one buffer
+    uint32_t refill_avg_us;  // Average time to fill one buffer
+    uint32_t buffer_us;      // Play time of one full buffer
+} i2s_out_stats_t;
+
 /*
   Initialize I2S out by parameters.
   return -1 ... already initialized
@@ -150,6 +163,12 @@ i2s_out_pulser_status_t IRAM_ATTR i2s_out_get_pulser_status();
  */
 int i2s_out_reset();
 
+/*
+   Get the stream statistics collected since the last i2s_out_clear_stats()
+ */
+void i2s_out_get_stats(i2s_out_stats_t& stats);
+void i2s_out_clear_stats();
+
 /*
    Reference: "ESP32 Technical Reference Manual" by Espressif Systems
      https://www.espressif.com/sites/default/files/documentation/esp32_technical_reference_manual_en.pdf
@@ -4,8 +4,11 @@
 #include "InputFile.h"
 
 #include "Report.h"
+#include "JobScanner.h"
 
-InputFile::InputFile(const char* defaultFs, const char* path) : FileStream(path, "r", defaultFs) {}
+InputFile::InputFile(const char* defaultFs, const char* path) : FileStream(path, "r", defaultFs) {
+    _scanned = JobScanner::load(this->path(), _scan);
+}
 /*
   Read a line from the file
   Returns Error::Ok if a line was read, even if the line was empty.
@@ -51,6 +54,8 @@ void InputFile::end_message() {
     _progress = "SD: ";
     _progress += name();
     _progress += ": Sent";
+    _percent   = 100;
+    _remaining = -1;
 }
 
 Error InputFile::pollLine(char* line) {
@@ -69,6 +74,10 @@ Error InputFile::pollLine(char* line) {
     switch (auto err = readLine(line, Channel::maxLine)) {
         case Error::Ok: {
             float percent_complete = ((float)position()) * 100.0f / size();
+            _percent               = percent_complete;
+            if (_scanned) {
+                _remaining = _scan.seconds() - _scan.seconds_at(position());
+            }
 
             std::ostringstream s;
             s << "SD:" << std::fixed << std::setprecision(2) << percent_complete << "," << path().c_str();
@@ -79,7 +88,9 @@ Error InputFile::pollLine(char* line) {
             end_message();
             return Error::Eof;
         default:
-            _progress = "";
+            _progress  = "";
+            _percent   = -1;
+            _remaining = -1;
             return err;
     }
 }
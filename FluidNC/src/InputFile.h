@@ -16,13 +16,16 @@
 #include "WebUI/Authentication.h"
 #include "FileStream.h"  // FileStream and Channel
 #include "Error.h"
+#include "JobScan.h"
 
 #include <cstdint>
 
 class InputFile : public FileStream {
 private:
-    Error _pending_error = Error::Ok;
-    void  end_message();
+    Error   _pending_error = Error::Ok;
+    JobScan _scan;  // Time estimate, if the file has been scanned
+    bool    _scanned = false;
+    void    end_message();
 
 public:
     // fsname is the default file system on which the file is located, in case the path does not specify
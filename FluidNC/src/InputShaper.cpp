@@ -0,0 +1,163 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "InputShaper.h"
+
+#include <algorithm>
+#include <cmath>
+
+// M_PI is not defined in standard C/C++ but some compilers
+// support it anyway.
+#ifndef M_PI
+#    define M_PI 3.14159265358979323846
+#endif
+
+InputShaper::InputShaper() {
+    for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        _nImpulses[axis]    = 1;
+        _impulses[axis][0] = { 1.0, 0.0 };
+    }
+}
+
+bool InputShaper::configure(size_t axis, Type type, float frequency, float damping) {
+    if (axis >= MAX_N_AXIS) {
+        return false;
+    }
+    Impulse* imp = _impulses[axis];
+    size_t&  n   = _nImpulses[axis];
+
+    // The unshaped axis has a single impulse with no delay
+    n      = 1;
+    imp[0] = { 1.0, 0.0 };
+
+    bool ok = type == None || (frequency > 0 && damping >= 0 && damping < 1);
+    if (type != None && ok) {
+        double root = std::sqrt(1.0 - damping * damping);
+        double td   = 1.0 / (frequency * root);  // Damped period
+        double k    = std::exp(-damping * M_PI / root);
+        switch (type) {
+            case ZV:
+                n      = 2;
+                imp[0] = { 1.0, 0.0 };
+                imp[1] = { k, td / 2 };
+                break;
+            case ZVD:
+                n      = 3;
+                imp[0] = { 1.0, 0.0 };
+                imp[1] = { 2 * k, td / 2 };
+                imp[2] = { k * k, td };
+                break;
+            case MZV: {
+                double k3 = std::exp(-0.75 * damping * M_PI / root);
+                double a1 = 1.0 - 1.0 / std::sqrt(2.0);
+                n         = 3;
+                imp[0]    = { a1, 0.0 };
+                imp[1]    = { (std::sqrt(2.0) - 1.0) * k3, 0.375 * td };
+                imp[2]    = { a1 * k3 * k3, 0.75 * td };
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += imp[i].amplitude;
+        }
+        for (size_t i = 0; i < n; i++) {
+            imp[i].amplitude /= sum;
+        }
+        if (!ok) {
+            n      = 1;
+            imp[0] = { 1.0, 0.0 };
+        }
+    }
+
+    _duration = 0;
+    for (size_t a = 0; a < MAX_N_AXIS; a++) {
+        _duration = std::max(_duration, _impulses[a][_nImpulses[a] - 1].delay);
+    }
+    return ok;
+}
+
+void InputShaper::reset(const double* position) {
+    _first      = 0;
+    _count      = 1;
+    _lastChange = -_duration;
+    auto& s     = sample(0);
+    s.time      = 0;
+    std::copy(position, position + MAX_N_AXIS, s.position);
+}
+
+void InputShaper::add(double seconds, const double* position) {
+    if (_count == 0) {
+        double zero[MAX_N_AXIS] = {};
+        reset(zero);
+    }
+    const Sample& last = sample(_count - 1);
+    double        time = last.time + seconds;
+    if (!std::equal(position, position + MAX_N_AXIS, last.position)) {
+        _lastChange = time;
+    }
+
+    // A vertex closer than the spacing to the one before it is dropped,
+    // so the history always spans the duration of the shaper.  Its
+    // neighbors are close, so the path hardly changes.
+    double spacing = _duration / (MAX_SAMPLES - 16);
+    if (_count > 1 && last.time - sample(_count - 2).time < spacing) {
+        --_count;
+    } else if (_count == MAX_SAMPLES) {
+        _first = (_first + 1) % MAX_SAMPLES;
+        --_count;
+    }
+
+    auto& s = sample(_count++);
+    s.time  = time;
+    std::copy(position, position + MAX_N_AXIS, s.position);
+
+    // Samples older than the one at or before the longest delay are not needed
+    double horizon = time - _duration;
+    while (_count > 1 && sample(1).time <= horizon) {
+        _first = (_first + 1) % MAX_SAMPLES;
+        --_count;
+    }
+}
+
+double InputShaper::position(size_t axis, double time) const {
+    // Before the history the axis was still, and delays are never negative
+    size_t i = _count - 1;
+    while (i > 0 && sample(i - 1).time >= time) {
+        --i;
+    }
+    if (i == 0) {
+        return sample(0).position[axis];
+    }
+    const Sample& a = sample(i - 1);
+    const Sample& b = sample(i);
+    double        t = (time - a.time) / (b.time - a.time);
+    return a.position[axis] + t * (b.position[axis] - a.position[axis]);
+}
+
+void InputShaper::shaped(double* position) const {
+    if (_count == 0) {
+        std::fill(position, position + MAX_N_AXIS, 0.0);
+        return;
+    }
+    const Sample& last = sample(_count - 1);
+    if (settled()) {
+        // Exactly, rather than with the rounding error of the weighted sum
+        std::copy(last.position, last.position + MAX_N_AXIS, position);
+        return;
+    }
+    for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        double sum = 0;
+        for (size_t i = 0; i < _nImpulses[axis]; i++) {
+            sum += _impulses[axis][i].amplitude * this->position(axis, last.time - _impulses[axis][i].delay);
+        }
+        position[axis] = sum;
+    }
+}
+
+bool InputShaper::settled() const {
+    return _count == 0 || sample(_count - 1).time - _lastChange >= _duration;
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+
+#include "NAxis.h"
+
+// An input shaper convolves the motion of each axis with a short train of
+// impulses whose amplitudes sum to one, timed so that the vibration each
+// impulse excites at the axis' resonant frequency is cancelled by the
+// later ones.  The motion takes longer by the duration of the train, but
+// corners and changes of acceleration no longer make the machine ring.
+//
+//   ZV   two impulses over half a period; needs an accurate frequency
+//   ZVD  three impulses over a full period; tolerates more frequency error
+//   MZV  three impulses over 3/4 period; a compromise between the two
+//
+// The raw motion is added as a series of samples - the positions at the
+// ends of successive step segments - and the shaped position at the time
+// of the last sample is the sum of the delayed raw positions weighted by
+// the impulse amplitudes, interpolated linearly between samples.
+//
+// Positions are in motor steps and times in seconds, so one shaper
+// serves all of the axes at once.
+
+class InputShaper {
+public:
+    static const size_t MAX_IMPULSES = 3;
+
+    enum Type {
+        None = 0,
+        ZV,
+        ZVD,
+        MZV,
+    };
+
+    struct Impulse {
+        double amplitude;
+        double delay;  // Seconds
+    };
+
+private:
+    // Enough samples to cover the longest shaper, since add() thins out
+    // samples that are closer together than duration() / (MAX_SAMPLES - 16)
+    static const size_t MAX_SAMPLES = 64;
+
+    struct Sample {
+        double time;
+        double position[MAX_N_AXIS];
+    };
+
+    Impulse _impulses[MAX_N_AXIS][MAX_IMPULSES];
+    size_t  _nImpulses[MAX_N_AXIS];
+    double  _duration = 0;
+
+    Sample _samples[MAX_SAMPLES];
+    size_t _first      = 0;  // Index of the oldest sample
+    size_t _count      = 0;
+    double _lastChange = 0;  // Time of the last sample that moved
+
+    Sample&       sample(size_t i) { return _samples[(_first + i) % MAX_SAMPLES]; }
+    const Sample& sample(size_t i) const { return _samples[(_first + i) % MAX_SAMPLES]; }
+
+    double position(size_t axis, double time) const;
+
+public:
+    InputShaper();
+
+    // Sets the shaper of an axis.  frequency is the resonant frequency in
+    // Hz and damping is its damping ratio, between 0 and 1.  Returns false,
+    // leaving the axis unshaped, if the parameters are not usable.
+    bool configure(size_t axis, Type type, float frequency, float damping);
+
+    bool   enabled() const { return _duration > 0; }
+    double duration() const { return _duration; }  // Seconds
+
+    size_t         impulses(size_t axis) const { return _nImpulses[axis]; }
+    const Impulse& impulse(size_t axis, size_t i) const { return _impulses[axis][i]; }
+
+    // Forgets the history, with the axes at rest at position
+    void reset(const double* position);
+
+    // Appends the raw position seconds after the previous sample
+    void add(double seconds, const double* position);
+
+    // The shaped position at the time of the last sample
+    void shaped(double* position) const;
+
+    // True once the raw motion has been still for the duration of the
+    // shaper, so the shaped position has caught up with it
+    bool settled() const;
+};
@@ -8,7 +8,7 @@
 // Constructor.  If _encapsulate is true, the output is
 // encapsulated in [MSG:JSON: ...] lines
 JSONencoder::JSONencoder(bool encapsulate, Channel* channel) :
-    _encapsulate(encapsulate), level(0), _str(&linebuf), _channel(channel), category("nvs") {
+    _encapsulate(encapsulate), level(0), _channel(channel), category("nvs") {
     count[level] = 0;
 }
 
@@ -16,26 +16,46 @@ JSONencoder::JSONencoder(std::string* str) : level(0), _str(str), category("nvs"
     count[level] = 0;
 }
 
-void JSONencoder::flush() {
-    if (_channel && (*_str).length()) {
+// The writer is called each time the buffer fills, so the data can be sent
+// as it is produced.  A writer that blocks until the data is sent, as HTTP
+// sendContent() does, paces the encoding to the speed of the connection.
+JSONencoder::JSONencoder(Writer writer) : level(0), _writer(writer), category("nvs") {
+    count[level] = 0;
+}
+
+// Passes the buffer contents to the destination and empties the buffer
+void JSONencoder::emit() {
+    if (_str) {
+        _str->append(_buf, _buflen);
+    } else if (_writer) {
+        _writer(_buf, _buflen);
+    } else if (_channel) {
         if (_encapsulate) {
             // Output to channels is encapsulated in [MSG:JSON:...]
-            (*_channel).out_acked(*_str, "JSON:");
+            (*_channel).out_acked(std::string(_buf, _buflen), "JSON:");
         } else {
-            log_stream(*_channel, *_str);
+            log_stream(*_channel, std::string_view(_buf, _buflen));
         }
-        (*_str).clear();
     }
+    _buflen = 0;
 }
+
+void JSONencoder::flush() {
+    if (_buflen) {
+        emit();
+    }
+}
+
 void JSONencoder::add(char c) {
-    (*_str) += c;
-    if (_channel && (*_str).length() >= 100) {
-        flush();
+    if (_buflen == BUFLEN) {
+        emit();
     }
+    _buf[_buflen++] = c;
 }
 
-void JSONencoder::verbatim(const std::string& s) {
-    for (auto const c : s) {
+void JSONencoder::verbatim(const char* s) {
+    char c;
+    while ((c = *s++) != '\0') {
         if (c != '\n') {
             add(c);
         }
@@ -150,8 +170,7 @@ void JSONencoder::line() {
             // log_stream() always adds a newline
             // We want that for channels because they might not
             // be able to handle really long lines.
-            log_stream(*_channel, *_str);
-            (*_str).clear();
+            emit();
             indent();
         }
     } else {
@@ -166,7 +185,7 @@ void JSONencoder::begin() {
 }
 
 // Finishes the JSON encoding process, closing the unnamed object
-// and returning the encoded string
+// and passing any remaining output to the destination
 void JSONencoder::end() {
     end_object();
     line();
@@ -2,12 +2,22 @@
 
 #include "src/Channel.h"
 #include <string>
+#include <functional>
 
 // Class for creating JSON-encoded strings.
+// Output is collected in a small fixed buffer and passed on to the
+// destination - a string, a channel, or a writer function - whenever
+// the buffer fills, so encoding a large object does not need memory
+// in proportion to its size unless the destination is a string.
 
 class JSONencoder {
+public:
+    // Receives the encoded output in pieces, e.g. HTTP chunks
+    using Writer = std::function<void(const char* data, size_t length)>;
+
 private:
-    static const int MAX_JSON_LEVEL = 16;
+    static const int    MAX_JSON_LEVEL = 16;
+    static const size_t BUFLEN         = 100;
 
     bool _encapsulate = false;
     int  level;
@@ -22,19 +32,23 @@ private:
 
     void quoted(const char* s);
 
-    std::string linebuf;
+    char   _buf[BUFLEN];
+    size_t _buflen = 0;
 
     std::string* _str     = nullptr;
     Channel*     _channel = nullptr;
+    Writer       _writer;
 
     std::string category;
 
+    void emit();
     void flush();
 
 public:
     // Constructor; set _encapsulate true for [MSG:JSON: ,,,] encapsulation
     JSONencoder(bool encapsulate, Channel* channel);
     explicit JSONencoder(std::string* str);
+    explicit JSONencoder(Writer writer);
 
     // begin() starts the encoding process.
     void begin();
@@ -69,7 +83,9 @@ public:
     // Call end_object() to close the member
     void begin_member_object(const char* tag);
 
-    void verbatim(const std::string& s);
+    // Adds already-encoded JSON, dropping newlines
+    void verbatim(const char* s);
+    void verbatim(const std::string& s) { verbatim(s.c_str()); }
 
     // The begin_webui() methods are specific to Esp3D_WebUI
     // WebUI sends JSON objects to the UI to generate configuration
@@ -0,0 +1,509 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "JobScan.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+static const float MM_PER_INCH = 25.4f;
+static const char* axisLetters = "XYZABC";
+
+JobScan::JobScan(const Machine& machine, size_t fileSize) : _machine(machine) {
+    _machine.nAxes = _machine.nAxes < MAX_N_AXIS ? _machine.nAxes : size_t(MAX_N_AXIS);
+    _interval      = std::max(uint32_t(fileSize / 200), uint32_t(256));
+}
+
+void JobScan::include(const float* position) {
+    _nAxes = _machine.nAxes;
+    for (size_t axis = 0; axis < _nAxes; axis++) {
+        if (!_moved || position[axis] < _min[axis]) {
+            _min[axis] = position[axis];
+        }
+        if (!_moved || position[axis] > _max[axis]) {
+            _max[axis] = position[axis];
+        }
+    }
+    _moved = true;
+}
+
+// Computes the length of an arc from the current position to target and
+// includes its extreme points in the bounds.  unit is the direction of
+// the chord, which stands in for the arc direction at the junctions.
+void JobScan::arc(const float* target, bool clockwise, const float* ijk, bool hasR, float r, float* unit, float& length) {
+    // The plane axes and the offset words that go with them
+    size_t a0 = 0, a1 = 1, o0 = 0, o1 = 1;
+    if (_plane == 18) {
+        a0 = 2, a1 = 0, o0 = 2, o1 = 0;
+    } else if (_plane == 19) {
+        a0 = 1, a1 = 2, o0 = 1, o1 = 2;
+    }
+
+    float x = target[a0] - _position[a0];
+    float y = target[a1] - _position[a1];
+    float offset0, offset1;
+    if (hasR) {
+        // Center from radius, as in the GCode parser
+        float h = 4 * r * r - x * x - y * y;
+        if (h < 0 || (x == 0 && y == 0)) {
+            h = 0;
+        }
+        h = -std::sqrt(h) / std::hypot(x, y);
+        if (!clockwise) {
+            h = -h;
+        }
+        if (r < 0) {
+            h = -h;
+        }
+        offset0 = 0.5f * (x - y * h);
+        offset1 = 0.5f * (y + x * h);
+    } else {
+        offset0 = ijk[o0];
+        offset1 = ijk[o1];
+    }
+
+    float c0     = _position[a0] + offset0;
+    float c1     = _position[a1] + offset1;
+    float r0     = -offset0;
+    float r1     = -offset1;
+    float rt0    = target[a0] - c0;
+    float rt1    = target[a1] - c1;
+    float radius = std::hypot(r0, r1);
+
+    const float twoPi  = 2 * float(M_PI);
+    float       travel = std::atan2(r0 * rt1 - r1 * rt0, r0 * rt0 + r1 * rt1);
+    if (clockwise) {
+        if (travel >= -5e-7f) {
+            travel -= twoPi;
+        }
+    } else if (travel <= 5e-7f) {
+        travel += twoPi;
+    }
+
+    float linear = 0;
+    for (size_t axis = 0; axis < _machine.nAxes; axis++) {
+        if (axis != a0 && axis != a1) {
+            float d = target[axis] - _position[axis];
+            linear += d * d;
+        }
+    }
+    length = std::sqrt(radius * travel * radius * travel + linear);
+
+    // The arc reaches an extreme in the plane wherever it crosses an axis direction
+    float start = std::atan2(r1, r0);
+    for (int quadrant = 0; quadrant < 4; quadrant++) {
+        float angle = quadrant * float(M_PI) / 2;
+        float delta = std::fmod((travel > 0 ? angle - start : start - angle) + 2 * twoPi, twoPi);
+        if (delta <= std::fabs(travel)) {
+            float point[MAX_N_AXIS];
+            std::copy(_position, _position + MAX_N_AXIS, point);
+            point[a0] = c0 + radius * std::cos(angle);
+            point[a1] = c1 + radius * std::sin(angle);
+            include(point);
+        }
+    }
+
+    float chord = 0;
+    for (size_t axis = 0; axis < _machine.nAxes; axis++) {
+        unit[axis] = target[axis] - _position[axis];
+        chord += unit[axis] * unit[axis];
+    }
+    chord = std::sqrt(chord);
+    for (size_t axis = 0; axis < _machine.nAxes; axis++) {
+        unit[axis] = chord > 0 ? unit[axis] / chord : 0;
+    }
+}
+
+// The time of a move with a trapezoidal speed profile
+static float profile_time(float length, float entry, float speed, float exit, float accel) {
+    entry      = std::min(entry, speed);
+    exit       = std::min(exit, speed);
+    float dAcc = (speed * speed - entry * entry) / (2 * accel);
+    float dDec = (speed * speed - exit * exit) / (2 * accel);
+    if (dAcc + dDec <= length) {
+        return (speed - entry) / accel + (speed - exit) / accel + (length - dAcc - dDec) / speed;
+    }
+    // Too short to reach the nominal speed
+    float peak = std::sqrt((2 * accel * length + entry * entry + exit * exit) / 2);
+    if (peak < std::max(entry, exit)) {
+        return 2 * length / (entry + exit);
+    }
+    return (peak - entry) / accel + (peak - exit) / accel;
+}
+
+// Accounts for the time of the pending move, ending at no more than exit
+// and no faster than it can accelerate to; returns the actual exit speed
+float JobScan::commit(float exit) {
+    auto& m = _pending;
+    exit    = std::min(exit, std::sqrt(m.entry * m.entry + 2 * m.accel * m.length));
+
+    _seconds += profile_time(m.length, m.entry, m.speed, exit, m.accel);
+    _hasPending = false;
+    return exit;
+}
+
+void JobScan::stop() {
+    if (_hasPending) {
+        commit(0);
+    }
+}
+
+void JobScan::move(const float* target, int motion, const float* ijk, bool hasR, float r) {
+    Move m;
+    std::fill(m.unit, m.unit + MAX_N_AXIS, 0.0f);
+
+    if (motion >= 2) {
+        arc(target, motion == 2, ijk, hasR, r, m.unit, m.length);
+    } else {
+        float sum = 0;
+        for (size_t axis = 0; axis < _machine.nAxes; axis++) {
+            m.unit[axis] = target[axis] - _position[axis];
+            sum += m.unit[axis] * m.unit[axis];
+        }
+        m.length = std::sqrt(sum);
+        for (size_t axis = 0; axis < _machine.nAxes && m.length > 0; axis++) {
+            m.unit[axis] /= m.length;
+        }
+    }
+    include(target);
+    std::copy(target, target + MAX_N_AXIS, _position);
+
+    if (m.length < 1e-6f) {
+        return;
+    }
+
+    // Axis limits along the direction of the move
+    const float inf   = std::numeric_limits<float>::infinity();
+    float       limit = inf;
+    m.accel           = inf;
+    for (size_t axis = 0; axis < _machine.nAxes; axis++) {
+        float u = std::fabs(m.unit[axis]);
+        if (u > 1e-6f) {
+            limit   = std::min(limit, _machine.maxRate[axis] / 60 / u);
+            m.accel = std::min(m.accel, _machine.acceleration[axis] / u);
+        }
+    }
+    if (motion >= 2) {
+        // Arcs turn through all directions in the plane
+        size_t a0 = _plane == 19 ? 1 : _plane == 18 ? 2 : 0;
+        size_t a1 = _plane == 19 ? 2 : _plane == 18 ? 0 : 1;
+        limit     = std::min({ limit, _machine.maxRate[a0] / 60, _machine.maxRate[a1] / 60 });
+        m.accel   = std::min({ m.accel, _machine.acceleration[a0], _machine.acceleration[a1] });
+    }
+
+    float feed = motion == 0 ? inf : _inverseTime ? m.length * _feed / 60 : _feed / 60;
+    m.speed    = feed > 0 ? std::min(feed, limit) : limit;
+    if (!std::isfinite(m.speed) || !std::isfinite(m.accel) || m.speed <= 0 || m.accel <= 0) {
+        return;
+    }
+
+    m.entry = 0;
+    if (_hasPending) {
+        // Junction speed from the junction deviation, as the planner computes it
+        auto& prev     = _pending;
+        float cosTheta = 0;
+        for (size_t axis = 0; axis < _machine.nAxes; axis++) {
+            cosTheta -= prev.unit[axis] * m.unit[axis];
+        }
+        float junction = std::min(prev.speed, m.speed);
+        if (cosTheta > 0.999999f) {
+            junction = 0;
+        } else if (cosTheta > -0.999999f) {
+            float sinHalf = std::sqrt(0.5f * (1 - cosTheta));
+            float accel   = std::min(prev.accel, m.accel);
+            junction      = std::min(junction, std::sqrt(accel * _machine.junctionDeviation * sinHalf / (1 - sinHalf)));
+        }
+        m.entry = commit(junction);
+    }
+    _pending    = m;
+    _hasPending = true;
+}
+
+void JobScan::line(const char* text, uint32_t endOffset) {
+    float target[MAX_N_AXIS];
+    std::copy(_position, _position + MAX_N_AXIS, target);
+    bool  hasAxis   = false;
+    bool  hasR      = false;
+    bool  dwell     = false;
+    bool  stopped   = false;
+    bool  nonMotion = false;
+    bool  setOrigin = false;
+    float ijk[3]    = { 0, 0, 0 };
+    float words[MAX_N_AXIS];
+    bool  hasWord[MAX_N_AXIS] = {};
+    float r                   = 0;
+    float p                   = 0;
+    float feed                = -1;
+    bool  wasInverseTime      = _inverseTime;
+
+    const char* s = text;
+    while (*s == ' ' || *s == '\t') {
+        ++s;
+    }
+    // FluidNC commands and program delimiters do not move
+    bool command = *s == '$' || *s == '%' || *s == '[';
+
+    while (*s && !command) {
+        char c = *s;
+        if (c == '(') {
+            s = strchr(s, ')');
+            if (!s) {
+                break;
+            }
+            ++s;
+            continue;
+        }
+        if (c == ';') {
+            break;
+        }
+        if (!isalpha(c)) {
+            ++s;
+            continue;
+        }
+        char  letter = toupper(c);
+        char* end;
+        float value = strtof(s + 1, &end);
+        if (end == s + 1) {
+            ++s;
+            continue;
+        }
+        s = end;
+
+        const char* axis = strchr(axisLetters, letter);
+        if (axis) {
+            size_t n = axis - axisLetters;
+            if (n < MAX_N_AXIS) {
+                words[n]   = value;
+                hasWord[n] = true;
+                hasAxis    = true;
+            }
+            continue;
+        }
+        switch (letter) {
+            case 'G':
+                switch (int(std::lround(value * 10))) {
+                    case 0:
+                    case 10:
+                    case 20:
+                    case 30:
+                        _motion = int(std::lround(value));
+                        break;
+                    case 382:
+                    case 383:
+                    case 384:
+                    case 385:
+                        _motion = 1;  // A probe is timed as if it goes the whole distance
+                        break;
+                    case 800:
+                        _motion = -1;
+                        break;
+                    case 40:
+                        dwell = true;
+                        break;
+                    case 170:
+                    case 180:
+                    case 190:
+                        _plane = int(std::lround(value));
+                        break;
+                    case 200:
+                        _inches = true;
+                        break;
+                    case 210:
+                        _inches = false;
+                        break;
+                    case 900:
+                        _absolute = true;
+                        break;
+                    case 910:
+                        _absolute = false;
+                        break;
+                    case 930:
+                        _inverseTime = true;
+                        break;
+                    case 940:
+                        _inverseTime = false;
+                        break;
+                    case 920:
+                        setOrigin = true;
+                        break;
+                    case 100:
+                    case 280:
+                    case 281:
+                    case 300:
+                    case 301:
+                    case 431:
+                    case 530:
+                    case 921:
+                    case 922:
+                    case 923:
+                        nonMotion = true;
+                        break;
+                }
+                break;
+            case 'M':
+                switch (int(std::lround(value))) {
+                    case 0:
+                    case 1:
+                    case 2:
+                    case 30:
+                        stopped = true;
+                        break;
+                }
+                break;
+            case 'I':
+            case 'J':
+            case 'K':
+                ijk[letter - 'I'] = value;
+                break;
+            case 'R':
+                r    = value;
+                hasR = true;
+                break;
+            case 'F':
+                feed = value;
+                break;
+            case 'P':
+                p = value;
+                break;
+        }
+    }
+
+    // As in gc_execute_line(), an inverse time feed rate applies only to
+    // its own line, and switching back to G94 leaves the feed rate undefined
+    // until an F word sets it.
+    float scale = _inches ? MM_PER_INCH : 1.0f;
+    if (feed >= 0) {
+        _feed = _inverseTime ? feed : feed * scale;
+    } else if (_inverseTime || wasInverseTime) {
+        _feed = 0;
+    }
+    for (auto& v : ijk) {
+        v *= scale;
+    }
+    r *= scale;
+
+    for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        if (hasWord[axis]) {
+            float v      = axis < 3 ? words[axis] * scale : words[axis];
+            target[axis] = _absolute || setOrigin ? v : _position[axis] + v;
+        }
+    }
+
+    if (dwell) {
+        stop();
+        _seconds += p;
+    } else if (setOrigin) {
+        // G92 makes the current position have the given coordinates
+        std::copy(target, target + MAX_N_AXIS, _position);
+    } else if (hasAxis && !nonMotion && _motion >= 0) {
+        // The parser rejects a feed move without a feed rate, so it does
+        // not move and the position stays where it was
+        if (_motion == 0 || _feed > 0) {
+            move(target, _motion, ijk, hasR, r);
+        }
+    }
+    if (stopped) {
+        stop();
+    }
+
+    uint32_t last = _checkpoints.empty() ? 0 : _checkpoints.back().offset;
+    if (endOffset >= last + _interval) {
+        _checkpoints.push_back({ endOffset, float(_seconds) });
+    }
+    _end = endOffset;
+}
+
+void JobScan::finish() {
+    stop();
+}
+
+float JobScan::seconds_at(uint32_t offset) const {
+    if (offset >= _end) {
+        return seconds();
+    }
+    auto next = std::upper_bound(
+        _checkpoints.begin(), _checkpoints.end(), offset, [](uint32_t o, const Checkpoint& c) { return o < c.offset; });
+
+    uint32_t o0 = 0, o1 = _end;
+    float    s0 = 0, s1 = seconds();
+    if (next != _checkpoints.begin()) {
+        o0 = (next - 1)->offset;
+        s0 = (next - 1)->seconds;
+    }
+    if (next != _checkpoints.end()) {
+        o1 = next->offset;
+        s1 = next->seconds;
+    }
+    return o1 > o0 ? s0 + (s1 - s0) * (offset - o0) / (o1 - o0) : s0;
+}
+
+std::string JobScan::serialize(const std::string& signature) const {
+    std::string text = "jobscan " + signature + "\n";
+    char        buf[64];
+    snprintf(buf, sizeof(buf), "%.1f %u %u %d\n", _seconds, unsigned(_end), unsigned(_nAxes), int(_moved));
+    text += buf;
+    for (auto bound : { _min, _max }) {
+        for (size_t axis = 0; axis < _nAxes; axis++) {
+            snprintf(buf, sizeof(buf), axis ? " %.3f" : "%.3f", bound[axis]);
+            text += buf;
+        }
+        text += '\n';
+    }
+    for (auto const& c : _checkpoints) {
+        snprintf(buf, sizeof(buf), "%u %.1f\n", unsigned(c.offset), c.seconds);
+        text += buf;
+    }
+    return text;
+}
+
+bool JobScan::parse(const std::string& text, const std::string& signature) {
+    std::string header = "jobscan " + signature + "\n";
+    if (text.compare(0, header.length(), header)) {
+        return false;
+    }
+    const char* p = text.c_str() + header.length();
+
+    char* end;
+    auto  number = [&p, &end]() {
+        double v = strtod(p, &end);
+        bool   ok = end != p;
+        p         = end;
+        return ok ? v : NAN;
+    };
+
+    double seconds = number();
+    double eof     = number();
+    double nAxes   = number();
+    double moved   = number();
+    if (std::isnan(seconds) || std::isnan(eof) || std::isnan(moved) || !(nAxes >= 0 && nAxes <= MAX_N_AXIS)) {
+        return false;
+    }
+    _seconds = seconds;
+    _end     = uint32_t(eof);
+    _nAxes   = size_t(nAxes);
+    _moved   = moved != 0;
+    for (auto bound : { _min, _max }) {
+        for (size_t axis = 0; axis < _nAxes; axis++) {
+            double v = number();
+            if (std::isnan(v)) {
+                return false;
+            }
+            bound[axis] = float(v);
+        }
+    }
+    _checkpoints.clear();
+    while (true) {
+        double offset = number();
+        double t      = number();
+        if (std::isnan(offset) || std::isnan(t)) {
+            break;
+        }
+        _checkpoints.push_back({ uint32_t(offset), float(t) });
+    }
+    return true;
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "NAxis.h"
+
+// An estimate of the run time and extent of a G-code program, made by
+// reading the program without running it.
+//
+// Each move is timed with the planner's model - a trapezoidal speed
+// profile limited by the axis maximum rates and accelerations, with the
+// speed at each junction limited by the junction deviation - but with
+// only one move of lookahead, so the estimate is a little long for runs
+// of very short segments.  Positions are in program coordinates; G53,
+// G28 and G30 moves and changes of work offset within the program are
+// not followed.
+//
+// The cumulative time is recorded at intervals through the file so the
+// time remaining can be estimated from the byte position of a running job.
+//
+// Lines are fed in one at a time, so a file of any size can be scanned
+// without holding it in memory.
+
+class JobScan {
+public:
+
+    struct Machine {
+        size_t nAxes                    = 3;
+        float  maxRate[MAX_N_AXIS]      = { 1000, 1000, 1000, 1000, 1000, 1000 };  // mm/min
+        float  acceleration[MAX_N_AXIS] = { 25, 25, 25, 25, 25, 25 };              // mm/sec^2
+        float  junctionDeviation        = 0.01f;                                   // mm
+    };
+
+    struct Checkpoint {
+        uint32_t offset;
+        float    seconds;
+    };
+
+private:
+    Machine  _machine;
+    uint32_t _interval = 1024;  // Bytes between checkpoints
+
+    // Modal state
+    int   _motion      = 0;  // 0-3 for G0-G3, -1 after G80
+    int   _plane       = 17;
+    bool  _absolute    = true;
+    bool  _inches      = false;
+    bool  _inverseTime = false;
+    float _feed        = 0;  // mm/min, or 1/min in inverse time mode
+    float _position[MAX_N_AXIS] {};
+
+    // The last move, whose exit speed depends on the next move
+    struct Move {
+        float length;
+        float speed;  // Nominal, mm/sec
+        float accel;  // mm/sec^2
+        float entry;  // mm/sec
+        float unit[MAX_N_AXIS];
+    };
+    Move _pending;
+    bool _hasPending = false;
+
+    double                  _seconds = 0;
+    uint32_t                _end     = 0;
+    size_t                  _nAxes   = 0;
+    bool                    _moved   = false;
+    float                   _min[MAX_N_AXIS] {};
+    float                   _max[MAX_N_AXIS] {};
+    std::vector<Checkpoint> _checkpoints;
+
+    void  include(const float* position);
+    void  arc(const float* target, bool clockwise, const float* ijk, bool hasR, float r, float* unit, float& length);
+    void  move(const float* target, int motion, const float* ijk, bool hasR, float r);
+    void  stop();
+    float commit(float exit);
+
+public:
+    JobScan() = default;
+
+    // fileSize sets the checkpoint spacing, about 200 per file
+    explicit JobScan(const Machine& machine, size_t fileSize = 0);
+
+    // Scan one line; endOffset is the byte offset in the file after the line
+    void line(const char* text, uint32_t endOffset);
+
+    // Account for the last move; call after the last line
+    void finish();
+
+    float seconds() const { return float(_seconds); }
+
+    // Estimated time from the start of the file to a byte offset
+    float seconds_at(uint32_t offset) const;
+
+    // Program-coordinate extent of all moves, if there were any
+    bool   moved() const { return _moved; }
+    size_t nAxes() const { return _nAxes; }
+    float  min(size_t axis) const { return _min[axis]; }
+    float  max(size_t axis) const { return _max[axis]; }
+
+    // Text form for the cache file.  signature identifies the version of
+    // the scanned file so a stale cache can be recognized.
+    std::string serialize(const std::string& signature) const;
+    bool        parse(const std::string& text, const std::string& signature);
+};
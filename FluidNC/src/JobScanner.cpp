@@ -0,0 +1,197 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "JobScanner.h"
+
+#include "Machine/MachineConfig.h"
+#include "Machine/Axes.h"  // axisName()
+#include "FileStream.h"
+#include "DirIndex.h"
+#include "GCode.h"   // gc_state
+#include "Limits.h"  // limitsMinPosition()
+#include "Serial.h"  // allChannels
+
+#include <sys/stat.h>
+#include <atomic>
+
+struct Scan {
+    FileStream*       file;  // Opened by start(), closed by poll()
+    std::string       path;
+    std::string       signature;
+    JobScan           result;
+    std::atomic<bool> done;  // Set by the scan task when result is complete
+};
+
+static Scan* current = nullptr;
+
+// Identifies the version of a file, so a cached scan of an older version is not used
+static std::string signature(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st)) {
+        return "";
+    }
+    return std::to_string(st.st_size) + " " + std::to_string(st.st_mtime);
+}
+
+static std::string cache_path(const std::string& path) {
+    return path + ".scan";
+}
+
+static JobScan::Machine machine() {
+    JobScan::Machine m;
+    auto             axes = config->_axes;
+    m.nAxes               = axes->_numberAxis;
+    if (m.nAxes > MAX_N_AXIS) {
+        m.nAxes = MAX_N_AXIS;
+    }
+    for (size_t axis = 0; axis < m.nAxes; axis++) {
+        m.maxRate[axis]      = axes->_axis[axis]->_maxRate;
+        m.acceleration[axis] = axes->_axis[axis]->_acceleration;
+    }
+    m.junctionDeviation = config->_junctionDeviation;
+    return m;
+}
+
+// The polling task shares the support core at the same priority and
+// never blocks, so a lower priority task would not run at all.  The
+// scan instead sleeps briefly every so often to leave most of the core
+// to the polling task and to let the idle task run.
+static void scanTask(void* arg) {
+    auto     scan = static_cast<Scan*>(arg);
+    char     buf[256];
+    char     line[Channel::maxLine + 1];
+    size_t   len    = 0;
+    uint32_t offset = 0;
+    uint32_t lines  = 0;
+    size_t   n;
+
+    while ((n = scan->file->read(buf, sizeof(buf))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            char c = buf[i];
+            ++offset;
+            if (c == '\n') {
+                line[len] = '\0';
+                scan->result.line(line, offset);
+                len = 0;
+                if (++lines % 200 == 0) {
+                    vTaskDelay(1);
+                }
+            } else if (c != '\r' && len < Channel::maxLine) {
+                line[len++] = c;
+            }
+        }
+    }
+    if (len) {
+        line[len] = '\0';
+        scan->result.line(line, offset);
+    }
+    scan->result.finish();
+    scan->done = true;
+    vTaskDelete(NULL);
+}
+
+Error JobScanner::start(const char* path, Channel& out) {
+    if (current) {
+        log_error_to(out, "A scan of " << current->path << " is running");
+        return Error::FsFailedBusy;
+    }
+
+    FileStream* file;
+    try {
+        file = new FileStream(path, "r", sdName);
+    } catch (Error err) {
+        log_error_to(out, "Cannot open " << path);
+        return err;
+    }
+
+    current = new Scan { file, file->path(), signature(file->path()), JobScan(machine(), file->size()), false };
+    log_info_to(out, "Scanning " << current->path);
+    xTaskCreatePinnedToCore(scanTask,           // task
+                            "jobscan",          // name for task
+                            4096,               // size of task stack
+                            current,            // parameters
+                            1,                  // priority
+                            nullptr,            // handle
+                            SUPPORT_TASK_CORE  // core
+    );
+    return Error::Ok;
+}
+
+bool JobScanner::load(const std::string& path, JobScan& scan) {
+    auto sig = signature(path);
+    if (sig.empty()) {
+        return false;
+    }
+    FILE* fd = fopen(cache_path(path).c_str(), "r");
+    if (!fd) {
+        return false;
+    }
+    std::string text;
+    char        buf[256];
+    size_t      n;
+    while ((n = fread(buf, 1, sizeof(buf), fd)) > 0) {
+        text.append(buf, n);
+    }
+    fclose(fd);
+    return scan.parse(text, sig);
+}
+
+void JobScanner::report(const std::string& path, const JobScan& scan, Channel& out) {
+    uint32_t seconds = uint32_t(scan.seconds() + 0.5f);
+    char     hms[16];
+    snprintf(hms, sizeof(hms), "%u:%02u:%02u", unsigned(seconds / 3600), unsigned(seconds / 60 % 60), unsigned(seconds % 60));
+    log_info_to(out, path << " estimated time " << hms);
+
+    if (!scan.moved()) {
+        return;
+    }
+
+    // Program coordinates become machine coordinates with the current offsets
+    auto        n_axis = std::min(scan.nAxes(), size_t(config->_axes->_numberAxis));
+    std::string bounds;
+    std::string outside;
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        float offset = gc_state.coord_system[axis] + gc_state.coord_offset[axis];
+        if (axis == Z_AXIS) {
+            offset += gc_state.tool_length_offset;
+        }
+        char range[48];
+        snprintf(range, sizeof(range), " %c%.3f..%.3f", config->_axes->axisName(axis), scan.min(axis), scan.max(axis));
+        bounds += range;
+        if (scan.min(axis) + offset < limitsMinPosition(axis) || scan.max(axis) + offset > limitsMaxPosition(axis)) {
+            outside += config->_axes->axisName(axis);
+        }
+    }
+    log_info_to(out, "Job extent" << bounds);
+    if (!outside.empty()) {
+        log_warn_to(out, "Job exceeds the travel of " << outside << " with the current work offset");
+    }
+}
+
+void JobScanner::poll() {
+    if (!current || !current->done) {
+        return;
+    }
+    auto scan = current;
+    current   = nullptr;
+
+    // The volume stays mounted while the scanned file is still open
+    bool  saved = false;
+    FILE* fd    = fopen(cache_path(scan->path).c_str(), "w");
+    if (fd) {
+        auto text = scan->result.serialize(scan->signature);
+        saved     = fwrite(text.data(), 1, text.size(), fd) == text.size();
+        fclose(fd);
+    }
+    delete scan->file;
+
+    if (saved) {
+        DirIndex::invalidate(cache_path(scan->path));
+        report(scan->path, scan->result, allChannels);
+    } else {
+        log_error("Cannot save the scan of " << scan->path);
+    }
+    delete scan;
+}
+
+ModuleFactory::InstanceBuilder<JobScanner> job_scanner_module("job_scanner", true);
@@ -0,0 +1,36 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include "src/Config.h"
+#include "src/Module.h"
+#include "src/Channel.h"
+#include "src/Error.h"
+#include "src/JobScan.h"
+
+#include <string>
+
+// JobScanner runs JobScan over a G-code file in a background task and
+// saves the result next to the file, as <file>.scan, where InputFile
+// finds it when the file is run.  The scan task only reads the file that
+// start() opened.  The module's poll() method, which runs in the polling
+// task, sees when the scan is done and then writes the cache, closes the
+// file and updates the directory index.
+
+class JobScanner : public Module {
+public:
+    JobScanner(const char* name) : Module(name) {}
+
+    // Scans path in the background and reports the result when done
+    static Error start(const char* path, Channel& out);
+
+    // Loads the cached scan of path into scan, if it is up to date
+    static bool load(const std::string& path, JobScan& scan);
+
+    // Reports the estimate and checks the extent of the job against
+    // the machine travel with the current work offsets
+    static void report(const std::string& path, const JobScan& scan, Channel& out);
+
+    void poll() override;
+};
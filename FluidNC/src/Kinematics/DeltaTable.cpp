@@ -0,0 +1,176 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "DeltaTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+// M_PI is not defined in standard C/C++ but some compilers
+// support it anyway.
+#ifndef M_PI
+#    define M_PI 3.14159265358979323846
+#endif
+
+namespace Kinematics {
+    // Calculates the angle theta1 in the YZ plane of the arm
+    bool DeltaArm::angle(float x0, float y0, float z0, float& theta) const {
+        float y1 = -0.5 * 0.57735 * f;  // f/2 * tg 30
+        y0 -= 0.5 * 0.57735 * e;        // shift center to edge
+        // z = a + b*y
+        float a = (x0 * x0 + y0 * y0 + z0 * z0 + rf * rf - re * re - y1 * y1) / (2 * z0);
+        float b = (y1 - y0) / z0;
+        // discriminant
+        float d = -(a + b * y1) * (a + b * y1) + rf * (b * b * rf + rf);
+        if (d < 0) {
+            return false;
+        }                                                 // non-existing point
+        float yj = (y1 - a * b - sqrt(d)) / (b * b + 1);  // choosing outer point
+        float zj = a + b * yj;
+
+        theta = atan(-zj / (y1 - yj)) + ((yj > y1) ? M_PI : 0.0);
+
+        return true;
+    }
+
+    void DeltaTable::clear() {
+        _theta.clear();
+        _theta.shrink_to_fit();
+        _exact.clear();
+        _exact.shrink_to_fit();
+        _nx = _ny = _nz = 0;
+        _nReachable     = 0;
+        _nInterpolated  = 0;
+        _maxError       = 0;
+    }
+
+    // The dimensions match build()
+    size_t DeltaTable::bytesFor(float radius, float minZ, float maxZ, float grid) {
+        size_t nx = size_t(std::ceil(radius / grid)) + 1;
+        size_t ny = size_t(std::ceil(2 * radius / grid)) + 1;
+        size_t nz = size_t(std::ceil((maxZ - minZ) / grid)) + 1;
+        return nx * ny * nz * sizeof(float) + (nx - 1) * (ny - 1) * (nz - 1) / 8;
+    }
+
+    float DeltaTable::gridFor(float radius, float minZ, float maxZ, float grid, size_t maxBytes) {
+        if (radius <= 0 || maxZ <= minZ || grid <= 0) {
+            return 0;
+        }
+        // Past the size of the box the table has its minimum of 2x3x2 points
+        float largest = std::max(2 * radius, maxZ - minZ);
+        for (; grid < 1.1f * largest; grid *= 1.1f) {
+            if (bytesFor(radius, minZ, maxZ, grid) <= maxBytes) {
+                return grid;
+            }
+        }
+        return 0;
+    }
+
+    bool DeltaTable::build(const DeltaArm& arm, float radius, float minZ, float maxZ, float grid, float tolerance) {
+        clear();
+        if (radius <= 0 || maxZ <= minZ || grid <= 0) {
+            return false;
+        }
+        _arm    = arm;
+        _radius = radius;
+        _minZ   = minZ;
+        _grid   = grid;
+
+        // The angle depends on x only through x squared, and is smoother
+        // as a function of x squared, so that is the first table index
+        _nx = size_t(std::ceil(radius / grid)) + 1;
+        _ny = size_t(std::ceil(2 * radius / grid)) + 1;
+        _nz = size_t(std::ceil((maxZ - minZ) / grid)) + 1;
+        _du = radius * radius / (_nx - 1);
+        _theta.resize(_nx * _ny * _nz);
+
+        auto p = _theta.begin();
+        for (size_t iz = 0; iz < _nz; iz++) {
+            for (size_t iy = 0; iy < _ny; iy++) {
+                for (size_t ix = 0; ix < _nx; ix++) {
+                    float theta;
+                    *p++ = _arm.angle(std::sqrt(ix * _du), iy * grid - radius, minZ + iz * grid, theta) ? theta : NAN;
+                }
+            }
+        }
+
+        // The error of trilinear interpolation is largest away from the
+        // grid points, so check the middle of each cell and of its edges
+        const float probes[4][3] = { { 0.5, 0.5, 0.5 }, { 0.5, 0, 0 }, { 0, 0.5, 0 }, { 0, 0, 0.5 } };
+        _exact.resize((_nx - 1) * (_ny - 1) * (_nz - 1));
+        size_t cell = 0;
+        for (size_t iz = 0; iz + 1 < _nz; iz++) {
+            for (size_t iy = 0; iy + 1 < _ny; iy++) {
+                for (size_t ix = 0; ix + 1 < _nx; ix++, cell++) {
+                    float cellError = 0;
+                    bool  reachable = true;
+                    for (auto& probe : probes) {
+                        float table = interpolate(cell, ix, iy, iz, probe[0], probe[1], probe[2]);
+                        float theta;
+                        float x = std::sqrt((ix + probe[0]) * _du);
+                        float y = (iy + probe[1]) * grid - radius;
+                        float z = minZ + (iz + probe[2]) * grid;
+                        if (std::isnan(table) || !_arm.angle(x, y, z, theta)) {
+                            reachable = false;
+                            break;
+                        }
+                        cellError = std::max(cellError, std::fabs(table - theta));
+                    }
+                    if (reachable) {
+                        ++_nReachable;
+                    }
+                    if (!reachable || cellError > tolerance) {
+                        _exact[cell] = true;
+                    } else {
+                        ++_nInterpolated;
+                        _maxError = std::max(_maxError, cellError);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    float DeltaTable::interpolate(size_t cell, size_t ix, size_t iy, size_t iz, float tx, float ty, float tz) const {
+        if (_exact[cell]) {
+            return NAN;
+        }
+        const size_t dy = _nx;
+        const size_t dz = _nx * _ny;
+        const float* p  = &_theta[iz * dz + iy * dy + ix];
+
+        // An unreachable corner is NaN, which makes the result NaN
+        float c00 = p[0] + tx * (p[1] - p[0]);
+        float c10 = p[dy] + tx * (p[dy + 1] - p[dy]);
+        float c01 = p[dz] + tx * (p[dz + 1] - p[dz]);
+        float c11 = p[dz + dy] + tx * (p[dz + dy + 1] - p[dz + dy]);
+        float c0  = c00 + ty * (c10 - c00);
+        float c1  = c01 + ty * (c11 - c01);
+        return c0 + tz * (c1 - c0);
+    }
+
+    float DeltaTable::interpolate(float x0, float y0, float z0) const {
+        float fx = x0 * x0 / _du;
+        float fy = (y0 + _radius) / _grid;
+        float fz = (z0 - _minZ) / _grid;
+        // The negated tests also reject NaN
+        if (!(fy >= 0 && fz >= 0 && fx < _nx - 1 && fy < _ny - 1 && fz < _nz - 1)) {
+            return NAN;
+        }
+        size_t ix = size_t(fx);
+        size_t iy = size_t(fy);
+        size_t iz = size_t(fz);
+        return interpolate((iz * (_ny - 1) + iy) * (_nx - 1) + ix, ix, iy, iz, fx - ix, fy - iy, fz - iz);
+    }
+
+    bool DeltaTable::angle(float x0, float y0, float z0, float& theta) const {
+        if (!_theta.empty()) {
+            float t = interpolate(x0, y0, z0);
+            if (!std::isnan(t)) {
+                theta = t;
+                return true;
+            }
+        }
+        return _arm.angle(x0, y0, z0, theta);
+    }
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Kinematics {
+    // The geometry of a parallel delta, named as in the published
+    // kinematics.  angle() is the exact inverse kinematics of one arm,
+    // with the target in that arm's own coordinate frame.
+    struct DeltaArm {
+        float rf;  // The length of the crank arm on the motor
+        float f;   // The size of the fixed side triangle
+        float re;  // The length of the linkages
+        float e;   // The size of the end effector triangle
+
+        bool angle(float x0, float y0, float z0, float& theta) const;
+    };
+
+    // A precomputed grid of DeltaArm::angle() over a box of the work
+    // envelope, interpolated trilinearly.  The three arms share the
+    // function, each with the target rotated into its frame, so one
+    // table covers all three arms.
+    //
+    // build() compares the interpolation with the exact solution at the
+    // center of every cell and at the midpoints of its edges.  Cells whose
+    // error exceeds the tolerance - near the edge of the reachable space,
+    // where the angle changes steeply, and where the solution wraps
+    // around - are solved exactly, as are targets outside the box.
+    //
+    // The table is built once, when the kinematics are configured, and is
+    // only read while moving.
+    class DeltaTable {
+        DeltaArm           _arm {};
+        float              _radius   = 0;
+        float              _minZ     = 0;
+        float              _grid     = 1;
+        float              _du       = 1;  // Table spacing in x squared
+        size_t             _nx       = 0;
+        size_t             _ny       = 0;
+        size_t             _nz       = 0;
+        float              _maxError = 0;
+        std::vector<float> _theta;  // NaN where unreachable
+        std::vector<bool>  _exact;  // Cells that are solved exactly
+        size_t             _nReachable    = 0;
+        size_t             _nInterpolated = 0;
+
+        // The interpolated angle, NaN outside the table or in an exact cell
+        float interpolate(float x0, float y0, float z0) const;
+        float interpolate(size_t cell, size_t ix, size_t iy, size_t iz, float tx, float ty, float tz) const;
+
+    public:
+        // Tabulates |x|,|y| <= radius and minZ <= z <= maxZ at the given spacing,
+        // replacing any previous table.  tolerance is the largest error in
+        // radians allowed in an interpolated cell.  Returns false if the box
+        // is empty.
+        bool build(const DeltaArm& arm, float radius, float minZ, float maxZ, float grid, float tolerance);
+        void clear();
+
+        // The memory build() uses for these limits
+        static size_t bytesFor(float radius, float minZ, float maxZ, float grid);
+
+        // The finest spacing, starting at grid and coarsened in 10% steps,
+        // whose table fits in maxBytes, or 0 if none does
+        static float gridFor(float radius, float minZ, float maxZ, float grid, size_t maxBytes);
+
+        bool   empty() const { return _theta.empty(); }
+        size_t bytes() const { return _theta.size() * sizeof(float) + _exact.size() / 8; }
+        float  grid() const { return _grid; }
+
+        // The fraction of the reachable cells that are interpolated
+        float coverage() const { return _nReachable ? float(_nInterpolated) / _nReachable : 0; }
+
+        // The largest difference from the exact solution that build() found
+        // in the interpolated cells, in radians
+        float maxError() const { return _maxError; }
+
+        bool angle(float x0, float y0, float z0, float& theta) const;
+    };
+}
@@ -5,6 +5,8 @@
 #include "Kinematics.h"
 
 #include "src/Config.h"
+#include "src/HeightMap.h"
+#include "src/Machine/MachineConfig.h"
 #include "Cartesian.h"
 
 namespace Kinematics {
@@ -24,14 +26,55 @@ namespace Kinematics {
         return _system->invalid_arc(target, pl_data, position, center, radius, caxes, is_clockwise_arc);
     }
 
+    // When a height map is active, Z is offset by the map at every point
+    // along the move, so the move is split into pieces short enough to
+    // follow the interpolated surface.  The kinematic system sees the
+    // compensated positions; everything above it sees nominal positions.
     bool Kinematics::cartesian_to_motors(float* target, plan_line_data_t* pl_data, float* position) {
         Assert(_system != nullptr, "No kinematic system");
-        return _system->cartesian_to_motors(target, pl_data, position);
+        if (!heightMap.active()) {
+            return _system->cartesian_to_motors(target, pl_data, position);
+        }
+
+        auto   n_axis   = config->_axes->_numberAxis;
+        size_t segments = heightMap.segments(position[X_AXIS], position[Y_AXIS], target[X_AXIS], target[Y_AXIS]);
+
+        // An inverse time feed rate applies to the whole move
+        if (pl_data->motion.inverseTime) {
+            pl_data->feed_rate *= segments;
+        }
+
+        float from[MAX_N_AXIS];
+        float to[MAX_N_AXIS];
+        copyAxes(from, position);
+        from[Z_AXIS] += heightMap.offset(position[X_AXIS], position[Y_AXIS]);
+
+        for (size_t segment = 1; segment <= segments; segment++) {
+            if (sys.abort) {
+                return true;
+            }
+            for (size_t axis = 0; axis < n_axis; axis++) {
+                to[axis] = segment == segments ? target[axis] : position[axis] + (target[axis] - position[axis]) * segment / segments;
+            }
+            to[Z_AXIS] += heightMap.offset(to[X_AXIS], to[Y_AXIS]);
+
+            // The system may modify its arguments so give it copies
+            float seg_target[MAX_N_AXIS];
+            copyAxes(seg_target, to);
+            if (!_system->cartesian_to_motors(seg_target, pl_data, from)) {
+                return false;
+            }
+            copyAxes(from, to);
+        }
+        return true;
     }
 
     void Kinematics::motors_to_cartesian(float* cartesian, float* motors, int n_axis) {
         Assert(_system != nullptr, "No kinematic system");
-        return _system->motors_to_cartesian(cartesian, motors, n_axis);
+        _system->motors_to_cartesian(cartesian, motors, n_axis);
+        if (heightMap.active() && n_axis > Z_AXIS) {
+            cartesian[Z_AXIS] -= heightMap.offset(cartesian[X_AXIS], cartesian[Y_AXIS]);
+        }
     }
 
     bool Kinematics::canHome(AxisMask axisMask) {
@@ -56,6 +99,12 @@ namespace Kinematics {
 
     bool Kinematics::transform_cartesian_to_motors(float* motors, float* cartesian) {
         Assert(_system != nullptr, "No kinematics system.");
+        if (heightMap.active()) {
+            float compensated[MAX_N_AXIS];
+            copyAxes(compensated, cartesian);
+            compensated[Z_AXIS] += heightMap.offset(cartesian[X_AXIS], cartesian[Y_AXIS]);
+            return _system->transform_cartesian_to_motors(motors, compensated);
+        }
         return _system->transform_cartesian_to_motors(motors, cartesian);
     }
 
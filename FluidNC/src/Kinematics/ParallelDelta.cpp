@@ -7,6 +7,7 @@
 #include "../Protocol.h"  // protocol_execute_realtime
 
 #include <cmath>
+#include <new>
 
 /*
   ==================== How it Works ====================================
@@ -78,6 +79,44 @@ namespace Kinematics {
         handler.item("soft_limits", _softLimits);
         handler.item("max_z_mm", _max_z, -10000.0, 0.0);  //
         handler.item("use_servos", _use_servos);
+        handler.item("lookup_radius_mm", _lookup_radius_mm, 0.0, 1000.0);
+        handler.item("lookup_min_z_mm", _lookup_min_z_mm, -10000.0, 0.0);
+        handler.item("lookup_grid_mm", _lookup_grid_mm, 0.5, 50.0);
+        handler.item("lookup_error_rad", _lookup_error_rad, 0.0, 0.1);
+    }
+
+    // The table is rebuilt whenever the geometry may have changed.  Cells
+    // where interpolation would miss the exact angles by more than
+    // lookup_error_rad, such as those near the edge of the reachable
+    // space, are left to the exact solver.
+    //
+    // lookup_grid_mm is the finest spacing.  A fine grid over a large box
+    // can need more memory than the ESP32 has, so the spacing is coarsened
+    // until the table fits in half of the free heap.
+    void ParallelDelta::afterParse() {
+        _arm = { rf, f, re, e };
+        _table.clear();
+        if (_lookup_radius_mm > 0) {
+            size_t budget = xPortGetFreeHeapSize() / 2;
+            float  grid   = DeltaTable::gridFor(_lookup_radius_mm, _lookup_min_z_mm, _max_z, _lookup_grid_mm, budget);
+            if (grid == 0) {
+                log_warn("Kinematics lookup table disabled; lookup_min_z_mm must be below max_z_mm");
+                return;
+            }
+            if (grid > _lookup_grid_mm) {
+                log_warn("Kinematics lookup grid coarsened to " << grid << "mm to fit in " << (budget / 1024) << "KB");
+            }
+            try {
+                if (_table.build(_arm, _lookup_radius_mm, _lookup_min_z_mm, _max_z, grid, _lookup_error_rad)) {
+                    log_info("Kinematics lookup table:" << (_table.bytes() / 1024) << "KB grid " << _table.grid() << "mm interpolates "
+                                                        << int(_table.coverage() * 100) << "% of reachable cells, max error "
+                                                        << _table.maxError() << " rad");
+                }
+            } catch (std::bad_alloc&) {
+                _table.clear();
+                log_error("Not enough memory for the kinematics lookup table; increase lookup_grid_mm");
+            }
+        }
     }
 
     void ParallelDelta::init() {
@@ -307,23 +346,7 @@ namespace Kinematics {
 
     // helper functions, calculates angle theta1 (for YZ-pane)
     bool ParallelDelta::delta_calcAngleYZ(float x0, float y0, float z0, float& theta) {
-        float y1 = -0.5 * 0.57735 * f;  // f/2 * tg 30
-        y0 -= 0.5 * 0.57735 * e;        // shift center to edge
-        // z = a + b*y
-        float a = (x0 * x0 + y0 * y0 + z0 * z0 + rf * rf - re * re - y1 * y1) / (2 * z0);
-        float b = (y1 - y0) / z0;
-        // discriminant
-        float d = -(a + b * y1) * (a + b * y1) + rf * (b * b * rf + rf);
-        if (d < 0) {
-            //log_warn("Kinematics: Target unreachable");
-            return false;
-        }                                                 // non-existing point
-        float yj = (y1 - a * b - sqrt(d)) / (b * b + 1);  // choosing outer point
-        float zj = a + b * yj;
-
-        theta = atan(-zj / (y1 - yj)) + ((yj > y1) ? M_PI : 0.0);
-
-        return true;
+        return _table.empty() ? _arm.angle(x0, y0, z0, theta) : _table.angle(x0, y0, z0, theta);
     }
 
     void ParallelDelta::releaseMotors(AxisMask axisMask, MotorMask motors) {}
@@ -11,6 +11,7 @@
 
 #include "Kinematics.h"
 #include "Cartesian.h"
+#include "DeltaTable.h"
 
 // M_PI is not defined in standard C/C++ but some compilers
 // support it anyway.  The following suppresses Intellisense
@@ -54,7 +55,7 @@ namespace Kinematics {
         // Configuration handlers:
         //void         validate() const override {}
         virtual void group(Configuration::HandlerBase& handler) override;
-        void         afterParse() override {}
+        void         afterParse() override;
 
         ~ParallelDelta() {}
 
@@ -72,6 +73,16 @@ namespace Kinematics {
         float _max_z                    = 0.0;
         bool  _use_servos               = true;  // servo use a special homing
 
+        // Optional interpolated inverse kinematics over a box of the work
+        // envelope, built when lookup_radius_mm is nonzero.  The grid is
+        // coarsened from _lookup_grid_mm if the table would not fit in memory.
+        float      _lookup_radius_mm = 0.0;
+        float      _lookup_min_z_mm  = -300.0;
+        float      _lookup_grid_mm   = 4.0;
+        float      _lookup_error_rad = 0.0005;
+        DeltaArm   _arm;
+        DeltaTable _table;
+
         bool  delta_calcAngleYZ(float x0, float y0, float z0, float& theta);
         float three_axis_dist(float* point1, float* point2);
 
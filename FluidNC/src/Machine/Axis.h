@@ -8,6 +8,7 @@
 // #include "Axes.h"
 #include "Motor.h"
 #include "Homing.h"
+#include "../InputShaper.h"
 
 namespace MotorDrivers {
     class MotorDriver;
@@ -36,6 +37,11 @@ namespace Machine {
         float _maxTravel    = 1000.0f;
         bool  _softLimits   = false;
 
+        // Input shaping, see InputShaper.h
+        int   _shaperType      = InputShaper::None;
+        float _shaperFrequency = 40.0f;  // Hz
+        float _shaperDamping   = 0.1f;
+
         // Configuration system helpers:
         void group(Configuration::HandlerBase& handler) override;
         void afterParse() override;
@@ -40,6 +40,11 @@ namespace Machine {
     std::queue<int> Homing::_remainingCycles;
     uint32_t        Homing::_settling_ms;
 
+    uint32_t Homing::_homingStart;
+    uint32_t Homing::_phaseStart;
+    uint32_t Homing::_phaseTicks[Phase::CycleDone + 1];
+    uint32_t Homing::_settleTicks;
+
     uint32_t Homing::_runs;
 
     AxisMask Homing::_unhomed_axes;  // Bitmap of axes whose position is unknown
@@ -115,13 +120,16 @@ namespace Machine {
         _phaseMotors = 0;
 
         // Advance to next cycle
-        Stepper::reset();        // Stop steppers and reset step segment buffer
-        delay_ms(_settling_ms);  // Delay to allow transient dynamics to dissipate.
+        Stepper::reset();  // Stop steppers and reset step segment buffer
 
         nextPhase();
     }
 
     void Homing::nextPhase() {
+        uint32_t now = xTaskGetTickCount();
+        _phaseTicks[_phase] += now - _phaseStart;
+        _phaseStart = now;
+
         _phase = static_cast<Phase>(static_cast<int>(_phase) + 1);
 
         if (_phase == SlowApproach && _runs == 1) {
@@ -133,6 +141,17 @@ namespace Machine {
         }
 
         log_debug("Homing nextPhase " << phaseName(_phase));
+
+        // The switch position is sampled during the slow approach, so let the
+        // machine come to rest before it starts.  Other phases either move
+        // away from the switch or only need to find it roughly, and the final
+        // position comes from the step count, so they start right away.
+        if (_phase == SlowApproach && _settling_ms) {
+            delay_ms(_settling_ms);  // Delay to allow transient dynamics to dissipate.
+            _settleTicks += xTaskGetTickCount() - _phaseStart;
+            _phaseStart = xTaskGetTickCount();
+        }
+
         if (_phase == CycleDone || (_phase == Phase::Pulloff2 && !needsPulloff2(_cycleMotors))) {
             set_mpos();
             nextCycle();
@@ -339,7 +358,6 @@ namespace Machine {
             } else {
                 // If all axes have hit their limits, this phase is complete and
                 // we can start the next one
-                delay_ms(_settling_ms);  // Delay to allow transient dynamics to dissipate.
                 nextPhase();
             }
         }
@@ -351,6 +369,8 @@ namespace Machine {
         if (sys.abort) {
             return;  // Did not complete. Alarm state set by mc_alarm.
         }
+        report_timing();
+
         // Homing cycle complete! Setup system for normal operation.
         // -------------------------------------------------------------------------------------
         // Sync gcode parser and planner positions to homed position.
@@ -390,6 +410,19 @@ namespace Machine {
         runPhase();
     }
 
+    void Homing::report_timing() {
+        uint32_t total = xTaskGetTickCount() - _homingStart;
+
+        LogStream msg(MsgLevelInfo, "[MSG:INFO: ");
+        msg << "Homing took " << total * portTICK_PERIOD_MS << "ms:";
+        for (int phase = PrePulloff; phase < CycleDone; ++phase) {
+            if (_phaseTicks[phase]) {
+                msg << " " << phaseName(static_cast<Phase>(phase)) << " " << _phaseTicks[phase] * portTICK_PERIOD_MS;
+            }
+        }
+        msg << " Settle " << _settleTicks * portTICK_PERIOD_MS;
+    }
+
     void Homing::fail(ExecAlarm alarm) {
         Stepper::reset();  // Stop moving
         send_alarm(alarm);
@@ -446,7 +479,10 @@ namespace Machine {
         mpos = get_mpos();
         log_debug("mpos transformed " << mpos[0] << "," << mpos[1] << "," << mpos[2]);
 
-        sys.step_control = {};                     // Return step control to normal operation.
+        {
+            std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+            sys.step_control = {};  // Return step control to normal operation.
+        }
         axes->set_homing_mode(_cycleAxes, false);  // tell motors homing is done
     }
 
@@ -523,6 +559,12 @@ namespace Machine {
         }
         config->_stepping->beginLowLatency();
 
+        for (auto& ticks : _phaseTicks) {
+            ticks = 0;
+        }
+        _settleTicks = 0;
+        _homingStart = _phaseStart = xTaskGetTickCount();
+
         set_state(State::Homing);
         nextCycle();
     }
@@ -61,7 +61,7 @@ namespace Machine {
         float    _mpos              = 0.0f;    // After homing this will be the mpos of the switch location
         float    _feedRate          = 50.0f;   // pulloff and second touch speed
         float    _seekRate          = 200.0f;  // this first approach speed
-        uint32_t _settle_ms         = 250;     // ms settling time for homing switches after motion
+        uint32_t _settle_ms         = 250;     // ms settling time before the slow approach
         float    _seek_scaler       = 1.1f;    // multiplied by max travel for max homing distance on first touch
         float    _feed_scaler       = 1.1f;    // multiplier to pulloff for moving to switch after pulloff
 
@@ -107,6 +107,14 @@ namespace Machine {
 
         static uint32_t _settling_ms;
 
+        // Time spent in each phase, summed over all cycles, for the report at the end
+        static uint32_t _homingStart;
+        static uint32_t _phaseStart;
+        static uint32_t _phaseTicks[Phase::CycleDone + 1];
+        static uint32_t _settleTicks;
+
+        static void report_timing();
+
         static const char* _phaseNames[];
         static const char* phaseName(Phase phase) { return _phaseNames[static_cast<int>(phase)]; }
     };
@@ -18,10 +18,13 @@ namespace Machine {
         handler.item("bck_pin", _bck);
         handler.item("data_pin", _data);
         handler.item("ws_pin", _ws);
+        handler.item("dma_buffers", _dmaBufferCount, I2S_OUT_DMABUF_COUNT_MIN, I2S_OUT_DMABUF_COUNT_MAX);
+        handler.item("dma_buffer_bytes", _dmaBufferBytes, I2S_OUT_DMABUF_LEN_MIN, I2S_OUT_DMABUF_LEN_MAX);
     }
 
     void I2SOBus::init() {
-        log_info("I2SO BCK:" << _bck.name() << " WS:" << _ws.name() << " DATA:" << _data.name());
+        log_info("I2SO BCK:" << _bck.name() << " WS:" << _ws.name() << " DATA:" << _data.name() << " DMA:" << _dmaBufferCount << "x"
+                              << _dmaBufferBytes);
         i2s_out_init();
     }
 }
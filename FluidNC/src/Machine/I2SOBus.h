@@ -5,6 +5,7 @@
 #pragma once
 
 #include "../Configuration/Configurable.h"
+#include "../I2SOut.h"  // I2S_OUT_DMABUF_*
 
 namespace Machine {
     class I2SOBus : public Configuration::Configurable {
@@ -15,6 +16,9 @@ namespace Machine {
         Pin _data;
         Pin _ws;
 
+        int _dmaBufferCount = I2S_OUT_DMABUF_COUNT;
+        int _dmaBufferBytes = I2S_OUT_DMABUF_LEN;
+
         void validate() override;
         void group(Configuration::HandlerBase& handler) override;
 
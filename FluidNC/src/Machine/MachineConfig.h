@@ -79,6 +79,7 @@ namespace Machine {
 
         float _arcTolerance      = 0.002f;
         float _junctionDeviation = 0.01f;
+        float _mergeTolerance    = 0.0f;  // Merge colinear G1 moves within this many mm; 0 to disable
         bool  _verboseErrors     = true;
         bool  _reportInches      = false;
 
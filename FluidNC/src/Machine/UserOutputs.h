@@ -27,6 +27,10 @@ namespace Machine {
         bool setDigital(size_t io_num, bool isOn);
         bool setAnalogPercent(size_t io_num, float percent);
 
+        // Check in advance whether setDigital() or setAnalogPercent() would succeed
+        bool canSetDigital(size_t io_num, bool isOn) { return !isOn || _digitalOutput[io_num].defined(); }
+        bool canSetAnalog(size_t io_num, float percent) { return percent == 0.0 || (_analogOutput[io_num].defined() && _pwm[io_num]); }
+
         ~UserOutputs();
     };
 }
@@ -14,6 +14,9 @@
 #include "I2SOut.h"          // i2s_out_reset
 #include "Platform.h"        // WEAK_LINK
 #include "Settings.h"        // coords
+#include "HeightMap.h"       // heightMap
+#include "PathBlender.h"     // PathBlender
+#include "SegmentMerger.h"   // SegmentMerger
 
 #include <cmath>
 
@@ -28,8 +31,20 @@
 // this is needed if a jogCancel comes along after we have already parsed a jog and it is in-flight.
 static volatile void* mc_pl_data_inflight;  // holds a plan_line_data_t while mc_move_motors has taken ownership of a line motion
 
+// Feed moves pass through two filters on their way to the planner, each of
+// which holds back the latest move until the next one shows what to do with it.
+static SegmentMerger    merger;  // Joins runs of nearly colinear moves
+static plan_line_data_t merge_data;
+
+static PathBlender      blender;  // Rounds corners within the G64 tolerance
+static plan_line_data_t blend_data;
+static float            blend_position[MAX_N_AXIS];
+static float            blend_tolerance = 0;
+
 void mc_init() {
     mc_pl_data_inflight = NULL;
+    merger.clear();
+    blender.clear();
 }
 
 // Execute linear motor motion in absolute millimeter coordinates. Feed rate given in
@@ -108,6 +123,7 @@ static bool mc_linear_no_check(float* target, plan_line_data_t* pl_data, float*
     return config->_kinematics->cartesian_to_motors(target, pl_data, position);
 }
 bool mc_linear(float* target, plan_line_data_t* pl_data, float* position) {
+    mc_flush_filters();
     if (!pl_data->is_jog && !pl_data->limits_checked) {  // soft limits for jogs have already been dealt with
         if (config->_kinematics->invalid_line(target)) {
             return false;
@@ -116,6 +132,113 @@ bool mc_linear(float* target, plan_line_data_t* pl_data, float* position) {
     return mc_linear_no_check(target, pl_data, position);
 }
 
+// Moves along the held move to point.  The kinematics can alter the data and
+// the positions, so they get copies.
+static void mc_blend_to(float* point) {
+    float            target[MAX_N_AXIS], position[MAX_N_AXIS];
+    plan_line_data_t data = blend_data;
+    copyAxes(target, point);
+    copyAxes(position, blend_position);
+    mc_linear_no_check(target, &data, position);
+    copyAxes(blend_position, target);
+}
+
+static bool same_block_data(const plan_line_data_t& a, const plan_line_data_t& b) {
+    return a.feed_rate == b.feed_rate && a.spindle_speed == b.spindle_speed && a.spindle == b.spindle &&
+           a.coolant.Mist == b.coolant.Mist && a.coolant.Flood == b.coolant.Flood && a.motion.rapidMotion == b.motion.rapidMotion &&
+           a.motion.noFeedOverride == b.motion.noFeedOverride;
+}
+
+static void mc_flush_blend() {
+    float end[MAX_N_AXIS];
+    if (blender.flush(end)) {
+        mc_blend_to(end);
+    }
+}
+
+// The second filter stage rounds the corners between moves in G64
+static void mc_blend(float* start, float* end, const plan_line_data_t& data) {
+    if (blender.held() && (blend_tolerance <= 0 || !same_block_data(blend_data, data))) {
+        mc_flush_blend();
+    }
+    if (blend_tolerance <= 0) {
+        blend_data = data;
+        copyAxes(blend_position, start);
+        mc_blend_to(end);
+        return;
+    }
+    if (!blender.held()) {
+        copyAxes(blend_position, start);
+    }
+    blender.setAxes(config->_axes->_numberAxis);
+
+    PathBlender::Points points;
+    blender.add(start, end, blend_tolerance, points);
+    for (size_t i = 0; i < points.count && !sys.abort; i++) {
+        mc_blend_to(points.point[i]);
+    }
+    blend_data = data;
+}
+
+static void mc_flush_merge() {
+    float start[MAX_N_AXIS], end[MAX_N_AXIS];
+    if (merger.flush(start, end)) {
+        mc_blend(start, end, merge_data);
+    }
+}
+
+bool mc_linear_filtered(float* target, plan_line_data_t* pl_data, float* position, float tolerance) {
+    if (pl_data->motion.inverseTime || pl_data->motion.systemMotion || pl_data->is_jog) {
+        return mc_linear(target, pl_data, position);
+    }
+    if (!pl_data->limits_checked && config->_kinematics->invalid_line(target)) {
+        mc_flush_filters();
+        return false;
+    }
+    blend_tolerance = tolerance;
+
+    // The first stage merges runs of nearly colinear moves.  A merged move
+    // reports the line number of its first move, so a job restarted from
+    // the reported line does not skip any of it.
+    float merge_tolerance = config->_mergeTolerance;
+    if (merger.held() && (merge_tolerance <= 0 || !same_block_data(merge_data, *pl_data))) {
+        mc_flush_merge();
+    }
+    if (merge_tolerance <= 0) {
+        mc_blend(position, target, *pl_data);
+        return true;
+    }
+    if (!merger.held()) {
+        merge_data = *pl_data;
+    }
+    merger.setAxes(config->_axes->_numberAxis);
+
+    float start[MAX_N_AXIS], end[MAX_N_AXIS];
+    if (merger.add(position, target, merge_tolerance, start, end)) {
+        mc_blend(start, end, merge_data);
+        merge_data = *pl_data;
+    }
+    return true;
+}
+
+void mc_flush_filters() {
+    mc_flush_merge();
+    mc_flush_blend();
+}
+
+void mc_filters_poll() {
+    // Once the planner is down to its last block, waiting for the next move costs more speed than the filters gain
+    if ((merger.held() || blender.held()) && plan_get_block_buffer_available() >= config->_planner_blocks - 2) {
+        mc_flush_filters();
+    }
+}
+
+void mc_merge_stats(uint32_t& moves, uint32_t& blocks) {
+    moves  = merger.moves();
+    blocks = merger.blocks();
+    merger.clearStats();
+}
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, isclockwise boolean. Used
@@ -338,8 +461,7 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away,
     probing = false;              // Ensure probe state monitor is disabled.
     protocol_execute_realtime();  // Check and execute run-time commands
     // Reset the stepper and planner buffers to remove the remainder of the probe motion.
-    Stepper::reset();      // Reset step segment buffer.
-    plan_reset();          // Reset planner buffer. Zero planner positions. Ensure probing motion is cleared.
+    Stepper::flush();      // Reset step segment and planner buffers. Zero planner positions. Ensure probing motion is cleared.
     plan_sync_position();  // Sync planner position to current machine position.
     if (MESSAGE_PROBE_COORDINATES) {
         // All done! Output the probe position as message.
@@ -374,6 +496,80 @@ GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away,
     }
 }
 
+// Probe a grid of points and record the contact heights in heightMap.
+// The corners are in machine coordinates.  Points are visited in
+// serpentine order so each travel move is one grid step, and between
+// points the probe lifts only retract mm above the last contact, so
+// the surface must not rise by more than that from one point to the next.
+// Each probe starts at the travel height and moves down at most depth mm.
+Error mc_probe_grid(float x0, float y0, float x1, float y1, size_t nx, size_t ny, float feed_rate, float depth, float retract) {
+    if (!heightMap.setup(x0, y0, x1, y1, nx, ny)) {
+        return Error::InvalidValue;
+    }
+
+    plan_line_data_t  plan_data;
+    plan_line_data_t* pl_data = &plan_data;
+    memset(pl_data, 0, sizeof(plan_line_data_t));
+    pl_data->spindle_speed = gc_state.spindle_speed;
+    pl_data->spindle       = gc_state.modal.spindle;
+    pl_data->coolant       = gc_state.modal.coolant;
+
+    float target[MAX_N_AXIS];
+    copyAxes(target, gc_state.position);
+    float start_z = target[Z_AXIS];
+
+    for (size_t n = 0; n < heightMap.points(); n++) {
+        size_t i, j;
+        heightMap.point(n, i, j);
+
+        // Travel to the point at the current height
+        target[X_AXIS]                 = heightMap.x(i);
+        target[Y_AXIS]                 = heightMap.y(j);
+        pl_data->motion.rapidMotion    = 1;
+        pl_data->motion.noFeedOverride = 0;
+        if (!mc_linear(target, pl_data, gc_state.position)) {
+            heightMap.clear();
+            return sys.abort ? Error::Reset : Error::SoftLimitError;
+        }
+        copyAxes(gc_state.position, target);
+
+        // mc_probe_cycle() waits for the travel move to finish
+        target[Z_AXIS] -= depth;
+        pl_data->motion.rapidMotion    = 0;
+        pl_data->motion.noFeedOverride = 1;
+        pl_data->feed_rate             = feed_rate;
+        GCUpdatePos result             = mc_probe_cycle(target, pl_data, false, false, 0, __FLT_MAX__);
+        gc_sync_position();
+        if (result != GCUpdatePos::System || sys.abort) {
+            // A probe that made no contact has raised an alarm
+            heightMap.clear();
+            return sys.abort ? Error::Reset : Error::SystemGcLock;
+        }
+
+        float contact[MAX_N_AXIS];
+        motor_steps_to_mpos(contact, probe_steps);
+        heightMap.set(i, j, contact[Z_AXIS]);
+
+        copyAxes(target, gc_state.position);
+        target[Z_AXIS]              = contact[Z_AXIS] + retract;
+        pl_data->motion.rapidMotion = 1;
+        if (!mc_linear(target, pl_data, gc_state.position)) {
+            heightMap.clear();
+            return sys.abort ? Error::Reset : Error::SoftLimitError;
+        }
+        copyAxes(gc_state.position, target);
+    }
+
+    // Return to the starting height
+    if (target[Z_AXIS] < start_z) {
+        target[Z_AXIS] = start_z;
+        mc_linear(target, pl_data, gc_state.position);
+        copyAxes(gc_state.position, target);
+    }
+    protocol_buffer_synchronize();
+    return sys.abort ? Error::Reset : Error::Ok;
+}
+
 void mc_override_ctrl_update(Override override_state) {
     // Finish all queued commands before altering override control state
     protocol_buffer_synchronize();
@@ -9,6 +9,7 @@
 #include "Planner.h"
 #include "Config.h"
 #include "Probe.h"
+#include "Error.h"
 
 #include <cstdint>
 
@@ -22,6 +23,21 @@ const int PARKING_MOTION_LINE_NUMBER = 0;
 // Execute a linear motion in cartesian space.
 bool mc_linear(float* target, plan_line_data_t* pl_data, float* position);
 
+// Execute a G1 linear motion.  Runs of nearly colinear motions are merged into one, within
+// the merge_tolerance_mm config item, and with a nonzero tolerance in mm (G64) the corners
+// between them are rounded.  The latest motion is held back until the next one, or until
+// mc_flush_filters() sends it.
+bool mc_linear_filtered(float* target, plan_line_data_t* pl_data, float* position, float tolerance);
+
+// Sends the motion held back by mc_linear_filtered() to the planner.
+void mc_flush_filters();
+
+// Sends the held motion if the planner is about to run out of motion.
+void mc_filters_poll();
+
+// Gets and clears the numbers of motions into and out of the merge filter
+void mc_merge_stats(uint32_t& moves, uint32_t& blocks);
+
 // Execute a linear motion in motor space.
 bool mc_move_motors(float* target, plan_line_data_t* pl_data);  // returns true if line was submitted to planner
 
@@ -46,6 +62,10 @@ bool mc_dwell(int32_t milliseconds);
 // Perform tool length probe cycle. Requires probe switch.
 GCUpdatePos mc_probe_cycle(float* target, plan_line_data_t* pl_data, bool away, bool no_error, uint8_t offsetAxis, float offset);
 
+// Probe a grid of surface heights into heightMap. Requires probe switch.
+// On failure the map is left empty and the error says why.
+Error mc_probe_grid(float x0, float y0, float x1, float y1, size_t nx, size_t ny, float feed_rate, float depth, float retract);
+
 // Handles updating the override control state.
 void mc_override_ctrl_update(Override override_state);
 
@@ -16,9 +16,13 @@
 #include "Dynamixel2.h"
 
 #include "../Machine/MachineConfig.h"
-#include "../System.h"   // mpos_to_steps() etc
-#include "../Limits.h"   // limitsMinPosition
-#include "../Planner.h"  // plan_sync_position()
+#include "../System.h"    // mpos_to_steps() etc
+#include "../Limits.h"    // limitsMinPosition
+#include "../Planner.h"   // plan_sync_position()
+#include "../Settings.h"  // UserCommand
+#include "../Stepper.h"   // Stepper::prep_mutex
+
+#include "Driver/delay_usecs.h"  // getCpuTicks()
 
 #include <cstdarg>
 #include <cmath>
@@ -31,6 +35,31 @@ namespace MotorDrivers {
 
     int Dynamixel2::_timer_ms = 75;
 
+    uint32_t   Dynamixel2::_stat_updates  = 0;
+    uint32_t   Dynamixel2::_stat_tx_bytes = 0;
+    uint32_t   Dynamixel2::_stat_rx_bytes = 0;
+    uint32_t   Dynamixel2::_stat_timeouts = 0;
+    uint32_t   Dynamixel2::_stat_busy_us  = 0;
+    uint32_t   Dynamixel2::_stat_max_us   = 0;
+    TickType_t Dynamixel2::_stat_start    = 0;
+
+    std::mutex   Dynamixel2::_bus_mutex;
+    TaskHandle_t Dynamixel2::_read_task = nullptr;
+
+    // Reading positions waits for servo replies, so it runs in its own task
+    // rather than in the timer service task or the protocol task
+    void Dynamixel2::read_task(void* unused) {
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            read_positions();
+        }
+    }
+
+    static Error showDynamixelStats(const char* value, AuthenticationLevel auth_level, Channel& out) {
+        Dynamixel2::show_stats(out);
+        return Error::Ok;
+    }
+
     uint8_t Dynamixel2::_tx_message[100];  // send to dynamixel
     uint8_t Dynamixel2::_rx_message[50];   // received from dynamixel
     uint8_t Dynamixel2::_msg_index = 0;    // Current length of message being constructed
@@ -53,7 +82,18 @@ namespace MotorDrivers {
                 return;
             }
             _uart_started = true;
+            _stat_start   = xTaskGetTickCount();
+            xTaskCreatePinnedToCore(read_task,          // task
+                                    "dxlRead",          // name for task
+                                    4096,               // size of task stack
+                                    nullptr,            // parameters
+                                    1,                  // priority
+                                    &_read_task,        // handle
+                                    SUPPORT_TASK_CORE  // core
+            );
             schedule_update(this, _timer_ms);
+
+            new AsyncUserCommand(NULL, "Dynamixel/Stats", showDynamixelStats, anyState);
         }
 
         config_message();  // print the config
@@ -127,12 +167,71 @@ namespace MotorDrivers {
         finish_write();
     }
 
-    // This is static; it updates the positions of all the Dynamixels on the UART bus
+    // This is static; it updates the positions of all the Dynamixels on the UART bus.
+    // Enabled servos get their goal positions in one Sync Write packet and
+    // disabled servos, which can be moved by hand, report their present
+    // positions in response to one Sync Read packet, so the bus time per
+    // tick is one transaction in each direction regardless of the servo count.
+    // This runs in the timer service task, so it only writes; the read is
+    // handed to the reader task.
     void Dynamixel2::update_all() {
         if (_has_errors) {
             return;
         }
 
+        // Skip this tick if the reader task is waiting for replies
+        if (!_bus_mutex.try_lock()) {
+            return;
+        }
+        int32_t start_ticks = getCpuTicks();
+        sync_write_positions();
+        record_transaction(start_ticks);
+        _bus_mutex.unlock();
+
+        for (const auto& instance : _instances) {
+            if (instance->_disabled) {
+                xTaskNotifyGive(_read_task);
+                break;
+            }
+        }
+    }
+
+    void Dynamixel2::read_positions() {
+        uint32_t reported;
+        {
+            std::lock_guard<std::mutex> lock(_bus_mutex);
+            int32_t                     start_ticks = getCpuTicks();
+            reported                                = sync_read_positions();
+            record_transaction(start_ticks);
+        }
+        if (!reported) {
+            return;
+        }
+
+        // Publish the positions under the stepper lock. The planner position
+        // can only follow the servos while it has no motion queued.
+        std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+        if (plan_get_current_block()) {
+            return;
+        }
+        for (size_t i = 0; i < _instances.size() && i < 32; i++) {
+            if (bitnum_is_true(reported, i)) {
+                _instances[i]->set_position_from_count(_instances[i]->_present_count);
+            }
+        }
+        plan_sync_position();
+    }
+
+    void Dynamixel2::record_transaction(int32_t start_ticks) {
+        uint32_t elapsed_us = uint32_t(getCpuTicks() - start_ticks) / ticks_per_us;
+        _stat_busy_us += elapsed_us;
+        if (elapsed_us > _stat_max_us) {
+            _stat_max_us = elapsed_us;
+        }
+        ++_stat_updates;
+    }
+
+    void Dynamixel2::sync_write_positions() {
         start_message(DXL_BROADCAST_ID, DXL_SYNC_WRITE);
         add_uint16(DXL_GOAL_POSITION);
         add_uint16(4);  // data length
@@ -141,7 +240,12 @@ namespace MotorDrivers {
         float  motors[MAX_N_AXIS];
         config->_kinematics->transform_cartesian_to_motors(motors, mpos);
 
+        size_t n_servos = 0;
         for (const auto& instance : _instances) {
+            if (instance->_disabled) {
+                continue;
+            }
+
             float    dxl_count_min, dxl_count_max;
             uint32_t dxl_position;
 
@@ -155,9 +259,84 @@ namespace MotorDrivers {
 
             add_uint8(instance->_id);  // ID of the servo
             add_uint32(dxl_position);
+            ++n_servos;
+        }
+        if (n_servos) {
+            finish_message();
+        }
+    }
+
+    // Returns a mask of the _instances entries whose _present_count was updated
+    uint32_t Dynamixel2::sync_read_positions() {
+        start_message(DXL_BROADCAST_ID, DXL_SYNC_READ);
+        add_uint16(DXL_PRESENT_POSITION);
+        add_uint16(4);  // data length
+
+        // Remember which servos were asked, since _disabled can change
+        // from another task while the replies are arriving.
+        uint32_t asked = 0;
+        for (size_t i = 0; i < _instances.size() && i < 32; i++) {
+            if (_instances[i]->_disabled) {
+                add_uint8(_instances[i]->_id);
+                set_bitnum(asked, i);
+            }
+        }
+        if (!asked) {
+            return 0;
         }
         finish_message();
+
+        // The servos reply with one status packet each, in the order of the ID list
+        uint32_t reported = 0;
+        for (size_t i = 0; i < _instances.size() && i < 32; i++) {
+            if (!bitnum_is_true(asked, i)) {
+                continue;
+            }
+            auto instance = _instances[i];
+            if (dxl_get_response(POSITION_RSP_LEN) != POSITION_RSP_LEN) {
+                ++_stat_timeouts;
+                break;
+            }
+            if (_rx_message[DXL_MSG_ID] != instance->_id || _rx_message[DXL_MSG_START]) {
+                continue;  // out of order reply or servo error
+            }
+            uint32_t dxl_position = _rx_message[9] | (_rx_message[10] << 8) | (_rx_message[11] << 16) | (_rx_message[12] << 24);
+            instance->_present_count = dxl_position;
+            set_bitnum(reported, i);
+        }
+        return reported;
+    }
+
+    void Dynamixel2::show_stats(Channel& out) {
+        TickType_t now        = xTaskGetTickCount();
+        uint32_t   elapsed_ms = (now - _stat_start) * portTICK_PERIOD_MS;
+        uint32_t   updates    = _stat_updates;
+
+        if (!_uart_started || !elapsed_ms) {
+            log_info_to(out, "Dynamixel: bus not active");
+            return;
+        }
+
+        // Bus utilization is the fraction of wall time spent in bus transactions,
+        // including the time waiting for servo replies
+        uint32_t busy_pct = _stat_busy_us / (elapsed_ms * 10);
+        log_info_to(out,
+                    "Dynamixel: servos:" << _instances.size() << " transactions:" << updates << " in " << elapsed_ms << "ms"
+                                         << " tx:" << _stat_tx_bytes << " rx:" << _stat_rx_bytes << " timeouts:" << _stat_timeouts);
+        log_info_to(out,
+                    "Dynamixel: transaction avg:" << (updates ? _stat_busy_us / updates : 0) << "us max:" << _stat_max_us
+                                                  << "us bus utilization:" << busy_pct << "%");
+
+        // Restart the measurement window
+        _stat_updates  = 0;
+        _stat_tx_bytes = 0;
+        _stat_rx_bytes = 0;
+        _stat_timeouts = 0;
+        _stat_busy_us  = 0;
+        _stat_max_us   = 0;
+        _stat_start    = now;
     }
+
     void Dynamixel2::update() {
         update_all();
     }
@@ -208,7 +387,7 @@ namespace MotorDrivers {
         uint16_t msg_len = _msg_index - DXL_MSG_INSTR + 2;
 
         _tx_message[DXL_MSG_LEN_L] = msg_len & 0xff;
-        _tx_message[DXL_MSG_LEN_H] = (msg_len >> 8) * 0xff;
+        _tx_message[DXL_MSG_LEN_H] = (msg_len >> 8) & 0xff;
 
         uint16_t crc = 0;
         crc          = dxl_update_crc(crc, _tx_message, _msg_index);
@@ -217,6 +396,7 @@ namespace MotorDrivers {
 
         _uart->flushRx();
         _uart->write(_tx_message, _msg_index);
+        _stat_tx_bytes += _msg_index;
 
         //hex_msg(_tx_message, "0x", _msg_index);
     }
@@ -232,19 +412,12 @@ namespace MotorDrivers {
 
         dxl_read(DXL_PRESENT_POSITION, data_len);
 
-        data_len = dxl_get_response(15);
+        data_len = dxl_get_response(POSITION_RSP_LEN);
 
-        if (data_len == 15) {
+        if (data_len == POSITION_RSP_LEN) {
             uint32_t dxl_position = _rx_message[9] | (_rx_message[10] << 8) | (_rx_message[11] << 16) | (_rx_message[12] << 24);
 
-            auto axis = config->_axes->_axis[_axis_index];
-
-            uint32_t pos_min_steps = mpos_to_steps(limitsMinPosition(_axis_index), _axis_index);
-            uint32_t pos_max_steps = mpos_to_steps(limitsMaxPosition(_axis_index), _axis_index);
-
-            uint32_t temp = myMap(dxl_position, _countMin, _countMax, pos_min_steps, pos_max_steps);
-
-            set_motor_steps(_axis_index, temp);
+            set_position_from_count(dxl_position);
 
             plan_sync_position();
 
@@ -254,6 +427,16 @@ namespace MotorDrivers {
         }
     }
 
+    // map the servo count range back to the motor step range
+    void Dynamixel2::set_position_from_count(uint32_t dxl_position) {
+        int32_t pos_min_steps = mpos_to_steps(limitsMinPosition(_axis_index), _axis_index);
+        int32_t pos_max_steps = mpos_to_steps(limitsMaxPosition(_axis_index), _axis_index);
+
+        int32_t temp = myMap(int32_t(dxl_position), int32_t(_countMin), int32_t(_countMax), pos_min_steps, pos_max_steps);
+
+        set_motor_steps(_axis_index, temp);
+    }
+
     void Dynamixel2::dxl_read(uint16_t address, uint16_t data_len) {
         start_message(_id, DXL_READ);
         add_uint16(address);
@@ -277,7 +460,9 @@ namespace MotorDrivers {
 
     // wait for and get the servo response
     size_t Dynamixel2::dxl_get_response(uint16_t length) {
-        return _uart->timedReadBytes((char*)_rx_message, length, DXL_RESPONSE_WAIT_TICKS);
+        size_t len = _uart->timedReadBytes((char*)_rx_message, length, DXL_RESPONSE_WAIT_TICKS);
+        _stat_rx_bytes += len;
+        return len;
     }
 
     void Dynamixel2::show_status() {
@@ -13,6 +13,9 @@
 #include "../Uart.h"
 
 #include <cstdint>
+#include <mutex>
+
+class Channel;
 
 namespace MotorDrivers {
     class Dynamixel2 : public Servo {
@@ -25,6 +28,24 @@ namespace MotorDrivers {
 
         static int _timer_ms;
 
+        // Bus statistics, reported by $Dynamixel/Stats
+        static uint32_t   _stat_updates;
+        static uint32_t   _stat_tx_bytes;
+        static uint32_t   _stat_rx_bytes;
+        static uint32_t   _stat_timeouts;
+        static uint32_t   _stat_busy_us;
+        static uint32_t   _stat_max_us;
+        static TickType_t _stat_start;
+
+        static std::mutex   _bus_mutex;  // Held by whichever task is using the bus
+        static TaskHandle_t _read_task;  // Waits for Sync Read replies
+
+        uint32_t _present_count = 0;  // Last position reported by a Sync Read
+
+        static void read_task(void* unused);
+
+        static void record_transaction(int32_t start_ticks);
+
         static uint8_t _tx_message[100];  // outgoing to dynamixel
         static uint8_t _msg_index;
         static uint8_t _rx_message[50];  // received from dynamixel
@@ -42,12 +63,16 @@ namespace MotorDrivers {
         bool     test();
         uint32_t dxl_read_position();
         void     dxl_read(uint16_t address, uint16_t data_len);
+        void     set_position_from_count(uint32_t dxl_position);
+
+        static void sync_write_positions();
+        static uint32_t sync_read_positions();
 
         void dxl_goal_position(int32_t position);  // set one motor
         void set_operating_mode(uint8_t mode);
         void LED_on(bool on);
 
-        size_t dxl_get_response(uint16_t length);
+        static size_t dxl_get_response(uint16_t length);
 
         static uint16_t dxl_update_crc(uint16_t crc_accum, uint8_t* data_blk_ptr, uint8_t data_blk_size);
 
@@ -79,12 +104,14 @@ namespace MotorDrivers {
         static const int DXL_BROADCAST_ID = 0xFE;
 
         // protocol 2 instruction numbers
-        static const int  DXL_INSTR_PING = 0x01;
-        static const char DXL_REBOOT     = char(0x08);
-        static const int  PING_RSP_LEN   = 14;
-        static const char DXL_READ       = char(0x02);
-        static const char DXL_WRITE      = char(0x03);
-        static const char DXL_SYNC_WRITE = char(0x83);
+        static const int  DXL_INSTR_PING   = 0x01;
+        static const char DXL_REBOOT       = char(0x08);
+        static const int  PING_RSP_LEN     = 14;
+        static const int  POSITION_RSP_LEN = 15;
+        static const char DXL_READ         = char(0x02);
+        static const char DXL_WRITE        = char(0x03);
+        static const char DXL_SYNC_READ    = char(0x82);
+        static const char DXL_SYNC_WRITE   = char(0x83);
 
         // protocol 2 register locations
         static const int DXL_OPERATING_MODE   = 11;
@@ -112,6 +139,8 @@ namespace MotorDrivers {
         void        set_disable(bool disable) override;
         void        update() override;
         static void update_all();
+        static void read_positions();
+        static void show_stats(Channel& out);
         void        config_motor() override;
 
         // Configuration handlers:
@@ -0,0 +1,9 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// The most axes that a machine can have.  This is apart from Config.h so
+// that the classes built by the native unit tests can size their arrays
+// with it.
+const int MAX_N_AXIS = 6;
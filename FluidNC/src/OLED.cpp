@@ -1,6 +1,13 @@
 #include "OLED.h"
 
 #include "Machine/MachineConfig.h"
+#include "Machine/Axes.h"         // motor_bit()
+#include "Report.h"               // state_name(), mpos_to_wpos()
+#include "SettingsDefinitions.h"  // status_mask
+#include "Limits.h"               // limits_get_state()
+#include "Job.h"                  // Job::channel()
+
+#include <algorithm>
 
 void OLED::show(Layout& layout, const char* msg) {
     if (_width < layout._width_required) {
@@ -79,45 +86,169 @@ void OLED::init() {
     }
     _oled->setTextAlignment(TEXT_ALIGN_LEFT);
 
-    _oled->clear();
+    _frameSize = _oled->frameSize();
+    _pending   = new uint8_t[_frameSize];
+    _sending   = new uint8_t[_frameSize];
+    _shown     = new uint8_t[_frameSize];
+    _lineQueue = xQueueCreate(4, lineMax);
+
+    xTaskCreatePinnedToCore(flushTask,         // task
+                            "oled",            // name for task
+                            3072,              // size of task stack
+                            this,              // parameters
+                            1,                 // priority - same as the poller
+                            &_flushTask,       // task handle
+                            SUPPORT_TASK_CORE  // core
+    );
 
+    _oled->clear();
     show((_width == 128) ? bannerLayout128 : bannerLayout64, "FluidNC");
-
-    _oled->display();
+    queueFrame();
 
     allChannels.registration(this);
     setReportInterval(_report_interval_ms);
 }
 
+// Hand the rendered frame to the flush task.  Only the copy is done
+// under the lock, so the poller never waits for the I2C bus.
+void OLED::queueFrame() {
+    portENTER_CRITICAL(&_frameLock);
+    memcpy(_pending, _oled->frame(), _frameSize);
+    portEXIT_CRITICAL(&_frameLock);
+    xTaskNotifyGive(_flushTask);
+}
+
+void OLED::flushTask(void* arg) {
+    static_cast<OLED*>(arg)->flushFrames();
+}
+
+// If several frames are queued while a transfer is in progress, only
+// the latest one is sent.
+void OLED::flushFrames() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        portENTER_CRITICAL(&_frameLock);
+        memcpy(_sending, _pending, _frameSize);
+        portEXIT_CRITICAL(&_frameLock);
+
+        _oled->displayChanges(_sending, _shown, _fullUpdate);
+        _fullUpdate = false;
+    }
+}
+
 Error OLED::pollLine(char* line) {
     autoReport();
     return Error::NoData;
 }
 
+bool OLED::Status::operator==(const Status& o) const {
+    return state == o.state && !memcmp(axes, o.axes, sizeof(axes)) && isMpos == o.isMpos && probe == o.probe &&
+           !memcmp(limits, o.limits, sizeof(limits)) && percent == o.percent && filename == o.filename;
+}
+
+void OLED::take_snapshot(Status& status) {
+    status.state = state_name();
+
+    float* position = get_mpos();
+    status.isMpos   = bits_are_true(status_mask->get(), RtStatus::Position);
+    if (!status.isMpos) {
+        mpos_to_wpos(position);
+    }
+    auto n_axis = config->_axes->_numberAxis;
+    copyAxes(status.axes, position);
+
+    status.probe            = config->_probe->get_state();
+    MotorMask lim_pin_state = limits_get_state();
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        status.limits[axis] = bitnum_is_true(lim_pin_state, Machine::Axes::motor_bit(axis, 0)) ||
+                              bitnum_is_true(lim_pin_state, Machine::Axes::motor_bit(axis, 1));
+    }
+
+    Channel* job = Job::active() ? Job::channel() : nullptr;
+    if (job && job->_percent >= 0) {
+        status.percent  = job->_percent;
+        status.filename = job->name();
+    } else {
+        status.percent = -1;
+        status.filename.clear();
+    }
+}
+
+// Called from the polling loop.  A new frame is rendered only when the
+// machine state or the message screen has changed since the last one.
+void OLED::autoReport() {
+    if (!_reportInterval) {
+        return;
+    }
+
+    char buf[lineMax];
+    while (xQueueReceive(_lineQueue, buf, 0)) {
+        parse_line(buf);
+        _redraw = true;
+    }
+
+    int32_t now = xTaskGetTickCount();
+    if (_message[0].length() && (now - _messageEnd) >= 0) {
+        _message[0].clear();
+        _message[1].clear();
+        _redraw = true;
+    }
+
+    if (!_redraw && (now - _nextReportTime) < 0) {
+        return;
+    }
+    _nextReportTime = now + _reportInterval;
+
+    Status status;
+    take_snapshot(status);
+    if (!_redraw && status == _status) {
+        return;
+    }
+    _status = status;
+    _redraw = false;
+    render();
+}
+
+void OLED::render() {
+    _oled->clear();
+    if (_message[0].length()) {
+        auto fh = font_height(ArialMT_Plain_10);
+        wrapped_draw_string(0, _message[0], ArialMT_Plain_10);
+        wrapped_draw_string(fh * 2, _message[1], ArialMT_Plain_10);
+    } else {
+        show_state();
+        show_file();
+        show_limits();
+        show_dro();
+        show_radio_info();
+    }
+    queueFrame();
+}
+
 void OLED::show_state() {
-    show(stateLayout, _state);
+    show(stateLayout, _status.state);
 }
 
-void OLED::show_limits(bool probe, const bool* limits) {
+void OLED::show_limits() {
     if (_width != 128) {
         return;
     }
-    if (_filename.length() != 0) {
+    if (_status.filename.length() != 0) {
         return;
     }
-    if (_state == "Alarm") {
+    if (_status.state == "Alarm") {
         return;
     }
     for (uint8_t axis = X_AXIS; axis < 3; axis++) {
-        draw_checkbox(80, 27 + (axis * 10), 7, 7, limits[axis]);
+        draw_checkbox(80, 27 + (axis * 10), 7, 7, _status.limits[axis]);
     }
 }
 void OLED::show_file() {
-    int pct = int(_percent);
-    if (_filename.length() == 0) {
+    int pct = int(_status.percent);
+    if (_status.filename.length() == 0) {
         return;
     }
-    if (_state != "Run" && pct == 100) {
+    if (_status.state != "Run" && pct == 100) {
         // This handles the case where the system returns to idle
         // but shows one last SD report
         return;
@@ -131,18 +262,18 @@ void OLED::show_file() {
         }
         show(tickerLayout, _ticker);
 
-        wrapped_draw_string(14, _filename, ArialMT_Plain_16);
+        wrapped_draw_string(14, _status.filename, ArialMT_Plain_16);
 
         _oled->drawProgressBar(0, 45, 120, 10, pct);
     } else {
         show(percentLayout64, std::to_string(pct) + '%');
     }
 }
-void OLED::show_dro(const float* axes, bool isMpos, bool* limits) {
-    if (_state == "Alarm") {
+void OLED::show_dro() {
+    if (_status.state == "Alarm") {
         return;
     }
-    if (_width == 128 && _filename.length()) {
+    if (_width == 128 && _status.filename.length()) {
         // wide displays will show a progress bar instead of DROs
         return;
     }
@@ -151,7 +282,7 @@ void OLED::show_dro(const float* axes, bool isMpos, bool* limits) {
     char axisVal[20];
 
     show(limitLabelLayout, "L");
-    show(posLabelLayout, isMpos ? "M Pos" : "W Pos");
+    show(posLabelLayout, _status.isMpos ? "M Pos" : "W Pos");
 
     _oled->setFont(ArialMT_Plain_10);
     uint8_t oled_y_pos;
@@ -164,339 +295,124 @@ void OLED::show_dro(const float* axes, bool isMpos, bool* limits) {
         } else {
             // For small displays there isn't room for separate limit boxes
             // so we put it after the label
-            axis_msg += limits[axis] ? "L" : ":";
+            axis_msg += _status.limits[axis] ? "L" : ":";
         }
         _oled->setTextAlignment(TEXT_ALIGN_LEFT);
         _oled->drawString(0, oled_y_pos, axis_msg.c_str());
 
         _oled->setTextAlignment(TEXT_ALIGN_RIGHT);
-        snprintf(axisVal, 20 - 1, "%.3f", axes[axis]);
+        snprintf(axisVal, 20 - 1, "%.3f", _status.axes[axis]);
         _oled->drawString((_width == 128) ? 60 : 63, oled_y_pos, axisVal);
     }
-    _oled->display();
 }
 
 void OLED::show_radio_info() {
-    if (_filename.length()) {
+    if (_status.filename.length()) {
         return;
     }
     if (_width == 128) {
-        if (_state == "Alarm") {
+        if (_status.state == "Alarm") {
             wrapped_draw_string(18, _radio_info, ArialMT_Plain_10);
             wrapped_draw_string(30, _radio_addr, ArialMT_Plain_10);
-        } else if (_state != "Run") {
+        } else if (_status.state != "Run") {
             show(radioAddrLayout, _radio_addr);
         }
     } else {
-        if (_state == "Alarm") {
+        if (_status.state == "Alarm") {
             wrapped_draw_string(10, _radio_info, ArialMT_Plain_10);
             wrapped_draw_string(28, _radio_addr, ArialMT_Plain_10);
         }
     }
 }
 
-void OLED::parse_numbers(std::string s, float* nums, int maxnums) {
-    size_t pos     = 0;
-    size_t nextpos = -1;
-    size_t i       = 0;
-    do {
-        if (i >= maxnums) {
-            return;
-        }
-        nextpos   = s.find_first_of(",", pos);
-        auto num  = s.substr(pos, nextpos - pos);
-        nums[i++] = std::strtof(num.c_str(), nullptr);
-        pos       = nextpos + 1;
-    } while (nextpos != std::string::npos);
-}
-
-void OLED::parse_axes(std::string s, float* axes) {
-    size_t pos     = 0;
-    size_t nextpos = -1;
-    size_t axis    = 0;
-    do {
-        nextpos  = s.find_first_of(",", pos);
-        auto num = s.substr(pos, nextpos - pos);
-        if (axis < MAX_N_AXIS) {
-            axes[axis++] = std::strtof(num.c_str(), nullptr);
-        }
-        pos = nextpos + 1;
-    } while (nextpos != std::string::npos);
-}
-
-void OLED::parse_status_report() {
-    if (_report.back() == '>') {
-        _report.pop_back();
-    }
-    // Now the string is a sequence of field|field|field
-    size_t pos     = 0;
-    auto   nextpos = _report.find_first_of("|", pos);
-    _state         = _report.substr(pos + 1, nextpos - pos - 1);
-
-    bool probe              = false;
-    bool limits[MAX_N_AXIS] = { false };
-
-    float axes[MAX_N_AXIS];
-    bool  isMpos = false;
-    _filename    = "";
-
-    // ... handle it
-    while (nextpos != std::string::npos) {
-        pos        = nextpos + 1;
-        nextpos    = _report.find_first_of("|", pos);
-        auto field = _report.substr(pos, nextpos - pos);
-        // MPos:, WPos:, Bf:, Ln:, FS:, Pn:, WCO:, Ov:, A:, SD: (ISRs:, Heap:)
-        auto colon = field.find_first_of(":");
-        auto tag   = field.substr(0, colon);
-        auto value = field.substr(colon + 1);
-        if (tag == "MPos") {
-            // x,y,z,...
-            parse_axes(value, axes);
-            isMpos = true;
-            continue;
-        }
-        if (tag == "WPos") {
-            // x,y,z...
-            parse_axes(value, axes);
-            isMpos = false;
-            continue;
-        }
-        if (tag == "Bf") {
-            // buf_avail,rx_avail
-            continue;
-        }
-        if (tag == "Ln") {
-            // n
-            auto linenum = std::strtol(value.c_str(), nullptr, 10);
-            continue;
-        }
-        if (tag == "FS") {
-            // feedrate,spindle_speed
-            float fs[2];
-            parse_numbers(value, fs, 2);  // feed in [0], spindle in [1]
-            continue;
-        }
-        if (tag == "Pn") {
-            // PXxYy etc
-            for (char const& c : value) {
-                switch (c) {
-                    case 'P':
-                        probe = true;
-                        break;
-                    case 'X':
-                        limits[X_AXIS] = true;
-                        break;
-                    case 'Y':
-                        limits[Y_AXIS] = true;
-                        break;
-                    case 'Z':
-                        limits[Z_AXIS] = true;
-                        break;
-                    case 'A':
-                        limits[A_AXIS] = true;
-                        break;
-                    case 'B':
-                        limits[B_AXIS] = true;
-                        break;
-                    case 'C':
-                        limits[C_AXIS] = true;
-                        break;
-                }
-                continue;
-            }
-        }
-        if (tag == "WCO") {
-            // x,y,z,...
-            // We do not use the WCO values because the DROs show whichever
-            // position is in the status report
-            // float wcos[MAX_N_AXIS];
-            // auto  wcos = parse_axes(value, wcos);
-            continue;
-        }
-        if (tag == "Ov") {
-            // feed_ovr,rapid_ovr,spindle_ovr
-            float frs[3];
-            parse_numbers(value, frs, 3);  // feed in [0], rapid in [1], spindle in [2]
-            continue;
-        }
-        if (tag == "A") {
-            // SCFM
-            int  spindle = 0;
-            bool flood   = false;
-            bool mist    = false;
-            for (char const& c : value) {
-                switch (c) {
-                    case 'S':
-                        spindle = 1;
-                        break;
-                    case 'C':
-                        spindle = 2;
-                        break;
-                    case 'F':
-                        flood = true;
-                        break;
-                    case 'M':
-                        mist = true;
-                        break;
-                }
-            }
-            continue;
-        }
-        if (tag == "SD") {
-            auto commaPos = value.find_first_of(",");
-            _percent      = std::strtof(value.substr(0, commaPos).c_str(), nullptr);
-            _filename     = value.substr(commaPos + 1);
-            continue;
-        }
-    }
-    _oled->clear();
-    show_state();
-    show_file();
-    show_limits(probe, limits);
-    show_dro(axes, isMpos, limits);
-    show_radio_info();
-    _oled->display();
-}
-
-void OLED::parse_gcode_report() {
-    size_t pos     = 0;
-    size_t nextpos = _report.find_first_of(":", pos);
-    auto   name    = _report.substr(pos, nextpos - pos);
-    if (name != "[GC") {
-        return;
-    }
-    pos = nextpos + 1;
-    do {
-        nextpos  = _report.find_first_of(" ", pos);
-        auto tag = _report.substr(pos, nextpos - pos);
-        // G80 G0 G1 G2 G3  G38.2 G38.3 G38.4 G38.5
-        // G54 .. G59
-        // G17 G18 G19
-        // G20 G21
-        // G90 G91
-        // G94 G93
-        // M0 M1 M2 M30
-        // M3 M4 M5
-        // M7 M8 M9
-        // M56
-        // Tn
-        // Fn
-        // Sn
-        //        if (tag == "G0") {
-        //            continue;
-        //        }
-        pos = nextpos + 1;
-    } while (nextpos != std::string::npos);
+// Show a two-line screen instead of the status for at least hold_ms
+void OLED::show_message(const std::string& line0, const std::string& line1, int hold_ms) {
+    _message[0] = line0;
+    _message[1] = line1;
+    _messageEnd = xTaskGetTickCount() + std::max(hold_ms, _report_interval_ms) / portTICK_PERIOD_MS;
 }
 
 // [MSG:INFO: Connecting to STA:SSID foo]
-void OLED::parse_STA() {
+void OLED::parse_STA(const std::string& line) {
     size_t start = strlen("[MSG:INFO: Connecting to STA SSID:");
-    _radio_info  = _report.substr(start, _report.size() - start - 1);
+    _radio_info  = line.substr(start, line.size() - start - 1);
 
-    _oled->clear();
-    auto fh = font_height(ArialMT_Plain_10);
-    wrapped_draw_string(0, _radio_info, ArialMT_Plain_10);
-    _oled->display();
+    show_message(_radio_info, "", _radio_delay);
 }
 
 // [MSG:INFO: Connected - IP is 192.168.68.134]
-void OLED::parse_IP() {
-    size_t start = _report.rfind(" ") + 1;
-    _radio_addr  = _report.substr(start, _report.size() - start - 1);
+void OLED::parse_IP(const std::string& line) {
+    size_t start = line.rfind(" ") + 1;
+    _radio_addr  = line.substr(start, line.size() - start - 1);
 
-    _oled->clear();
-    auto fh = font_height(ArialMT_Plain_10);
-    wrapped_draw_string(0, _radio_info, ArialMT_Plain_10);
-    wrapped_draw_string(fh * 2, _radio_addr, ArialMT_Plain_10);
-    _oled->display();
-    dwell_ms(_radio_delay, DwellMode::SysSuspend);
+    show_message(_radio_info, _radio_addr, _radio_delay);
 }
 
 // [MSG:INFO: AP SSID foo IP 192.168.68.134 mask foo channel foo]
-void OLED::parse_AP() {
+void OLED::parse_AP(const std::string& line) {
     size_t start    = strlen("[MSG:INFO: AP SSID ");
-    size_t ssid_end = _report.rfind(" IP ");
-    size_t ip_end   = _report.rfind(" mask ");
+    size_t ssid_end = line.rfind(" IP ");
+    size_t ip_end   = line.rfind(" mask ");
     size_t ip_start = ssid_end + strlen(" IP ");
 
     _radio_info = "AP: ";
-    _radio_info += _report.substr(start, ssid_end - start);
-    _radio_addr = _report.substr(ip_start, ip_end - ip_start);
+    _radio_info += line.substr(start, ssid_end - start);
+    _radio_addr = line.substr(ip_start, ip_end - ip_start);
 
-    _oled->clear();
-    auto fh = font_height(ArialMT_Plain_10);
-    wrapped_draw_string(0, _radio_info, ArialMT_Plain_10);
-    wrapped_draw_string(fh * 2, _radio_addr, ArialMT_Plain_10);
-    _oled->display();
-    dwell_ms(_radio_delay, DwellMode::SysSuspend);
+    show_message(_radio_info, _radio_addr, _radio_delay);
 }
 
-void OLED::parse_BT() {
+void OLED::parse_BT(const std::string& line) {
     size_t      start  = strlen("[MSG:INFO: BT Started with ");
-    std::string btname = _report.substr(start, _report.size() - start - 1);
+    std::string btname = line.substr(start, line.size() - start - 1);
     _radio_info        = "BT: ";
     _radio_info += btname.c_str();
 
-    _oled->clear();
-    wrapped_draw_string(0, _radio_info, ArialMT_Plain_10);
-    _oled->display();
-    dwell_ms(_radio_delay, DwellMode::SysSuspend);
+    show_message(_radio_info, "", _radio_delay);
 }
 
-void OLED::parse_WebUI() {
+void OLED::parse_WebUI(const std::string& line) {
     size_t      start  = strlen("[MSG:INFO: WebUI: Request from ");
-    std::string ipaddr = _report.substr(start, _report.size() - start - 1);
+    std::string ipaddr = line.substr(start, line.size() - start - 1);
 
-    _oled->clear();
-    auto fh = font_height(ArialMT_Plain_10);
-    wrapped_draw_string(0, "WebUI from", ArialMT_Plain_10);
-    wrapped_draw_string(fh * 2, ipaddr, ArialMT_Plain_10);
-    _oled->display();
+    show_message("WebUI from", ipaddr, 0);
 }
 
-void OLED::parse_report() {
-    if (_report.length() == 0) {
+void OLED::parse_line(const std::string& line) {
+    if (line.rfind("[MSG:INFO: Connecting to STA SSID:", 0) == 0) {
+        parse_STA(line);
         return;
     }
-    if (_report.rfind("<", 0) == 0) {
-        parse_status_report();
+    if (line.rfind("[MSG:INFO: Connected", 0) == 0) {
+        parse_IP(line);
         return;
     }
-    if (_report.rfind("[GC:", 0) == 0) {
-        parse_gcode_report();
+    if (line.rfind("[MSG:INFO: AP SSID ", 0) == 0) {
+        parse_AP(line);
         return;
     }
-    if (_report.rfind("[MSG:INFO: Connecting to STA SSID:", 0) == 0) {
-        parse_STA();
+    if (line.rfind("[MSG:INFO: BT Started with ", 0) == 0) {
+        parse_BT(line);
         return;
     }
-    if (_report.rfind("[MSG:INFO: Connected", 0) == 0) {
-        parse_IP();
-        return;
-    }
-    if (_report.rfind("[MSG:INFO: AP SSID ", 0) == 0) {
-        parse_AP();
-        return;
-    }
-    if (_report.rfind("[MSG:INFO: BT Started with ", 0) == 0) {
-        parse_BT();
-        return;
-    }
-    if (_report.rfind("[MSG:INFO: WebUI: Request from ", 0) == 0) {
-        parse_WebUI();
+    if (line.rfind("[MSG:INFO: WebUI: Request from ", 0) == 0) {
+        parse_WebUI(line);
         return;
     }
 }
 
-// This is how the OLED driver receives channel data
+// This is how the OLED driver receives channel data.  It runs in the
+// output task, so the only work done here is to pass info messages to
+// the poller; status is read directly from the system in autoReport().
 size_t OLED::write(uint8_t data) {
     char c = data;
     if (c == '\r') {
         return 1;
     }
     if (c == '\n') {
-        parse_report();
+        if (_report.rfind("[MSG:INFO: ", 0) == 0 && _report.length() < lineMax) {
+            xQueueSend(_lineQueue, _report.c_str(), 0);
+        }
         _report = "";
         return 1;
     }
@@ -8,6 +8,10 @@
 #include "src/Module.h"
 #include "SSD1306_I2C.h"
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
 typedef const uint8_t* font_t;
 
 class OLED : public Channel, public Module {
@@ -32,15 +36,37 @@ public:
     static Layout radioAddrLayout;
 
 private:
-    std::string _report;
+    // A snapshot of the machine state, taken directly from the system
+    // rather than by parsing a status report.  A frame is rendered only
+    // when the snapshot changes.
+    struct Status {
+        std::string state;
+        float       axes[MAX_N_AXIS]   = { 0 };
+        bool        isMpos             = false;
+        bool        probe              = false;
+        bool        limits[MAX_N_AXIS] = { false };
+        float       percent            = -1;
+        std::string filename;
+
+        bool operator==(const Status& o) const;
+        bool operator!=(const Status& o) const { return !(*this == o); }
+    };
+    Status _status;
+    bool   _redraw = true;
+
+    // Lines from the output task are accumulated in _report and lines
+    // that the display cares about are handed to the poller via _lineQueue.
+    static const size_t lineMax = 128;
+    std::string         _report;
+    QueueHandle_t       _lineQueue = nullptr;
 
     std::string _radio_info;
     std::string _radio_addr;
 
-    std::string _state;
-    std::string _filename;
+    // A transient two-line screen, e.g. the IP address after connecting
+    std::string _message[2];
+    int32_t     _messageEnd = 0;
 
-    float       _percent;
     std::string _ticker;
 
     int _radio_delay        = 0;
@@ -48,22 +74,36 @@ private:
 
     uint8_t _i2c_num = 0;
 
-    void parse_report();
-    void parse_status_report();
-    void parse_gcode_report();
-    void parse_STA();
-    void parse_IP();
-    void parse_AP();
-    void parse_BT();
-    void parse_WebUI();
-
-    void parse_axes(std::string s, float* axes);
-    void parse_numbers(std::string s, float* nums, int maxnums);
-
-    void show_limits(bool probe, const bool* limits);
+    // Frames are transferred to the panel by _flushTask so the I2C
+    // traffic does not block the polling loop.  _pending holds the last
+    // rendered frame and _shown what the panel currently displays.
+    size_t       _frameSize  = 0;
+    uint8_t*     _pending    = nullptr;
+    uint8_t*     _sending    = nullptr;
+    uint8_t*     _shown      = nullptr;
+    bool         _fullUpdate = true;
+    portMUX_TYPE _frameLock  = portMUX_INITIALIZER_UNLOCKED;
+    TaskHandle_t _flushTask  = nullptr;
+
+    static void flushTask(void* arg);
+    void        flushFrames();
+    void        queueFrame();
+
+    void take_snapshot(Status& status);
+    void render();
+
+    void parse_line(const std::string& line);
+    void parse_STA(const std::string& line);
+    void parse_IP(const std::string& line);
+    void parse_AP(const std::string& line);
+    void parse_BT(const std::string& line);
+    void parse_WebUI(const std::string& line);
+    void show_message(const std::string& line0, const std::string& line1, int hold_ms);
+
+    void show_limits();
     void show_state();
     void show_file();
-    void show_dro(const float* axes, bool isMpos, bool* limits);
+    void show_dro();
     void show_radio_info();
     void draw_checkbox(int16_t x, int16_t y, int16_t width, int16_t height, bool checked);
 
@@ -90,7 +130,7 @@ public:
 
     void init() override;
 
-    OLEDDisplay* _oled;
+    SSD1306_I2C* _oled;
 
     // Configurable
 
@@ -107,6 +147,7 @@ public:
     int peek(void) override { return -1; }
 
     Error pollLine(char* line) override;
+    void  autoReport() override;
     void  flushRx() override {}
 
     bool   lineComplete(char*, char) override { return false; }
@@ -0,0 +1,54 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "OccupancyHistogram.h"
+
+void OccupancyHistogram::add(size_t level) {
+    if (level >= MAX_LEVELS) {
+        level = MAX_LEVELS - 1;
+    }
+    ++_counts[level];
+    ++_samples;
+    _sum += level;
+}
+
+void OccupancyHistogram::clear() {
+    for (auto& count : _counts) {
+        count = 0;
+    }
+    _samples = 0;
+    _sum     = 0;
+}
+
+float OccupancyHistogram::mean() const {
+    return _samples ? float(_sum) / _samples : 0.0f;
+}
+
+size_t OccupancyHistogram::min() const {
+    for (size_t level = 0; level < MAX_LEVELS; level++) {
+        if (_counts[level]) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+size_t OccupancyHistogram::max() const {
+    for (size_t level = MAX_LEVELS; level-- > 0;) {
+        if (_counts[level]) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+size_t OccupancyHistogram::percentile(float fraction) const {
+    uint64_t seen = 0;
+    for (size_t level = 0; level < MAX_LEVELS; level++) {
+        seen += _counts[level];
+        if (_samples && seen >= fraction * _samples) {
+            return level;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// OccupancyHistogram counts how often a buffer held each number of
+// entries, so buffer sizes can be chosen from the fill levels that a job
+// actually reaches.  Levels at or above MAX_LEVELS - 1 are counted in the
+// top level.
+//
+// add() is a few increments, cheap enough to call for every segment
+// that the step generator queues.
+
+class OccupancyHistogram {
+public:
+    static const size_t MAX_LEVELS = 128;  // Enough for the largest planner
+
+private:
+    uint32_t _counts[MAX_LEVELS] = {};
+    uint32_t _samples            = 0;
+    uint64_t _sum                = 0;
+
+public:
+    void add(size_t level);
+    void clear();
+
+    uint32_t samples() const { return _samples; }
+    uint32_t count(size_t level) const { return level < MAX_LEVELS ? _counts[level] : 0; }
+
+    float  mean() const;
+    size_t min() const;
+    size_t max() const;
+
+    // The lowest level at or below which at least fraction of the samples lie
+    size_t percentile(float fraction) const;
+};
@@ -14,9 +14,12 @@ void Parking::moveto(float* target) {
         return;  // Block during abort.
     }
     if (plan_buffer_line(target, &plan_data)) {
-        sys.step_control.executeSysMotion = true;
-        sys.step_control.endMotion        = false;  // Allow parking motion to execute, if feed hold is active.
-        Stepper::parking_setup_buffer();            // Setup step segment buffer for special parking motion case
+        {
+            std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+            sys.step_control.executeSysMotion = true;
+            sys.step_control.endMotion        = false;  // Allow parking motion to execute, if feed hold is active.
+            Stepper::parking_setup_buffer();            // Setup step segment buffer for special parking motion case
+        }
         Stepper::prep_buffer();
         Stepper::wake_up();
         do {
@@ -27,7 +30,10 @@ void Parking::moveto(float* target) {
         } while (sys.step_control.executeSysMotion);
         Stepper::parking_restore_buffer();  // Restore step segment buffer to normal run state.
     } else {
-        sys.step_control.executeSysMotion = false;
+        {
+            std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+            sys.step_control.executeSysMotion = false;
+        }
         protocol_exec_rt_system();
     }
 }
@@ -150,6 +156,7 @@ void Parking::unpark(bool restart) {
         if (!restart) {
             if (spindle->isRateAdjusted()) {
                 // When in laser mode, defer turn on until cycle starts
+                std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
                 sys.step_control.updateSpindleSpeed = true;
             } else {
                 log_debug("Spin up");
@@ -0,0 +1,127 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "PathBlender.h"
+
+#include <algorithm>
+#include <cmath>
+
+const float PathBlender::maxTurn   = 10.0f * 3.14159265f / 180.0f;
+const float PathBlender::minLength = 0.001f;
+
+void PathBlender::push(Points& out, const float* point) const {
+    std::copy(point, point + _nAxes, out.point[out.count++]);
+}
+
+void PathBlender::add(const float* from, const float* to, float tolerance, Points& out) {
+    out.count = 0;
+    if (!_held) {
+        std::copy(from, from + _nAxes, _start);
+        std::copy(to, to + _nAxes, _corner);
+        _before = 0;
+        for (size_t axis = 0; axis < _nAxes; axis++) {
+            _before += (to[axis] - from[axis]) * (to[axis] - from[axis]);
+        }
+        _before = std::sqrt(_before);
+        _held   = true;
+        return;
+    }
+
+    // The directions of the held move and the new one
+    float uA[MAX_N_AXIS], uB[MAX_N_AXIS];
+    float lenA = 0, lenB = 0, cosTurn = 0;
+    for (size_t axis = 0; axis < _nAxes; axis++) {
+        uA[axis] = _corner[axis] - _start[axis];
+        uB[axis] = to[axis] - _corner[axis];
+        lenA += uA[axis] * uA[axis];
+        lenB += uB[axis] * uB[axis];
+    }
+    lenA = std::sqrt(lenA);
+    lenB = std::sqrt(lenB);
+    if (lenA > 0 && lenB > 0) {
+        for (size_t axis = 0; axis < _nAxes; axis++) {
+            uA[axis] /= lenA;
+            uB[axis] /= lenB;
+            cosTurn += uA[axis] * uB[axis];
+        }
+    }
+    cosTurn    = std::max(-1.0f, std::min(1.0f, cosTurn));
+    float turn = std::acos(cosTurn);
+
+    // The corner is rounded by n chords that turn by equal angles at each
+    // of their n + 1 junctions.  The shape of the rounding is fixed by the
+    // turn and n, and its size by the distance L of its ends from the corner.
+    // In the plane of the turn, with the corner at the origin and the held
+    // move along the first coordinate, the rounding of unit L starts at
+    // (-1, 0) and ends at (cos turn, sin turn).
+    size_t n = 0;
+    float  L = 0;
+    float  chord[MAX_CHORDS + 1][2];
+    // Straight on, and reversals that cannot be rounded, are left alone
+    if (tolerance > 0 && lenA >= minLength && lenB >= minLength && turn > 1e-3f && turn < 3.1f) {
+        n = std::min(size_t(MAX_CHORDS), std::max(size_t(1), size_t(std::ceil(turn / maxTurn)) - 1));
+        for (;; n = 1) {
+            float step   = turn / (n + 1);
+            float length = 2 * std::cos(turn / 2) * std::sin(step / 2) / std::sin(n * step / 2);
+            chord[0][0]  = -1;
+            chord[0][1]  = 0;
+            for (size_t k = 1; k <= n; k++) {
+                chord[k][0] = chord[k - 1][0] + length * std::cos(k * step);
+                chord[k][1] = chord[k - 1][1] + length * std::sin(k * step);
+            }
+            // The rounding is symmetric, so its middle is closest to the corner
+            float mid[2];
+            for (int i = 0; i < 2; i++) {
+                mid[i] = (n % 2) ? (chord[n / 2][i] + chord[n / 2 + 1][i]) / 2 : chord[n / 2][i];
+            }
+            float deviation = std::hypot(mid[0], mid[1]);
+
+            // Each move gives up at most half of its length to each corner
+            L = std::min({ tolerance / deviation, _before / 2, lenB / 2, lenA });
+            if (L * length >= minLength || n == 1) {
+                if (L * length < minLength) {
+                    n = 0;  // Too small to bother with
+                }
+                break;
+            }
+        }
+    }
+
+    if (n == 0) {
+        push(out, _corner);
+        std::copy(_corner, _corner + _nAxes, _start);
+    } else {
+        float point[MAX_N_AXIS];
+        if (lenA - L >= minLength) {
+            for (size_t axis = 0; axis < _nAxes; axis++) {
+                point[axis] = _corner[axis] - L * uA[axis];
+            }
+            push(out, point);
+        }
+        // Map the plane of the turn into the axes: the second direction is
+        // the part of uB perpendicular to uA
+        float sinTurn = std::sin(turn);
+        for (size_t k = 1; k < n; k++) {
+            for (size_t axis = 0; axis < _nAxes; axis++) {
+                float w     = (uB[axis] - cosTurn * uA[axis]) / sinTurn;
+                point[axis] = _corner[axis] + L * (chord[k][0] * uA[axis] + chord[k][1] * w);
+            }
+            push(out, point);
+        }
+        for (size_t axis = 0; axis < _nAxes; axis++) {
+            _start[axis] = _corner[axis] + L * uB[axis];
+        }
+        push(out, _start);
+    }
+    std::copy(to, to + _nAxes, _corner);
+    _before = lenB;
+}
+
+bool PathBlender::flush(float* to) {
+    if (!_held) {
+        return false;
+    }
+    std::copy(_corner, _corner + _nAxes, to);
+    _held = false;
+    return true;
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+
+#include "NAxis.h"
+
+// PathBlender rounds the corners between consecutive straight moves for
+// G64 path blending.  Each corner is replaced by a few short chords that
+// turn through the corner in equal steps, as though around an arc, and
+// stay within the path tolerance of the corner.  The chords are only cut
+// from the half of each move nearest the corner, so short moves get
+// smaller roundings.  The planner limits the speed at each junction by
+// the angle between its moves, so turning through several small angles
+// instead of one large one lets the machine keep more of its speed
+// through dense, slightly zigzagging toolpaths.
+//
+// The latest move is held back until the next one shows how to round
+// the corner at its end.  add() returns the points to move to along the
+// way, and flush() returns the end of the held move when there is no
+// next move to blend with.
+//
+// Positions are in mm and the tolerance is the G64 P value.
+
+class PathBlender {
+public:
+    static const size_t MAX_CHORDS = 8;
+
+    struct Points {
+        float  point[MAX_CHORDS + 1][MAX_N_AXIS];
+        size_t count = 0;
+    };
+
+private:
+    size_t _nAxes = 3;
+    bool   _held  = false;
+    float  _start[MAX_N_AXIS];   // The start of the held move, after rounding the corner before it
+    float  _corner[MAX_N_AXIS];  // The end of the held move
+    float  _before = 0;          // The length of the held move before it was rounded
+
+    void push(Points& out, const float* point) const;
+
+public:
+    // The largest turn at each junction of a rounded corner, in radians
+    static const float maxTurn;
+
+    // Moves shorter than this are not worth rounding
+    static const float minLength;
+
+    void setAxes(size_t n) { _nAxes = n < MAX_N_AXIS ? n : size_t(MAX_N_AXIS); }
+
+    bool held() const { return _held; }
+
+    // Holds the move from 'from' to 'to', replacing any held move with the
+    // points that take it, around the corner within 'tolerance' mm, to the
+    // start of the new one.  When there is a held move, 'from' is its end.
+    void add(const float* from, const float* to, float tolerance, Points& out);
+
+    // Releases the held move. Returns false if there is none, otherwise
+    // sets 'to' to its end.
+    bool flush(float* to);
+
+    void clear() { _held = false; }
+};
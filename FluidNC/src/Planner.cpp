@@ -10,15 +10,17 @@
 
 #include "Planner.h"
 #include "Machine/MachineConfig.h"
+#include "SyncActions.h"
+#include "Stepper.h"  // Stepper::prep_mutex
 
 #include <cstdlib>  // PSoc Required for labs
 #include <cmath>
 
-static plan_block_t* block_buffer = nullptr;  // A ring buffer for motion instructions
-static uint8_t       block_buffer_tail;       // Index of the block to process now
-static uint8_t       block_buffer_head;       // Index of the next block to be pushed
-static uint8_t       next_buffer_head;        // Index of the next buffer head
-static uint8_t       block_buffer_planned;    // Index of the optimally planned block
+static plan_block_t*    block_buffer = nullptr;  // A ring buffer for motion instructions
+static volatile uint8_t block_buffer_tail;       // Index of the block to process now; advanced by the prep task
+static volatile uint8_t block_buffer_head;       // Index of the next block to be pushed
+static uint8_t          next_buffer_head;        // Index of the next buffer head
+static uint8_t          block_buffer_planned;    // Index of the optimally planned block
 
 void plan_init() {
     if (block_buffer) {
@@ -200,6 +202,7 @@ void plan_reset() {
 }
 
 void plan_reset_buffer() {
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
     block_buffer_tail    = 0;
     block_buffer_head    = 0;  // Empty = tail
     next_buffer_head     = 1;  // plan_next_block_index(block_buffer_head)
@@ -281,6 +284,7 @@ static void plan_compute_profile_parameters(plan_block_t* block, float nominal_s
 
 // Re-calculates buffered motions profile parameters upon a motion-based override change.
 void plan_update_velocity_profile_parameters() {
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
     uint8_t       block_index = block_buffer_tail;
     plan_block_t* block;
     float         nominal_speed;
@@ -299,6 +303,9 @@ void plan_update_velocity_profile_parameters() {
 }
 
 bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
+    // The prep task must not load the new block, nor the ones it replans, half way through
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+
     // Prepare and initialize new block. Copy relevant pl_data for block execution.
     plan_block_t* block = &block_buffer[block_buffer_head];
     memset(block, 0, sizeof(plan_block_t));  // Zero all block values.
@@ -419,11 +426,15 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
         // Update previous path unit_vector and planner position.
         copyAxes(pl.previous_unit_vec, unit_vec);
         copyAxes(pl.position, target_steps);
+        // Output changes queued since the previous block take effect when this block starts
+        block->sync_action = sync_action_claim();
         // New block is all set. Update buffer head and next buffer head indices.
         block_buffer_head = next_buffer_head;
         next_buffer_head  = plan_next_block_index(block_buffer_head);
         // Finish up by recalculating the plan with the new block.
         planner_recalculate();
+        // A running cycle can extend into the new block
+        Stepper::request_prep();
     }
     return true;
 }
@@ -450,6 +461,7 @@ uint8_t plan_get_block_buffer_available() {
 // Re-initialize buffer plan with a partially completed block, assumed to exist at the buffer tail.
 // Called after a steppers have come to a complete stop for a feed hold and the cycle is stopped.
 void plan_cycle_reinitialize() {
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
     // Re-plan from a complete stop. Reset planner entry speeds and buffer planned pointer.
     Stepper::update_plan_block_parameters();
     block_buffer_planned = block_buffer_tail;
@@ -58,6 +58,8 @@ struct plan_block_t {
     SpindleSpeed spindle_speed;  // Block spindle speed. Copied from pl_line_data.
 
     bool is_jog;
+
+    uint32_t sync_action;  // Id of the synchronized output change that precedes this block, or 0
 };
 
 // Planner data prototype. Must be used when passing new motions to the planner.
@@ -82,8 +82,7 @@ void protocol_do_probe(void* arg) {
         probing = false;
         get_motor_steps(probe_steps);
         if (p->_hard_stop) {
-            Stepper::reset();
-            plan_reset();
+            Stepper::flush();
             sys.state = State::Idle;
         } else {
             protocol_do_motion_cancel();
@@ -6,6 +6,7 @@
 #include "Machine/MachineConfig.h"
 #include "Configuration/RuntimeSetting.h"
 #include "Configuration/AfterParse.h"
+#include "Configuration/SectionIndex.h"
 #include "Configuration/Validator.h"
 #include "Configuration/ParseException.h"
 #include "Machine/Axes.h"
@@ -22,6 +23,9 @@
 #include "StartupLog.h"           // startupLog
 #include "Driver/fluidnc_gpio.h"  // gpio_dump()
 #include "FileCommands.h"         // make_file_commands()
+#include "I2SOut.h"               // i2s_out_get_stats()
+#include "HeightMap.h"            // heightMap
+#include "Stepper.h"              // Stepper::get_motion_stats()
 
 #include "FluidPath.h"
 #include "HashFS.h"
@@ -765,6 +769,293 @@ static Error setReportInterval(const char* value, AuthenticationLevel auth_level
     return Error::Ok;
 }
 
+// Gets or sets one item in the machine configuration tree, setting handled
+// if key names an item or a section.  SectionIndex finds the section that
+// holds the item so that only that section's items are examined.  section
+// is set to that section, or to null if the whole tree was searched.
+static Error config_item(const char* key, const char* value, Channel& out, bool& handled, Configuration::Configurable*& section) {
+    handled = false;
+    section = nullptr;
+    try {
+        const char* leaf;
+        if (!Configuration::SectionIndex::find(key, section, leaf)) {
+            return Error::Ok;
+        }
+        if (section) {
+            Configuration::RuntimeSetting rts(key, value, out, leaf);
+            section->group(rts);
+            handled = rts.isHandled_;
+        } else {
+            Configuration::RuntimeSetting rts(key, value, out);
+            config->group(rts);
+            handled = rts.isHandled_;
+        }
+    } catch (const Configuration::ParseException& ex) {
+        log_error("Configuration parse error at line " << ex.LineNumber() << ": " << ex.What());
+        return Error::ConfigurationInvalid;
+    } catch (const AssertionFailed& ex) {
+        log_error("Configuration change failed: " << ex.what());
+        return Error::ConfigurationInvalid;
+    }
+    return Error::Ok;
+}
+
+// Validates the configuration after items have been set and reruns afterParse().
+// If the items are known to be in one section, only that section's subtree is
+// revisited, along with the top-level checks that span sections.
+static Error config_changed(Configuration::Configurable* section = nullptr) {
+    auto root = section ? section : config;
+    try {
+        Configuration::Validator validator;
+        if (section) {
+            config->validate();
+        }
+        root->validate();
+        root->group(validator);
+    } catch (std::exception& ex) {
+        log_error("Validation error: " << ex.what());
+        return Error::ConfigurationInvalid;
+    }
+
+    try {
+        Configuration::AfterParse afterParseHandler;
+        if (section) {
+            config->afterParse();
+        }
+        root->afterParse();
+        root->group(afterParseHandler);
+    } catch (const AssertionFailed& ex) {
+        log_error("Configuration change failed: " << ex.what());
+        return Error::ConfigurationInvalid;
+    }
+    // afterParse() can create or replace sections
+    Configuration::SectionIndex::invalidate();
+    return Error::Ok;
+}
+
+// $Config/Batch=path;path=value;... gets and sets several configuration items
+// in one command.  Values are validated together after all of them are set.
+static Error configBatch(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (!value) {
+        return Error::InvalidValue;
+    }
+    // Reads need not wait for motion, but a set may change the machine under it
+    if (strchr(value, '=')) {
+        protocol_buffer_synchronize();
+    }
+    std::string_view             rest(value);
+    bool                         changed = false;
+    Error                        err     = Error::Ok;
+    Configuration::Configurable* changedSection = nullptr;  // Null if several sections changed
+    while (rest.length()) {
+        auto             semi  = rest.find(';');
+        std::string_view entry = rest.substr(0, semi);
+        rest.remove_prefix(semi == rest.npos ? rest.length() : semi + 1);
+        trim(entry);
+        if (entry.empty()) {
+            continue;
+        }
+
+        auto        eq = entry.find('=');
+        std::string path(entry.substr(0, eq));
+        std::string newValue;
+        if (eq != entry.npos) {
+            newValue = entry.substr(eq + 1);
+        }
+
+        bool                         handled;
+        Configuration::Configurable* section;
+        Error itemErr = config_item(path.c_str(), eq == entry.npos ? nullptr : newValue.c_str(), out, handled, section);
+        if (itemErr != Error::Ok) {
+            err = itemErr;
+        } else if (!handled) {
+            log_error_to(out, "No configuration item " << path);
+            err = Error::InvalidStatement;
+        } else if (eq != entry.npos) {
+            changedSection = !changed || section == changedSection ? section : nullptr;
+            changed        = true;
+        }
+    }
+    if (changed) {
+        Error changeErr = config_changed(changedSection);
+        if (changeErr != Error::Ok) {
+            return changeErr;
+        }
+    }
+    return err;
+}
+
+static Error flushNVS(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    bool ok = Coordinates::flushAll();
+    report_coordinate_writes(out);
+    return ok ? Error::Ok : Error::NvsSetFailed;
+}
+
+static Error setChannelWindow(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (!value) {
+        uint32_t window = out.getWindow();
+        if (window) {
+            log_info_to(out, out.name() << " ack window is " << window << " lines");
+        } else {
+            log_info_to(out, out.name() << " acks every line");
+        }
+        return Error::Ok;
+    }
+    char* endptr;
+    long  intValue = strtol(value, &endptr, 10);
+
+    if (endptr == value || *endptr != '\0') {
+        return Error::BadNumberFormat;
+    }
+    if (intValue < 1) {
+        return Error::InvalidValue;
+    }
+
+    uint32_t actual = out.setWindow(uint32_t(intValue));
+    log_info_to(out, out.name() << " ack window set to " << actual << " lines");
+    return Error::Ok;
+}
+
+// Turning compensation on or off changes the cartesian position that
+// corresponds to the current motor position, so resync the parser.
+static void enableHeightMap(bool on) {
+    heightMap.enable(on);
+    gc_sync_position();
+}
+
+static Error showHeightMap(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (!heightMap.valid()) {
+        log_info_to(out, "No height map");
+        return Error::Ok;
+    }
+    {
+        LogStream msg(out, "[MSG:INFO: ");
+        msg << "Height map " << heightMap.nx() << "x" << heightMap.ny();
+        msg << " X" << heightMap.x(0) << ".." << heightMap.x(heightMap.nx() - 1);
+        msg << " Y" << heightMap.y(0) << ".." << heightMap.y(heightMap.ny() - 1);
+        msg << (heightMap.enabled() ? " enabled" : " disabled");
+    }
+    for (size_t j = heightMap.ny(); j-- > 0;) {
+        LogStream msg(out, "[MSG:INFO: ");
+        msg << "Y" << heightMap.y(j) << ":";
+        for (size_t i = 0; i < heightMap.nx(); i++) {
+            msg << " " << setprecision(4) << heightMap.z(i, j) - heightMap.z(0, 0);
+        }
+    }
+    return Error::Ok;
+}
+
+static Error probeHeightMap(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (!state_is(State::Idle)) {
+        return Error::IdleError;
+    }
+    // x0,y0,x1,y1,nx,ny are required; feed rate, probe depth and retract are optional
+    float       args[9] = { 0, 0, 0, 0, 0, 0, 100, 10, 2 };
+    size_t      nargs   = 0;
+    const char* p       = value ? value : "";
+    while (*p && nargs < 9) {
+        char* end;
+        args[nargs] = strtof(p, &end);
+        if (end == p || (*end && *end != ',')) {
+            return Error::BadNumberFormat;
+        }
+        ++nargs;
+        p = *end ? end + 1 : end;
+    }
+    if (nargs < 6 || *p) {
+        log_error_to(out, "Usage: $HeightMap/Probe=x0,y0,x1,y1,nx,ny[,feed[,depth[,retract]]]");
+        return Error::InvalidValue;
+    }
+    if (args[4] < HeightMap::MIN_SIDE || args[4] > HeightMap::MAX_SIDE || args[5] < HeightMap::MIN_SIDE ||
+        args[5] > HeightMap::MAX_SIDE) {
+        log_error_to(out, "Grid size must be " << HeightMap::MIN_SIDE << " to " << HeightMap::MAX_SIDE << " points per side");
+        return Error::NumberRange;
+    }
+    if (args[6] <= 0 || args[7] <= 0 || args[8] <= 0) {
+        return Error::NegativeValue;
+    }
+
+    // The corners are given in work coordinates but the map is in machine coordinates
+    float xoff = gc_state.coord_system[X_AXIS] + gc_state.coord_offset[X_AXIS];
+    float yoff = gc_state.coord_system[Y_AXIS] + gc_state.coord_offset[Y_AXIS];
+    float x0   = args[0] + xoff;
+    float y0   = args[1] + yoff;
+    float x1   = args[2] + xoff;
+    float y1   = args[3] + yoff;
+
+    if (!config->_probe->exists()) {
+        log_error_to(out, "Probe pin is not configured");
+        return Error::InvalidStatement;
+    }
+
+    enableHeightMap(false);
+    Error err = mc_probe_grid(x0, y0, x1, y1, size_t(args[4]), size_t(args[5]), args[6], args[7], args[8]);
+    if (err != Error::Ok) {
+        log_error_to(out, "Height map probing failed");
+        return err;
+    }
+    enableHeightMap(true);
+    return showHeightMap(nullptr, auth_level, out);
+}
+
+static Error enableHeightMapCmd(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (value) {
+        if (!strcasecmp(value, "on") || !strcmp(value, "1")) {
+            if (!heightMap.valid()) {
+                log_error_to(out, "No height map");
+                return Error::InvalidStatement;
+            }
+            enableHeightMap(true);
+        } else if (!strcasecmp(value, "off") || !strcmp(value, "0")) {
+            enableHeightMap(false);
+        } else {
+            return Error::InvalidValue;
+        }
+    }
+    log_info_to(out, "Height map compensation is " << (heightMap.active() ? "on" : "off"));
+    return Error::Ok;
+}
+
+static Error clearHeightMap(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    enableHeightMap(false);
+    heightMap.clear();
+    return Error::Ok;
+}
+
+static const char* heightMapFile(const char* value) {
+    return value && *value ? value : "heightmap.txt";
+}
+
+static Error saveHeightMap(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (!heightMap.valid()) {
+        log_error_to(out, "No height map");
+        return Error::InvalidStatement;
+    }
+    try {
+        FileStream  file(heightMapFile(value), "w", "");
+        std::string text = heightMap.serialize();
+        file.write(reinterpret_cast<const uint8_t*>(text.c_str()), text.length());
+    } catch (Error err) { return err; }
+    return Error::Ok;
+}
+
+static Error loadHeightMap(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    std::string text;
+    try {
+        FileStream file(heightMapFile(value), "r", "");
+        text.resize(file.size());
+        text.resize(file.read(&text[0], text.length()));
+    } catch (Error err) { return err; }
+
+    enableHeightMap(false);
+    if (!heightMap.parse(text)) {
+        log_error_to(out, "Invalid height map file");
+        return Error::InvalidValue;
+    }
+    enableHeightMap(true);
+    return showHeightMap(nullptr, auth_level, out);
+}
+
 static Error sendAlarm(const char* value, AuthenticationLevel auth_level, Channel& out) {
     int       intValue = value ? atoi(value) : 0;
     ExecAlarm alarm    = static_cast<ExecAlarm>(intValue);
@@ -778,6 +1069,70 @@ static Error showHeap(const char* value, AuthenticationLevel auth_level, Channel
     return Error::Ok;
 }
 
+static Error showI2SOStats(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    if (!config->_i2so) {
+        log_info_to(out, "I2SO is not configured");
+        return Error::Ok;
+    }
+    i2s_out_stats_t stats;
+    i2s_out_get_stats(stats);
+    log_info_to(out,
+                "I2SO underruns:" << stats.underruns << " refills:" << stats.refills << " refill avg:" << stats.refill_avg_us
+                                  << "us max:" << stats.refill_max_us << "us buffer:" << stats.buffer_us << "us");
+    if (config->_stepping->_lowLatencySwitches) {
+        log_info_to(out, "I2SO static fallbacks for homing/probing:" << config->_stepping->_lowLatencySwitches);
+    }
+    i2s_out_clear_stats();
+    config->_stepping->_lowLatencySwitches = 0;
+    return Error::Ok;
+}
+
+static void showOccupancy(Channel& out, const char* name, const OccupancyHistogram& hist, uint32_t size) {
+    log_info_to(out,
+                name << " of " << size << ": min " << hist.min() << " p5 " << hist.percentile(0.05) << " p50 " << hist.percentile(0.5)
+                     << " mean " << setprecision(1) << hist.mean() << " max " << hist.max());
+    LogStream msg(out, "[MSG:INFO: ");
+    msg << name << " histogram:";
+    for (size_t level = 0; level <= hist.max(); level++) {
+        if (hist.count(level)) {
+            msg << " " << level << ":" << hist.count(level);
+        }
+    }
+}
+
+static Error showMotionStats(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    // The histograms are too big for the stack of some tasks
+    auto stats = new Stepper::motion_stats_t;
+    Stepper::get_motion_stats(*stats);
+    log_info_to(out, "Motion segments:" << stats->segments.samples() << " starvations:" << stats->starvations);
+    log_info_to(out, "Segment prep passes:" << stats->prep_passes << " max:" << stats->prep_max_us << "us");
+    if (stats->segments.samples()) {
+        showOccupancy(out, "Segments", stats->segments, stats->segment_size);
+        showOccupancy(out, "Planner", stats->planner, stats->planner_size);
+    }
+    if (stats->n_starved) {
+        LogStream msg(out, "[MSG:INFO: ");
+        msg << "Starved at lines:";
+        for (size_t i = 0; i < stats->n_starved; i++) {
+            msg << " " << stats->starved_lines[i];
+        }
+    }
+    delete stats;
+    Stepper::clear_motion_stats();
+    return Error::Ok;
+}
+
+static Error showMergeStats(const char* value, AuthenticationLevel auth_level, Channel& out) {
+    uint32_t moves, blocks;
+    mc_merge_stats(moves, blocks);
+    if (config->_mergeTolerance <= 0) {
+        log_info_to(out, "Merging is disabled; set merge_tolerance_mm to enable it");
+    }
+    float ratio = blocks ? float(moves) / blocks : 1.0f;
+    log_info_to(out, "Merge moves:" << moves << " blocks:" << blocks << " ratio:" << setprecision(2) << ratio);
+    return Error::Ok;
+}
+
 // Commands use the same syntax as Settings, but instead of setting or
 // displaying a persistent value, a command causes some action to occur.
 // That action could be anything, from displaying a run-time parameter
@@ -803,6 +1158,8 @@ void make_user_commands() {
     new UserCommand("X", "Alarm/Disable", disable_alarm_lock, anyState);
     new UserCommand("NVX", "Settings/Erase", Setting::eraseNVS, notIdleOrAlarm, WA);
     new UserCommand("V", "Settings/Stats", Setting::report_nvs_stats, notIdleOrAlarm);
+    new UserCommand(NULL, "NVS/Flush", flushNVS, notIdleOrAlarm);
+    new AsyncUserCommand(NULL, "Config/Batch", configBatch, anyState);
     new UserCommand("#", "GCode/Offsets", report_ngc, notIdleOrAlarm);
     new UserCommand("MD", "Motor/Disable", motor_disable, notIdleOrAlarm);
     new UserCommand("ME", "Motor/Enable", motor_enable, notIdleOrAlarm);
@@ -834,8 +1191,19 @@ void make_user_commands() {
     new UserCommand("SA", "Alarm/Send", sendAlarm, anyState);
     new UserCommand("Heap", "Heap/Show", showHeap, anyState);
     new UserCommand("SS", "Startup/Show", showStartupLog, anyState);
+    new AsyncUserCommand(NULL, "I2SO/Stats", showI2SOStats, anyState);
+    new AsyncUserCommand(NULL, "Merge/Stats", showMergeStats, anyState);
+    new AsyncUserCommand(NULL, "Motion/Stats", showMotionStats, anyState);
 
     new UserCommand("RI", "Report/Interval", setReportInterval, anyState);
+    new AsyncUserCommand(NULL, "Channel/Window", setChannelWindow, anyState);
+
+    new AsyncUserCommand(NULL, "HeightMap/Show", showHeightMap, anyState);
+    new UserCommand(NULL, "HeightMap/Probe", probeHeightMap, notIdleOrAlarm);
+    new UserCommand(NULL, "HeightMap/Enable", enableHeightMapCmd, notIdleOrAlarm);
+    new UserCommand(NULL, "HeightMap/Clear", clearHeightMap, notIdleOrAlarm);
+    new AsyncUserCommand(NULL, "HeightMap/Save", saveHeightMap, anyState);
+    new UserCommand(NULL, "HeightMap/Load", loadHeightMap, notIdleOrAlarm);
 
     new UserCommand("30", "FakeMaxSpindleSpeed", fakeMaxSpindleSpeed, notIdleOrAlarm);
     new UserCommand("32", "FakeLaserMode", fakeLaserMode, notIdleOrAlarm);
@@ -887,81 +1255,60 @@ Error do_command_or_setting(const char* key, const char* value, AuthenticationLe
     // Try to execute a command.  Commands handle values internally;
     // you cannot determine whether to set or display solely based on
     // the presence of a value.
-    for (Command* cp : Command::List) {
-        if ((strcasecmp(cp->getName(), key) == 0) || (cp->getGrblName() && strcasecmp(cp->getGrblName(), key) == 0)) {
-            if (auth_failed(cp, value, auth_level)) {
-                return Error::AuthenticationFailed;
-            }
-            if (cp->synchronous()) {
-                protocol_buffer_synchronize();
-            }
-            return cp->action(value, auth_level, out);
+    if (Command* cp = Command::find(key)) {
+        if (auth_failed(cp, value, auth_level)) {
+            return Error::AuthenticationFailed;
+        }
+        if (cp->synchronous()) {
+            protocol_buffer_synchronize();
         }
+        return cp->action(value, auth_level, out);
     }
 
-    protocol_buffer_synchronize();
+    // Displaying a value does not depend on motion, so only changes
+    // wait for the planner to drain.
+    if (value) {
+        protocol_buffer_synchronize();
+    }
 
     // First search the yaml settings by name. If found, set a new
     // value if one is given, otherwise display the current value
-    try {
-        Configuration::RuntimeSetting rts(key, value, out);
-        config->group(rts);
-
-        if (rts.isHandled_) {
-            if (value) {
-                // Validate only if something changed, not for display
-                try {
-                    Configuration::Validator validator;
-                    config->validate();
-                    config->group(validator);
-                } catch (std::exception& ex) {
-                    log_error("Validation error: " << ex.what());
-                    return Error::ConfigurationInvalid;
-                }
-
-                Configuration::AfterParse afterParseHandler;
-                config->afterParse();
-                config->group(afterParseHandler);
-            }
-            return Error::Ok;
-        }
-    } catch (const Configuration::ParseException& ex) {
-        log_error("Configuration parse error at line " << ex.LineNumber() << ": " << ex.What());
-        return Error::ConfigurationInvalid;
-    } catch (const AssertionFailed& ex) {
-        log_error("Configuration change failed: " << ex.what());
-        return Error::ConfigurationInvalid;
+    bool                         handled;
+    Configuration::Configurable* section;
+    Error                        err = config_item(key, value, out, handled, section);
+    if (err != Error::Ok) {
+        return err;
+    }
+    if (handled) {
+        // Validate only if something changed, not for display
+        return value ? config_changed(section) : Error::Ok;
     }
 
     // Next search the settings list by text name. If found, set a new
     // value if one is given, otherwise display the current value
-    for (Setting* s : Setting::List) {
-        if (strcasecmp(s->getName(), key) == 0) {
-            if (auth_failed(s, value, auth_level)) {
-                return Error::AuthenticationFailed;
-            }
-            if (value) {
-                return s->setStringValue(uriDecode(value));
-            } else {
-                show_setting(s->getName(), s->getStringValue(), NULL, out);
-                return Error::Ok;
-            }
+    if (Setting* s = Setting::find(key)) {
+        if (auth_failed(s, value, auth_level)) {
+            return Error::AuthenticationFailed;
+        }
+        if (value) {
+            return s->setStringValue(uriDecode(value));
+        } else {
+            show_setting(s->getName(), s->getStringValue(), NULL, out);
+            return Error::Ok;
         }
     }
 
     // Then search the setting list by compatible name.  If found, set a new
     // value if one is given, otherwise display the current value in compatible mode
-    for (Setting* s : Setting::List) {
-        if (s->getGrblName() && strcasecmp(s->getGrblName(), key) == 0) {
-            if (auth_failed(s, value, auth_level)) {
-                return Error::AuthenticationFailed;
-            }
-            if (value) {
-                return s->setStringValue(uriDecode(value));
-            } else {
-                show_setting(s->getGrblName(), s->getCompatibleValue(), NULL, out);
-                return Error::Ok;
-            }
+    if (Setting* s = Setting::findGrbl(key)) {
+        if (auth_failed(s, value, auth_level)) {
+            return Error::AuthenticationFailed;
+        }
+        if (value) {
+            return s->setStringValue(uriDecode(value));
+        } else {
+            show_setting(s->getGrblName(), s->getCompatibleValue(), NULL, out);
+            return Error::Ok;
         }
     }
 
@@ -15,7 +15,8 @@
 #include "Report.h"         // report_feedback_message
 #include "Limits.h"         // limits_get_state, soft_limit
 #include "Planner.h"        // plan_get_current_block
-#include "MotionControl.h"  // PARKING_MOTION_LINE_NUMBER
+#include "SyncActions.h"    // sync_action_run_all
+#include "MotionControl.h"  // PARKING_MOTION_LINE_NUMBER, mc_flush_filters
 
 #include "SettingsDefinitions.h"  // gcode_echo
 #include "Machine/LimitPin.h"
@@ -273,6 +274,7 @@ int32_t  heapLowWaterReportTime = 0;
 
 void protocol_main_loop() {
     start_polling();
+    Stepper::start_prep_task();
 
     // ---------------------------------------------------------------------------------
     // Primary loop! Upon a system abort, this exits back to main() to reset the system.
@@ -300,6 +302,7 @@ void protocol_main_loop() {
         }
 
         // Auto-cycle start any queued moves.
+        mc_filters_poll();
         protocol_auto_cycle_start();
         protocol_execute_realtime();  // Runtime command check point.
         if (sys.abort) {
@@ -321,6 +324,9 @@ void protocol_main_loop() {
             idleEndTime = 0;  //
             config->_axes->set_disable(true);
         }
+
+        // Write coordinate changes to NVS once things have settled
+        Coordinates::flushIfIdle();
         uint32_t newHeapSize = xPortGetFreeHeapSize();
         if (newHeapSize < heapLowWater) {
             heapLowWater = newHeapSize;
@@ -347,6 +353,7 @@ void protocol_main_loop() {
 // Block until all buffered steps are executed or in a cycle state. Works with feed hold
 // during a synchronize call, if it should happen. Also, waits for clean cycle end.
 void protocol_buffer_synchronize() {
+    mc_flush_filters();
     do {
         // Restart motion if there are blocks in the planner queue
         protocol_auto_cycle_start();
@@ -391,6 +398,14 @@ static void protocol_run_startup_lines() {
     config->_macros->_startup_line1.run(&allChannels);
 }
 
+static void protocol_do_full_reset() {
+    // Do not lose coordinate changes that are still held in RAM.  This runs
+    // as an event and the restart discards any queued motion, so do not wait
+    // for the planner to drain.
+    Coordinates::flushAll(false);
+    restart();
+}
+
 static void protocol_do_soft_restart() {
     // Reset primary systems.
     system_reset();
@@ -401,14 +416,18 @@ static void protocol_do_soft_restart() {
     // it anyway just for safety.  We want to avoid any
     // possibility of crashing at this point.
 
-    plan_reset();  // Clear block buffer and planner variables
+    if (state_is(State::ConfigAlarm)) {
+        plan_reset();  // Clear block buffer and planner variables
+    } else {
+        Stepper::flush();  // Clear block buffer, planner and stepper subsystem variables
+    }
+    sync_action_reset();
 
     if (!state_is(State::ConfigAlarm)) {
         if (spindle) {
             spindle->stop();
             report_ovr_counter = 0;  // Set to report change immediately
         }
-        Stepper::reset();  // Clear stepper subsystem variables
     }
 
     // Sync cleared gcode and planner positions to current system position.
@@ -483,6 +502,7 @@ static void protocol_do_alarm(void* alarmVoid) {
 
 static void protocol_start_holding() {
     if (!(sys.suspend.bit.motionCancel || sys.suspend.bit.jogCancel)) {  // Block, if already holding.
+        std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);  // Prep sees the hold all at once
         sys.step_control = {};
         if (!Stepper::update_plan_block_parameters()) {  // Notify stepper module to recompute for hold deceleration.
             sys.step_control.endMotion = true;
@@ -603,6 +623,7 @@ static void protocol_do_safety_door() {
             if (!sys.suspend.bit.jogCancel && sys.suspend.bit.initiateRestore) {  // Actively restoring
                 // Set hold and reset appropriate control flags to restart parking sequence.
                 if (sys.step_control.executeSysMotion) {
+                    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
                     Stepper::update_plan_block_parameters();  // Notify stepper module to recompute for hold deceleration.
                     sys.step_control                  = {};
                     sys.step_control.executeHold      = true;
@@ -674,6 +695,7 @@ void protocol_cancel_disable_steppers() {
 static void protocol_do_initiate_cycle() {
     // log_debug("protocol_do_initiate_cycle " << state_name());
     // Start cycle only if queued motions exist in planner buffer and the motion is not canceled.
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
     sys.step_control = {};  // Restore step control to normal operation
     plan_block_t* pb;
     if ((pb = plan_get_current_block()) && !sys.suspend.bit.motionCancel) {
@@ -681,6 +703,7 @@ static void protocol_do_initiate_cycle() {
         set_state(pb->is_jog ? State::Jog : State::Cycle);
         Stepper::prep_buffer();  // Initialize step segment buffer before beginning cycle.
         Stepper::wake_up();
+        Stepper::request_prep();  // The prep task sleeps while there is no motion
     } else {                    // Otherwise, do nothing. Set and resume IDLE state.
         sys.suspend.value = 0;  // Break suspend state.
         set_state(State::Idle);
@@ -688,11 +711,13 @@ static void protocol_do_initiate_cycle() {
 }
 static void protocol_initiate_homing_cycle() {
     // log_debug("protocol_initiate_homing_cycle " << state_name());
+    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
     sys.step_control                  = {};    // Restore step control to normal operation
     sys.suspend.value                 = 0;     // Break suspend state.
     sys.step_control.executeSysMotion = true;  // Set to execute homing motion and clear existing flags.
     Stepper::prep_buffer();                    // Initialize step segment buffer before beginning cycle.
     Stepper::wake_up();
+    Stepper::request_prep();  // The prep task sleeps while there is no motion
 }
 
 static void protocol_do_cycle_start() {
@@ -785,8 +810,11 @@ void protocol_do_cycle_stop() {
                 if (sys.step_control.executeHold) {
                     sys.suspend.bit.holdComplete = true;
                 }
-                sys.step_control.executeHold      = false;
-                sys.step_control.executeSysMotion = false;
+                {
+                    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+                    sys.step_control.executeHold      = false;
+                    sys.step_control.executeSysMotion = false;
+                }
                 break;
             }
             // Fall through
@@ -800,12 +828,18 @@ void protocol_do_cycle_stop() {
             // Motion complete. Includes CYCLE/JOG/HOMING states and jog cancel/motion cancel/soft limit events.
             // NOTE: Motion and jog cancel both immediately return to idle after the hold completes.
             if (sys.suspend.bit.jogCancel) {  // For jog cancel, flush buffers and sync positions.
-                sys.step_control = {};
-                plan_reset();
-                Stepper::reset();
+                {
+                    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+                    sys.step_control = {};
+                    Stepper::flush();
+                }
                 gc_sync_position();
                 plan_sync_position();
             }
+            if (!plan_get_current_block()) {
+                // Output changes queued after the last block
+                sync_action_run_all();
+            }
             if (sys.suspend.bit.safetyDoorAjar) {  // Only occurs when safety door opens during jog.
                 sys.suspend.bit.jogCancel    = false;
                 sys.suspend.bit.holdComplete = true;
@@ -865,7 +899,7 @@ void protocol_exec_rt_system() {
         case State::SafetyDoor:
         case State::Homing:
         case State::Jog:
-            Stepper::prep_buffer();
+            Stepper::request_prep();
             break;
     }
 }
@@ -890,6 +924,7 @@ static void protocol_manage_spindle() {
                 report_feedback_message(Message::SpindleRestore);
                 if (spindle->isRateAdjusted()) {
                     // When in laser mode, defer turn on until cycle starts
+                    std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
                     sys.step_control.updateSpindleSpeed = true;
                 } else {
                     config->_parking->restore_spindle();
@@ -906,6 +941,7 @@ static void protocol_manage_spindle() {
         // NOTE: sys.step_control.updateSpindleSpeed is automatically reset upon resume in step generator.
         if (sys.step_control.updateSpindleSpeed) {
             config->_parking->restore_spindle();
+            std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
             sys.step_control.updateSpindleSpeed = false;
         }
     }
@@ -1029,8 +1065,11 @@ static void protocol_do_spindle_override(void* incrementvp) {
         }
     }
     if (percent != sys.spindle_speed_ovr) {
-        sys.spindle_speed_ovr               = percent;
-        sys.step_control.updateSpindleSpeed = true;
+        {
+            std::lock_guard<std::recursive_mutex> lock(Stepper::prep_mutex);
+            sys.spindle_speed_ovr               = percent;
+            sys.step_control.updateSpindleSpeed = true;
+        }
         gc_ovr_changed();
 
         // If spindle is on, tell it the RPM has been overridden
@@ -1131,7 +1170,7 @@ const NoArgEvent sleepEvent { protocol_do_sleep };
 const NoArgEvent debugEvent { report_realtime_debug };
 const NoArgEvent startEvent { protocol_do_start };
 const NoArgEvent restartEvent { protocol_do_soft_restart };
-const NoArgEvent fullResetEvent { restart };
+const NoArgEvent fullResetEvent { protocol_do_full_reset };
 const NoArgEvent runStartupLinesEvent { protocol_run_startup_lines };
 
 const NoArgEvent rtResetEvent { protocol_do_rt_reset };
@@ -316,6 +316,11 @@ void report_gcode_modes(Channel& channel) {
             break;
     }
 
+    // G61 is the default that Grbl never reports
+    if (gc_state.modal.control == ControlMode::Continuous) {
+        msg << " G64";
+    }
+
     //report_util_gcode_modes_M();
     switch (gc_state.modal.program_flow) {
         case ProgramFlow::Running:
@@ -612,6 +617,9 @@ void report_realtime_status(Channel& channel) {
     }
     if (Job::active()) {
         msg << "|" << Job::channel()->_progress;
+        if (Job::channel()->_remaining >= 0) {
+            msg << "|ETA:" << int(Job::channel()->_remaining);
+        }
     }
 #ifdef DEBUG_STEPPER_ISR
     msg << "|ISRs:" << Stepper::isr_count;
@@ -45,6 +45,10 @@ void SDCard::init() {
     } else {
         sd_init_slot(_frequency_hz, csPin);
     }
+    if (_max_frequency_hz > _frequency_hz) {
+        log_info("SD clock tuning up to " << _max_frequency_hz);
+    }
+    sd_autotune(_max_frequency_hz);
 }
 
 void SDCard::afterParse() {
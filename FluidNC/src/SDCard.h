@@ -42,7 +42,8 @@ private:
     Pin   _cardDetect;
     Pin   _cs;
 
-    uint32_t _frequency_hz = 8000000;  // Set to nonzero to override the default
+    uint32_t _frequency_hz     = 8000000;  // Set to nonzero to override the default
+    uint32_t _max_frequency_hz = 0;        // Nonzero to try faster clocks up to this at mount
 
 public:
     SDCard();
@@ -62,6 +63,7 @@ public:
         handler.item("cs_pin", _cs);
         handler.item("card_detect_pin", _cardDetect);
         handler.item("frequency_hz", _frequency_hz, 400000, 20000000);
+        handler.item("max_frequency_hz", _max_frequency_hz, 0, 40000000);
     }
 
     ~SDCard();
@@ -4,6 +4,7 @@
 #include <OLEDDisplay.h>
 #include "Machine/I2CBus.h"
 #include <algorithm>
+#include <cstring>
 
 using namespace Machine;
 
@@ -101,6 +102,56 @@ public:
 #endif
     }
 
+    // Send the parts of frame that differ from shown, one page (8 pixel
+    // rows) at a time, narrowing each page to its changed columns, and
+    // update shown to match.  With full set, every page is sent.
+    void displayChanges(const uint8_t* frame, uint8_t* shown, bool full) {
+        if (_error) {
+            return;
+        }
+        const int x_offset = (128 - this->width()) / 2;
+        const int w        = this->width();
+        uint8_t   data[128 + 1];  // control byte and one page
+
+        for (int page = 0; page < this->height() / 8; page++) {
+            const uint8_t* row   = &frame[page * w];
+            uint8_t*       seen  = &shown[page * w];
+            int            first = 0;
+            int            last  = w - 1;
+            if (!full) {
+                while (first < w && row[first] == seen[first]) {
+                    ++first;
+                }
+                if (first == w) {
+                    continue;
+                }
+                while (row[last] == seen[last]) {
+                    --last;
+                }
+            }
+            size_t len = last - first + 1;
+
+            sendCommand(COLUMNADDR);
+            sendCommand(x_offset + first);
+            sendCommand(x_offset + last);
+
+            sendCommand(PAGEADDR);
+            sendCommand(page);
+            sendCommand(page);
+
+            data[0] = 0x40;  // control
+            memcpy(&data[1], &row[first], len);
+            if (_error || _i2c->write(_address, data, len + 1) < 0) {
+                _error = true;
+                return;
+            }
+            memcpy(&seen[first], &row[first], len);
+        }
+    }
+
+    const uint8_t* frame() { return buffer; }
+    size_t         frameSize() { return this->width() * this->height() / 8; }
+
 private:
     int getBufferOffset(void) { return 0; }
 
@@ -0,0 +1,79 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "SegmentMerger.h"
+
+#include <algorithm>
+
+bool SegmentMerger::fits(const float* to, float tolerance) const {
+    if (_nPoints == MAX_POINTS) {
+        return false;
+    }
+    float line[MAX_N_AXIS];
+    float length2 = 0;
+    for (size_t axis = 0; axis < _nAxes; axis++) {
+        line[axis] = to[axis] - _start[axis];
+        length2 += line[axis] * line[axis];
+    }
+    if (length2 == 0) {
+        return false;
+    }
+
+    // Each skipped vertex, with the end of the run last, must be near the
+    // line and further along it than the one before
+    float before = 0;
+    for (size_t i = 0; i <= _nPoints; i++) {
+        const float* point = i < _nPoints ? _points[i] : _end;
+        float        along = 0;
+        for (size_t axis = 0; axis < _nAxes; axis++) {
+            along += (point[axis] - _start[axis]) * line[axis];
+        }
+        along /= length2;
+        if (along <= before || along >= 1) {
+            return false;
+        }
+        float off2 = 0;
+        for (size_t axis = 0; axis < _nAxes; axis++) {
+            float d = point[axis] - _start[axis] - along * line[axis];
+            off2 += d * d;
+        }
+        if (off2 > tolerance * tolerance) {
+            return false;
+        }
+        before = along;
+    }
+    return true;
+}
+
+bool SegmentMerger::add(const float* from, const float* to, float tolerance, float* start, float* end) {
+    ++_moves;
+    if (!_held) {
+        std::copy(from, from + _nAxes, _start);
+        std::copy(to, to + _nAxes, _end);
+        _nPoints = 0;
+        _held    = true;
+        return false;
+    }
+    if (tolerance > 0 && fits(to, tolerance)) {
+        std::copy(_end, _end + _nAxes, _points[_nPoints++]);
+        std::copy(to, to + _nAxes, _end);
+        return false;
+    }
+    flush(start, end);
+    std::copy(end, end + _nAxes, _start);
+    std::copy(to, to + _nAxes, _end);
+    _held = true;
+    return true;
+}
+
+bool SegmentMerger::flush(float* start, float* end) {
+    if (!_held) {
+        return false;
+    }
+    std::copy(_start, _start + _nAxes, start);
+    std::copy(_end, _end + _nAxes, end);
+    _nPoints = 0;
+    _held    = false;
+    ++_blocks;
+    return true;
+}
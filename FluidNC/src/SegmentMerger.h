@@ -0,0 +1,64 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "NAxis.h"
+
+// SegmentMerger joins runs of short, nearly colinear moves, as CAM
+// programs often emit, into single moves so that each run takes one
+// planner block instead of many, and the planner can look further ahead.
+// A run is extended by the next move as long as every vertex it would
+// skip stays within the tolerance of the straight line from the start of
+// the run to the end of the new move, in order along it.
+//
+// The latest run is held back until a move that does not fit it, or a
+// call to flush(), ends it.
+//
+// Positions are in mm, and only the first setAxes() axes are compared
+// and copied.
+
+class SegmentMerger {
+public:
+    static const size_t MAX_POINTS = 16;  // The most vertices that one merged move skips
+
+private:
+    size_t _nAxes = 3;
+    bool   _held  = false;
+    float  _start[MAX_N_AXIS];
+    float  _end[MAX_N_AXIS];
+    float  _points[MAX_POINTS][MAX_N_AXIS];  // The vertices between _start and _end
+    size_t _nPoints = 0;
+
+    uint32_t _moves  = 0;
+    uint32_t _blocks = 0;
+
+    bool fits(const float* to, float tolerance) const;
+
+public:
+    void setAxes(size_t n) { _nAxes = n < MAX_N_AXIS ? n : size_t(MAX_N_AXIS); }
+
+    bool held() const { return _held; }
+
+    // Adds the move from 'from' to 'to'.  If it does not fit the held run,
+    // returns true with 'start' and 'end' set to the run, which the caller
+    // must send before the new one.  When there is a held run, 'from' is
+    // its end.
+    bool add(const float* from, const float* to, float tolerance, float* start, float* end);
+
+    // Releases the held run.  Returns false if there is none.
+    bool flush(float* start, float* end);
+
+    void clear() {
+        _held    = false;
+        _nPoints = 0;
+    }
+
+    // The number of moves added and of merged moves sent out since clearStats()
+    uint32_t moves() const { return _moves; }
+    uint32_t blocks() const { return _blocks; }
+    void     clearStats() { _moves = _blocks = 0; }
+};
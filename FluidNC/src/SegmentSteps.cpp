@@ -0,0 +1,47 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "SegmentSteps.h"
+
+#include <cmath>
+
+uint32_t SegmentSteps::take(float distance, uint32_t ticks, uint32_t& period) {
+    // The segment runs from 'start' to 'end', both in fixed point steps from
+    // the end of the block.  Scaling by ONE is exact, so rounding up here
+    // gives the same whole step as rounding up the distance itself.
+    uint64_t start = uint64_t(_remaining) << FRACTION_BITS;
+    uint64_t end   = 0;
+    if (distance > 0) {
+        end = uint64_t(ceilf(distance * float(ONE)));
+        if (end > start) {
+            end = start;
+        }
+    }
+    uint32_t left  = uint32_t((end + ONE - 1) >> FRACTION_BITS);  // Whole steps after this segment
+    uint32_t steps = _remaining - left;
+
+    uint64_t time = (uint64_t(ticks) << FRACTION_BITS) + _carry;
+    if (end == start) {
+        // No motion, so the time goes to the next segment
+        period = UINT32_MAX;
+        _carry = time;
+        return 0;
+    }
+
+    // The steps are spread over the distance actually covered, and the
+    // time for the part of the next step that this segment covered is
+    // credited to the next segment.
+    //
+    // This is the one division per segment, the same float division that
+    // the float formulation used for its inverse rate.  A 64 bit integer
+    // division would be exact, but Xtensa has only a 32 bit divider, so
+    // it would be a slower library call.  The quotient only sets the
+    // period and the carried time, so its round-off does not reach the
+    // step counts and, being less than a tick per step, does not build up.
+    float ticks_per_step = float(time) / float(start - end);
+    float whole          = ceilf(ticks_per_step);
+    period               = whole >= float(UINT32_MAX) ? UINT32_MAX : uint32_t(whole);
+    _carry               = uint64_t(float((uint64_t(left) << FRACTION_BITS) - end) * ticks_per_step);
+    _remaining           = left;
+    return steps;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// SegmentSteps hands out the steps of a planner block to its step segments
+// and computes the step period of each one.  The whole steps left in the
+// block are counted as an integer, so a block always ends on exactly its
+// step count no matter how many steps it has, and the partial step at the
+// end of each segment is carried to the next one in fixed point timer
+// ticks, so the segment rates do not drift.  Each segment takes one float
+// division for its period, as the float formulation did.
+//
+// begin() starts each planner block and the stepper calls take() once
+// per segment of it.
+
+class SegmentSteps {
+public:
+    static const int      FRACTION_BITS = 16;  // Distances and times are fixed point with this many fraction bits
+    static const uint64_t ONE           = uint64_t(1) << FRACTION_BITS;
+
+private:
+    // There are no initializers so that the stepper can clear its prep state with memset
+    uint32_t _remaining;  // Whole steps that no segment has taken yet
+    uint64_t _carry;      // Fixed point timer ticks already spent on the partial step ending the last segment
+
+public:
+    void begin(uint32_t steps) {
+        _remaining = steps;
+        _carry     = 0;
+    }
+
+    uint32_t remaining() const { return _remaining; }
+
+    // Takes the steps for a segment that lasts 'ticks' timer ticks and ends
+    // 'distance' steps before the end of the block.  Returns the number of
+    // steps and sets 'period' to the timer ticks per step, rounded up.
+    uint32_t take(float distance, uint32_t ticks, uint32_t& period);
+};
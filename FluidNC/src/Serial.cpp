@@ -219,10 +219,9 @@ AllChannels allChannels;
 
 Channel* pollChannels(char* line) {
     poll_gpios();
-    // Throttle polling when we are not ready for a line, thus preventing
-    // planner buffer starvation due to not calling Stepper::prep_buffer()
-    // frequently enough, which is normally called periodically at the end
-    // of protocol_exec_rt_system() via protocol_execute_realtime().
+    // Throttle polling when we are not ready for a line, leaving the time
+    // to the other tasks.  The segment prep task runs at a higher priority,
+    // so polling cannot starve the step segment buffer.
     static int counter = 0;
     if (line) {
         counter = 0;
@@ -5,15 +5,87 @@
 #include "Machine/MachineConfig.h"
 
 #include <map>
+#include <unordered_map>
 #include <limits>
 #include <cstring>
 #include <vector>
 #include <charconv>
+#include <mutex>
 #include <nvs.h>
 
 std::vector<Setting*> Setting::List __attribute__((init_priority(101))) = {};
 std::vector<Command*> Command::List __attribute__((init_priority(102))) = {};
 
+// Name indexes for Command::find() and Setting::find().  Commands and
+// settings are only ever added, so an index is stale when its size stamp
+// differs from the size of the list.  Lookups come from every task that
+// executes lines, and modules can register commands at runtime, so the
+// rebuild and the lookup both happen under _indexMutex.
+typedef std::unordered_map<std::string, Word*> WordIndex;
+
+static std::mutex _indexMutex;
+
+static std::string lower(const char* name) {
+    std::string s(name);
+    for (auto& c : s) {
+        c = tolower(c);
+    }
+    return s;
+}
+
+static Word* lookup(WordIndex& index, const char* name) {
+    auto it = index.find(lower(name));
+    return it == index.end() ? nullptr : it->second;
+}
+
+Command* Command::find(const char* name) {
+    static WordIndex            index;
+    static size_t               indexed = 0;
+    std::lock_guard<std::mutex> lock(_indexMutex);
+    if (indexed != List.size()) {
+        index.clear();
+        // emplace() keeps the first entry for a key, matching the order of a linear search
+        for (auto cp : List) {
+            index.emplace(lower(cp->getName()), cp);
+            if (cp->getGrblName()) {
+                index.emplace(lower(cp->getGrblName()), cp);
+            }
+        }
+        indexed = List.size();
+    }
+    return static_cast<Command*>(lookup(index, name));
+}
+
+Setting* Setting::find(const char* name) {
+    static WordIndex            index;
+    static size_t               indexed = 0;
+    std::lock_guard<std::mutex> lock(_indexMutex);
+    if (indexed != List.size()) {
+        index.clear();
+        for (auto s : List) {
+            index.emplace(lower(s->getName()), s);
+        }
+        indexed = List.size();
+    }
+    return static_cast<Setting*>(lookup(index, name));
+}
+
+Setting* Setting::findGrbl(const char* name) {
+    static WordIndex            index;
+    static size_t               indexed = 0;
+    std::lock_guard<std::mutex> lock(_indexMutex);
+    if (indexed != List.size()) {
+        index.clear();
+        for (auto s : List) {
+            if (s->getGrblName()) {
+                index.emplace(lower(s->getGrblName()), s);
+            }
+        }
+        indexed = List.size();
+    }
+    return static_cast<Setting*>(lookup(index, name));
+}
+
 bool get_param(const char* parameter, const char* key, std::string& s) {
     char* start = strstr(parameter, key);
     if (!start) {
@@ -420,10 +492,18 @@ Error UserCommand::action(const char* value, AuthenticationLevel auth_level, Cha
 };
 Coordinates* coords[CoordIndex::End];
 
+uint32_t Coordinates::_changes    = 0;
+uint32_t Coordinates::_writes     = 0;
+uint32_t Coordinates::_failures   = 0;
+int32_t  Coordinates::_lastChange = 0;
+bool     Coordinates::_anyDirty   = false;
+
 bool Coordinates::load() {
-    size_t len;
+    size_t len = sizeof(_currentValue);
     switch (nvs_get_blob(Setting::_handle, _name, _currentValue, &len)) {
         case ESP_OK:
+            memcpy(_storedValue, _currentValue, sizeof(_storedValue));
+            _dirty = false;
             return true;
         case ESP_ERR_NVS_INVALID_LENGTH:
             // This could happen if the stored value is longer than the buffer.
@@ -432,6 +512,10 @@ bool Coordinates::load() {
             // value was stored.  We don't flag it as an error, but rather
             // accept the initial coordinates and ignore the residue.
             // We could issue a warning message if we were so inclined.
+            // nvs_get_blob() copies nothing in this case, so start from zeros.
+            memset(_currentValue, 0, sizeof(_currentValue));
+            memset(_storedValue, 0, sizeof(_storedValue));
+            _dirty = false;
             return true;
         case ESP_ERR_NVS_INVALID_NAME:
         case ESP_ERR_NVS_INVALID_HANDLE:
@@ -442,10 +526,73 @@ bool Coordinates::load() {
 
 void Coordinates::set(float value[MAX_N_AXIS]) {
     memcpy(&_currentValue, value, sizeof(_currentValue));
-    if (FORCE_BUFFER_SYNC_DURING_NVS_WRITE) {
+    changed();
+}
+
+void Coordinates::changed() {
+    ++_changes;
+    _dirty      = true;
+    _anyDirty   = true;
+    _lastChange = int32_t(xTaskGetTickCount());
+}
+
+// NVS writes the new copy of a blob before it erases the old one, so a
+// crash during a flush leaves either the old or the new value, never a
+// mix.  The dirty flag is cleared only after the write succeeds.
+bool Coordinates::flush() {
+    if (!_dirty) {
+        return true;
+    }
+    if (memcmp(_storedValue, _currentValue, sizeof(_currentValue)) != 0) {
+        if (nvs_set_blob(Setting::_handle, _name, _currentValue, sizeof(_currentValue))) {
+            ++_failures;
+            return false;
+        }
+        ++_writes;
+        memcpy(_storedValue, _currentValue, sizeof(_storedValue));
+    }
+    _dirty = false;
+    return true;
+}
+
+bool Coordinates::flushAll(bool synchronize) {
+    if (!_anyDirty) {
+        return true;
+    }
+    if (synchronize && FORCE_BUFFER_SYNC_DURING_NVS_WRITE) {
         protocol_buffer_synchronize();
     }
-    nvs_set_blob(Setting::_handle, _name, _currentValue, sizeof(_currentValue));
+    bool ok = true;
+    for (size_t i = CoordIndex::Begin; i < CoordIndex::End; ++i) {
+        if (coords[i] && !coords[i]->flush()) {
+            ok = false;
+        }
+    }
+    _anyDirty = !ok;
+    return ok;
+}
+
+void Coordinates::flushIfIdle() {
+    // Wait until changes stop arriving, so a burst of them costs one write per coordinate system
+    const int32_t settleTicks = 500 / portTICK_PERIOD_MS;
+    if (_anyDirty && state_is(State::Idle) && (int32_t(xTaskGetTickCount()) - _lastChange) >= settleTicks) {
+        if (!flushAll()) {
+            // Try again later instead of on every pass through the loop
+            _lastChange = int32_t(xTaskGetTickCount());
+        }
+    }
+}
+
+void report_coordinate_writes(Channel& out) {
+    size_t pending = 0;
+    for (size_t i = CoordIndex::Begin; i < CoordIndex::End; ++i) {
+        if (coords[i] && coords[i]->isDirty()) {
+            ++pending;
+        }
+    }
+    log_info_to(out,
+                "Coordinate changes:" << Coordinates::_changes << " NVS writes:" << Coordinates::_writes
+                                      << " Failed:" << Coordinates::_failures << " Pending:" << pending);
 }
 
 IPaddrSetting::IPaddrSetting(
@@ -18,6 +18,9 @@ namespace Machine {
 // Initialize the configuration subsystem
 void settings_init();
 
+// Show how many coordinate changes were coalesced into NVS writes
+void report_coordinate_writes(Channel& out);
+
 // Define settings restore bitflags.
 enum SettingsRestore {
     Defaults     = bitnum_to_mask(0),
@@ -93,6 +96,11 @@ public:
     // so common code can enumerate them.
     static std::vector<Command*> List;
 
+    // Finds a command by name or grbl name, ignoring case, through an
+    // index that is rebuilt when commands are added.  When names collide,
+    // the command that a linear search of List would find first wins.
+    static Command* find(const char* name);
+
     ~Command() {}
     Command(const char*   description,
             type_t        type,
@@ -125,6 +133,10 @@ public:
     // so common code can enumerate them.
     static std::vector<Setting*> List;
 
+    // Find a setting by name or by grbl name, ignoring case
+    static Setting* find(const char* name);
+    static Setting* findGrbl(const char* name);
+
     Error check_state();
 
     static Error report_nvs_stats(const char* value, AuthenticationLevel auth_level, Channel& out) {
@@ -134,6 +146,7 @@ public:
         }
 
         log_info("NVS Used:" << stats.used_entries << " Free:" << stats.free_entries << " Total:" << stats.total_entries);
+        report_coordinate_writes(out);
 #if 0  // The SDK we use does not have this yet
         nvs_iterator_t it = nvs_entry_find(NULL, NULL, NVS_TYPE_ANY);
         while (it != NULL) {
@@ -233,12 +246,28 @@ public:
     const char* getDefaultString() override { return ""; }
 };
 
+// Coordinate changes are kept in RAM and written to NVS later, by flushAll(),
+// so that GCode that changes offsets repeatedly, like probing loops with
+// G10 L20, does not stall on flash writes.  The protocol loop flushes after
+// the machine has been idle for a moment, and $NVS/Flush flushes on demand.
 class Coordinates {
 private:
     float       _currentValue[MAX_N_AXIS];
+    float       _storedValue[MAX_N_AXIS];
     const char* _name;
+    bool        _dirty = false;
+
+    static int32_t _lastChange;  // Tick count of the most recent unflushed change
+    static bool    _anyDirty;
+
+    void changed();
+    bool flush();
 
 public:
+    static uint32_t _changes;    // Number of changes since startup
+    static uint32_t _writes;     // Number of NVS writes that the changes were coalesced into
+    static uint32_t _failures;   // Number of NVS writes that failed
+
     Coordinates(const char* name) : _name(name) {}
 
     const char* getName() { return _name; }
@@ -257,9 +286,20 @@ public:
     // Get an individual component
     const float get(int axis) { return _currentValue[axis]; }
     // Set an individual component
-    void set(int axis, float value) { _currentValue[axis] = value; }
+    void set(int axis, float value) {
+        _currentValue[axis] = value;
+        changed();
+    }
 
     void set(float* value);
+
+    bool isDirty() { return _dirty; }
+
+    // Writes all changed coordinates to NVS; returns false if a write failed.
+    // Pass synchronize=false where waiting for the planner to drain is not possible.
+    static bool flushAll(bool synchronize = true);
+    // Called from the protocol loop; flushes once the machine has settled in Idle
+    static void flushIfIdle();
 };
 
 extern Coordinates* coords[CoordIndex::End];
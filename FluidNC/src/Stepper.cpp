@@ -15,7 +15,14 @@
 #include "StepperPrivate.h"
 #include "Planner.h"
 #include "Protocol.h"
-#include <esp_attr.h>  // IRAM_ATTR
+#include "SyncActions.h"
+#include "InputShaper.h"
+#include "OccupancyHistogram.h"
+#include "SegmentSteps.h"
+#include "Driver/delay_usecs.h"  // getCpuTicks()
+#include <esp_attr.h>            // IRAM_ATTR
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <cmath>
 
 using namespace Stepper;
@@ -33,6 +40,8 @@ struct st_block_t {
     uint32_t step_event_count;
     uint8_t  direction_bits;
     bool     is_pwm_rate_adjusted;  // Tracks motions that require constant laser power/rate
+    uint32_t sync_action;           // Synchronized output change to perform when the block starts
+    int32_t  line_number;           // For reporting starvation
 };
 static volatile st_block_t* st_block_buffer = nullptr;
 
@@ -50,6 +59,26 @@ struct segment_t {
 };
 static segment_t* segment_buffer = nullptr;
 
+// Input shaping.  The shaped motion does not follow the planner blocks, so
+// shaped_source holds the Bresenham data of the block being prepped, and
+// each segment gets a st_block_t of its own with the steps of each axis
+// toward the shaped position.  Positions are in steps, relative to where
+// the machine was when the shaper last settled.
+static InputShaper shaper;
+static st_block_t  shaped_source;
+static int32_t     shaped_start[MAX_N_AXIS];    // Raw position at the start of the block
+static double      shaped_raw[MAX_N_AXIS];      // Raw position at the end of the last sample
+static int32_t     shaped_emitted[MAX_N_AXIS];  // Position at the end of the last segment
+static float       shaped_dt;                   // Time of the samples since the last segment, in minutes
+
+static void shaper_reset() {
+    memset(shaped_start, 0, sizeof(shaped_start));
+    memset(shaped_raw, 0, sizeof(shaped_raw));
+    memset(shaped_emitted, 0, sizeof(shaped_emitted));
+    shaped_dt = 0;
+    shaper.reset(shaped_raw);
+}
+
 void Stepper::init() {
     if (st_block_buffer) {
         delete[] st_block_buffer;
@@ -59,6 +88,15 @@ void Stepper::init() {
         delete[] segment_buffer;
     }
     segment_buffer = new segment_t[config->_stepping->_segments];
+
+    auto n_axis = config->_axes->_numberAxis;
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        auto a = config->_axes->_axis[axis];
+        shaper.configure(axis, InputShaper::Type(a->_shaperType), a->_shaperFrequency, a->_shaperDamping);
+    }
+    if (shaper.enabled()) {
+        log_info("Input shaping delay " << int(shaper.duration() * 1000) << " ms");
+    }
 }
 
 // Stepper ISR data struct. Contains the running data for the main stepper ISR.
@@ -85,6 +123,20 @@ static volatile uint32_t segment_buffer_tail;
 static volatile uint32_t segment_buffer_head;
 static uint32_t          segment_next_head;
 
+// Motion telemetry.  The buffer fills are sampled as each segment is
+// prepped, and the ISR counts the times it ran out of segments while
+// more motion was planned.
+static OccupancyHistogram segment_fill;
+static OccupancyHistogram planner_fill;
+static volatile bool      more_planned = false;
+static volatile uint32_t  stat_starvations;
+static volatile int32_t   starved_lines[STARVED_LINES];  // Most recent last
+
+static uint32_t segments_ready() {
+    uint32_t n = config->_stepping->_segments;
+    return (segment_buffer_head + n - segment_buffer_tail) % n;
+}
+
 // Pointers for the step segment being prepped from the planner buffer. Accessed only by the
 // main program. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t*        pl_block;       // Pointer to the planner block being prepped
@@ -96,15 +148,13 @@ typedef struct {
     uint8_t  st_block_index;  // Index of stepper common data block being prepped
     PrepFlag recalculate_flag;
 
-    float dt_remainder;
-    float steps_remaining;
-    float step_per_mm;
-    float req_mm_increment;
+    SegmentSteps steps;  // Steps of the block not yet in segments, and the partial step time
+    float        step_per_mm;
+    float        req_mm_increment;
 
-    uint8_t last_st_block_index;
-    float   last_steps_remaining;
-    float   last_step_per_mm;
-    float   last_dt_remainder;
+    uint8_t      last_st_block_index;
+    SegmentSteps last_steps;
+    float        last_step_per_mm;
 
     uint8_t ramp_type;    // Current segment ramp state
     float   mm_complete;  // End of velocity profile from end of current planner block in (mm).
@@ -118,6 +168,10 @@ typedef struct {
     float        inv_rate;  // Used by PWM laser mode to speed up segment calculations.
     SpindleSpeed current_spindle_speed;
 
+    bool shaped;       // The block is input shaped
+    bool last_shaped;  // Saved during parking
+    bool draining;     // The shaped motion is coming to rest at the end of a feed hold
+
 } st_prep_t;
 static st_prep_t prep;
 
@@ -223,6 +277,9 @@ bool IRAM_ATTR Stepper::pulse_func() {
                 for (int axis = 0; axis < n_axis; axis++) {
                     st.counter[axis] = st.exec_block->step_event_count >> 1;
                 }
+                if (st.exec_block->sync_action) {
+                    sync_action_reached_from_ISR(st.exec_block->sync_action);
+                }
             }
 
             st.dir_outbits = st.exec_block->direction_bits;
@@ -234,6 +291,15 @@ bool IRAM_ATTR Stepper::pulse_func() {
             spindle->setSpeedfromISR(st.exec_segment->spindle_dev_speed);
         } else {
             // Segment buffer empty. Shutdown.
+            if (more_planned) {
+                // Starved: the prep task did not keep up
+                for (size_t i = 1; i < STARVED_LINES; i++) {
+                    starved_lines[i - 1] = starved_lines[i];
+                }
+                starved_lines[STARVED_LINES - 1] = st.exec_block ? st.exec_block->line_number : 0;
+                ++stat_starvations;
+                more_planned = false;
+            }
             stop_stepping();
             if (!state_is(State::Jog)) {  // added to prevent ... jog after probing crash
                 // Ensure pwm is set properly upon completion of rate-controlled motion.
@@ -305,6 +371,8 @@ void Stepper::go_idle() {
 
 // Reset and clear stepper subsystem variables
 void Stepper::reset() {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+
     // Initialize Stepping driver idle state.
     config->_stepping->reset();
 
@@ -318,13 +386,22 @@ void Stepper::reset() {
     segment_buffer_tail = 0;
     segment_buffer_head = 0;  // empty = tail
     segment_next_head   = 1;
+    more_planned        = false;
     st.step_outbits     = 0;
     st.dir_outbits      = 0;  // Initialize direction bits to default.
+    shaper_reset();
     // TODO do we need to turn step pins off?
 }
 
+void Stepper::flush() {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+    reset();
+    plan_reset();
+}
+
 // Called by planner_recalculate() when the executing block is updated by the new plan.
 bool Stepper::update_plan_block_parameters() {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
     if (pl_block != NULL) {  // Ignore if at start of a new block.
         prep.recalculate_flag.recalculate = 1;
         pl_block->entry_speed_sqr         = prep.current_speed * prep.current_speed;  // Update entry speed.
@@ -336,12 +413,14 @@ bool Stepper::update_plan_block_parameters() {
 
 // Changes the run state of the step segment buffer to execute the special parking motion.
 void Stepper::parking_setup_buffer() {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+
     // Store step execution data of partially completed block, if necessary.
     if (prep.recalculate_flag.holdPartialBlock) {
         prep.last_st_block_index  = prep.st_block_index;
-        prep.last_steps_remaining = prep.steps_remaining;
-        prep.last_dt_remainder    = prep.dt_remainder;
+        prep.last_steps           = prep.steps;
         prep.last_step_per_mm     = prep.step_per_mm;
+        prep.last_shaped          = prep.shaped;
     }
     // Set flags to execute a parking motion
     prep.recalculate_flag.parking     = 1;
@@ -351,12 +430,19 @@ void Stepper::parking_setup_buffer() {
 
 // Restores the step segment buffer to the normal run state after a parking motion.
 void Stepper::parking_restore_buffer() {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+
     // Restore step execution data and flags of partially completed block, if necessary.
     if (prep.recalculate_flag.holdPartialBlock) {
-        st_prep_block                          = &st_block_buffer[prep.last_st_block_index];
-        prep.st_block_index                    = prep.last_st_block_index;
-        prep.steps_remaining                   = prep.last_steps_remaining;
-        prep.dt_remainder                      = prep.last_dt_remainder;
+        if (prep.last_shaped) {
+            // Shaped segments keep taking new blocks after the parking blocks
+            st_prep_block = &shaped_source;
+        } else {
+            st_prep_block       = &st_block_buffer[prep.last_st_block_index];
+            prep.st_block_index = prep.last_st_block_index;
+        }
+        prep.shaped                            = prep.last_shaped;
+        prep.steps                             = prep.last_steps;
         prep.step_per_mm                       = prep.last_step_per_mm;
         prep.recalculate_flag.holdPartialBlock = 1;
         prep.recalculate_flag.recalculate      = 1;
@@ -374,6 +460,112 @@ static uint8_t next_block_index(uint8_t block_index) {
     return block_index == (config->_stepping->_segments - 1) ? 0 : block_index;
 }
 
+// Makes the prepped segment available to the stepper ISR.
+static void advance_segment_head() {
+    if (awake) {  // Not the initial fill before stepping starts
+        segment_fill.add(segments_ready());
+        planner_fill.add(config->_planner_blocks - 1 - plan_get_block_buffer_available());
+    }
+
+    auto lastseg        = segment_next_head;
+    segment_next_head   = segment_next_head >= (config->_stepping->_segments - 1) ? 0 : segment_next_head + 1;
+    segment_buffer_head = lastseg;
+}
+
+// Sets the ISR period and AMASS level of a segment from its time per step in minutes.
+// n_step must already be set.
+static void set_segment_period(volatile segment_t* prep_segment, uint32_t timerTicks) {
+    int level;
+
+    // Compute step timing and multi-axis smoothing level.
+    for (level = 0; level < maxAmassLevel; level++) {
+        if (timerTicks < amassThreshold) {
+            break;
+        }
+        timerTicks >>= 1;
+    }
+    prep_segment->amass_level = level;
+    prep_segment->n_step <<= level;
+    // isrPeriod is stored as 16 bits, so limit timerTicks to the
+    // largest value that will fit in a uint16_t.
+    prep_segment->isrPeriod = timerTicks > 0xffff ? 0xffff : timerTicks;
+}
+
+static void set_segment_rate(volatile segment_t* prep_segment, float inv_rate) {
+    // Compute CPU cycles per step for the prepped segment.
+    // fStepperTimer is in units of timerTicks/sec, so the dimensional analysis is
+    // timerTicks/sec * 60 sec/minute * minutes = timerTicks
+    set_segment_period(prep_segment, uint32_t(ceilf((Machine::Stepping::fStepperTimer * 60) * inv_rate)));  // (timerTicks/step)
+}
+
+// Adds the raw position, mm_remaining from the end of the shaped block, to the shaper.
+static void add_shaped_sample(float mm_remaining, float dt) {
+    auto  n_axis   = config->_axes->_numberAxis;
+    float fraction = 1.0f - prep.step_per_mm * mm_remaining / (shaped_source.step_event_count >> maxAmassLevel);
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        double steps    = double(shaped_source.steps[idx] >> maxAmassLevel) * fraction;
+        shaped_raw[idx] = shaped_start[idx] + (bitnum_is_true(shaped_source.direction_bits, idx) ? -steps : steps);
+    }
+    shaper.add(dt * 60, shaped_raw);
+}
+
+// Fills in a segment that moves each axis to the shaped position. Returns false if no
+// step is due yet, in which case its time is carried over to the next segment.
+static bool prep_shaped_segment(volatile segment_t* prep_segment, float dt) {
+    double target[MAX_N_AXIS];
+    shaper.shaped(target);
+    shaped_dt += dt;
+
+    auto     n_axis = config->_axes->_numberAxis;
+    int32_t  delta[MAX_N_AXIS];
+    uint32_t n_step         = 0;
+    uint8_t  direction_bits = 0;
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        delta[idx] = int32_t(lround(target[idx])) - shaped_emitted[idx];
+        if (delta[idx] < 0) {
+            set_bitnum(direction_bits, idx);
+        }
+        n_step = MAX(n_step, uint32_t(labs(delta[idx])));
+    }
+    if (n_step == 0) {
+        if (shaper.settled()) {
+            shaped_dt = 0;
+        }
+        return false;
+    }
+
+    // The ISR restarts the Bresenham counters for each segment because the block changes
+    prep.st_block_index = next_block_index(prep.st_block_index);
+    auto block          = &st_block_buffer[prep.st_block_index];
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        block->steps[idx] = uint32_t(labs(delta[idx])) << maxAmassLevel;
+        shaped_emitted[idx] += delta[idx];
+    }
+    block->step_event_count     = n_step << maxAmassLevel;
+    block->direction_bits       = direction_bits;
+    block->is_pwm_rate_adjusted = shaped_source.is_pwm_rate_adjusted;
+    block->sync_action          = shaped_source.sync_action;  // Only on the first segment of the block
+    block->line_number          = shaped_source.line_number;
+    shaped_source.sync_action   = 0;
+
+    prep_segment->st_block_index = prep.st_block_index;
+    prep_segment->n_step         = n_step;
+    set_segment_rate(prep_segment, shaped_dt / n_step);
+    shaped_dt = 0;
+    return true;
+}
+
+// Adds a segment while the raw motion is stopped and the shaped motion comes to rest.
+static void prep_drain_segment() {
+    volatile segment_t* prep_segment = &segment_buffer[segment_buffer_head];
+    prep_segment->spindle_speed      = prep.current_spindle_speed;
+    prep_segment->spindle_dev_speed  = spindle->mapSpeed(prep.current_spindle_speed);
+    shaper.add(DT_SHAPED_SEGMENT * 60, shaped_raw);
+    if (prep_shaped_segment(prep_segment, DT_SHAPED_SEGMENT)) {
+        advance_segment_head();
+    }
+}
+
 /* Prepares step segment buffer. Continuously called from main program.
 
    The segment buffer is an intermediary buffer interface between the execution of steps
@@ -387,13 +579,24 @@ static uint8_t next_block_index(uint8_t block_index) {
    Currently, the segment buffer conservatively holds roughly up to 40-50 msec of steps.
    NOTE: Computation units are in steps, millimeters, and minutes.
 */
-void Stepper::prep_buffer() {
+static void prep_segments() {
     // Block step prep buffer, while in a suspend state and there is no suspend motion to execute.
     if (sys.step_control.endMotion) {
         return;
     }
 
     while (segment_buffer_tail != segment_next_head) {  // Check if we need to fill the buffer.
+        // At the end of a shaped feed hold, wait for the shaped motion to stop.
+        if (prep.draining) {
+            if (shaper.settled()) {
+                prep.draining              = false;
+                sys.step_control.endMotion = true;
+                return;
+            }
+            prep_drain_segment();
+            continue;
+        }
+
         // Determine if we need to load a new planner block or if the block needs to be recomputed.
         if (pl_block == NULL) {
             // Query planner for a queued block
@@ -404,6 +607,11 @@ void Stepper::prep_buffer() {
             }
 
             if (pl_block == NULL) {
+                if (!shaper.settled()) {
+                    // The motion has stopped, but the shaped motion is still catching up.
+                    prep_drain_segment();
+                    continue;
+                }
                 return;  // No planner blocks. Exit.
             }
 
@@ -416,12 +624,23 @@ void Stepper::prep_buffer() {
                 }
             } else {
                 // Load the Bresenham stepping data for the block.
-                prep.st_block_index = next_block_index(prep.st_block_index);
-                // Prepare and copy Bresenham algorithm segment data from the new planner block, so that
-                // when the segment buffer completes the planner block, it may be discarded when the
-                // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
-                st_prep_block                 = &st_block_buffer[prep.st_block_index];
+                prep.shaped = shaper.enabled() && !sys.step_control.executeSysMotion;
+                if (prep.shaped) {
+                    // The shaped segments get stepper blocks of their own.
+                    st_prep_block = &shaped_source;
+                    if (shaper.settled()) {
+                        shaper_reset();  // Start again from the current position
+                    }
+                } else {
+                    prep.st_block_index = next_block_index(prep.st_block_index);
+                    // Prepare and copy Bresenham algorithm segment data from the new planner block, so that
+                    // when the segment buffer completes the planner block, it may be discarded when the
+                    // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
+                    st_prep_block = &st_block_buffer[prep.st_block_index];
+                }
                 st_prep_block->direction_bits = pl_block->direction_bits;
+                st_prep_block->sync_action    = pl_block->sync_action;
+                st_prep_block->line_number    = pl_block->line_number;
                 uint8_t idx;
                 auto    n_axis = config->_axes->_numberAxis;
 
@@ -434,10 +653,9 @@ void Stepper::prep_buffer() {
                 st_prep_block->step_event_count = pl_block->step_event_count << maxAmassLevel;
 
                 // Initialize segment buffer data for generating the segments.
-                prep.steps_remaining  = (float)pl_block->step_event_count;
-                prep.step_per_mm      = prep.steps_remaining / pl_block->millimeters;
+                prep.steps.begin(pl_block->step_event_count);
+                prep.step_per_mm      = pl_block->step_event_count / pl_block->millimeters;
                 prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR / prep.step_per_mm;
-                prep.dt_remainder     = 0.0;  // Reset for new segment block
                 if ((sys.step_control.executeHold) || prep.recalculate_flag.decelOverride) {
                     // New block loaded mid-hold. Override planner block entry speed to enforce deceleration.
                     prep.current_speed                  = prep.exit_speed;
@@ -566,13 +784,13 @@ void Stepper::prep_buffer() {
           the end of planner block (typical) or mid-block at the end of a forced deceleration,
           such as from a feed hold.
         */
-        float dt_max   = DT_SEGMENT;                                // Maximum segment time
-        float dt       = 0.0;                                       // Initialize segment time
-        float time_var = dt_max;                                    // Time worker variable
-        float mm_var;                                               // mm-Distance worker variable
-        float speed_var;                                            // Speed worker variable
-        float mm_remaining = pl_block->millimeters;                 // New segment distance from end of block.
-        float minimum_mm   = mm_remaining - prep.req_mm_increment;  // Guarantee at least one step.
+        float dt_max   = prep.shaped ? DT_SHAPED_SEGMENT : DT_SEGMENT;  // Maximum segment time
+        float dt       = 0.0;                                            // Initialize segment time
+        float time_var = dt_max;                                         // Time worker variable
+        float mm_var;                                                    // mm-Distance worker variable
+        float speed_var;                                                 // Speed worker variable
+        float mm_remaining = pl_block->millimeters;                      // New segment distance from end of block.
+        float minimum_mm   = mm_remaining - prep.req_mm_increment;       // Guarantee at least one step.
 
         if (minimum_mm < 0.0) {
             minimum_mm = 0.0;
@@ -684,75 +902,56 @@ void Stepper::prep_buffer() {
         prep_segment->spindle_speed     = prep.current_spindle_speed;
         prep_segment->spindle_dev_speed = spindle->mapSpeed(prep.current_spindle_speed);  // Reload segment PWM value
 
-        /* -----------------------------------------------------------------------------------
-           Compute segment step rate, steps to execute, and apply necessary rate corrections.
-           NOTE: Steps are computed by direct scalar conversion of the millimeter distance
-           remaining in the block, rather than incrementally tallying the steps executed per
-           segment. This helps in removing floating point round-off issues of several additions.
-           However, since floats have only 7.2 significant digits, long moves with extremely
-           high step counts can exceed the precision of floats, which can lead to lost steps.
-           Fortunately, this scenario is highly unlikely and unrealistic in typical DIY CNC
-           machines (i.e. exceeding 10 meters axis travel at 200 step/mm).
-        */
-        float step_dist_remaining    = prep.step_per_mm * mm_remaining;                       // Convert mm_remaining to steps
-        float n_steps_remaining      = ceilf(step_dist_remaining);                            // Round-up current steps remaining
-        float last_n_steps_remaining = ceilf(prep.steps_remaining);                           // Round-up last steps remaining
-        prep_segment->n_step         = uint16_t(last_n_steps_remaining - n_steps_remaining);  // Compute number of steps to execute.
-
-        // Bail if we are at the end of a feed hold and don't have a step to execute.
-        if (prep_segment->n_step == 0) {
-            if (sys.step_control.executeHold) {
-                // Less than one step to decelerate to zero speed, but already very close. AMASS
-                // requires full steps to execute. So, just bail.
-                sys.step_control.endMotion = true;
-                if (!(prep.recalculate_flag.parking)) {
-                    prep.recalculate_flag.holdPartialBlock = 1;
+        if (prep.shaped) {
+            // The motors follow the shaped motion rather than the block.
+            add_shaped_sample(mm_remaining, dt);
+            if (prep_shaped_segment(prep_segment, dt)) {
+                advance_segment_head();
+            }
+            pl_block->millimeters = mm_remaining;
+        } else {
+            /* -----------------------------------------------------------------------------------
+               Compute segment step rate, steps to execute, and apply necessary rate corrections.
+               NOTE: Steps are computed by direct scalar conversion of the millimeter distance
+               remaining in the block, rather than incrementally tallying the steps executed per
+               segment. This helps in removing floating point round-off issues of several additions.
+               The steps left in the block are counted as an integer, so the block ends on exactly
+               its step count even when the float distance cannot resolve a single step, as on
+               very long moves.
+            */
+            uint32_t period;
+            uint32_t ticks       = uint32_t(dt * (Machine::Stepping::fStepperTimer * 60) + 0.5f);  // (timerTicks)
+            uint32_t n_step      = prep.steps.take(prep.step_per_mm * mm_remaining, ticks, period);
+            prep_segment->n_step = uint16_t(n_step);  // Compute number of steps to execute.
+
+            // Bail if we are at the end of a feed hold and don't have a step to execute.
+            if (prep_segment->n_step == 0) {
+                if (sys.step_control.executeHold) {
+                    // Less than one step to decelerate to zero speed, but already very close. AMASS
+                    // requires full steps to execute. So, just bail.
+                    sys.step_control.endMotion = true;
+                    if (!(prep.recalculate_flag.parking)) {
+                        prep.recalculate_flag.holdPartialBlock = 1;
+                    }
+                    return;  // Segment not generated, but current step data still retained.
                 }
-                return;  // Segment not generated, but current step data still retained.
             }
-        }
 
-        // Compute segment step rate. Since steps are integers and mm distances traveled are not,
-        // the end of every segment can have a partial step of varying magnitudes that are not
-        // executed, because the stepper ISR requires whole steps due to the AMASS algorithm. To
-        // compensate, we track the time to execute the previous segment's partial step and simply
-        // apply it with the partial step distance to the current segment, so that it minutely
-        // adjusts the whole segment rate to keep step output exact. These rate adjustments are
-        // typically very small and do not adversely effect performance, but ensures that the
-        // system outputs the exact acceleration and velocity profiles computed by the planner.
-
-        dt += prep.dt_remainder;  // Apply previous segment partial step execute time
-        // dt is in minutes so inv_rate is in minutes
-        float inv_rate = dt / (last_n_steps_remaining - step_dist_remaining);  // Compute adjusted step rate inverse
-
-        // Compute CPU cycles per step for the prepped segment.
-        // fStepperTimer is in units of timerTicks/sec, so the dimensional analysis is
-        // timerTicks/sec * 60 sec/minute * minutes = timerTicks
-        uint32_t timerTicks = uint32_t(ceilf((Machine::Stepping::fStepperTimer * 60) * inv_rate));  // (timerTicks/step)
-        int      level;
-
-        // Compute step timing and multi-axis smoothing level.
-        for (level = 0; level < maxAmassLevel; level++) {
-            if (timerTicks < amassThreshold) {
-                break;
-            }
-            timerTicks >>= 1;
+            // Since steps are integers and mm distances traveled are not, the end of every segment
+            // can have a partial step of varying magnitudes that are not executed, because the stepper
+            // ISR requires whole steps due to the AMASS algorithm. To compensate, SegmentSteps carries
+            // the time of the previous segment's partial step into the rate of the current segment, so
+            // that it minutely adjusts the whole segment rate to keep step output exact. These rate
+            // adjustments are typically very small and do not adversely effect performance, but ensures
+            // that the system outputs the exact acceleration and velocity profiles computed by the planner.
+            set_segment_period(prep_segment, period);
+
+            // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
+            advance_segment_head();
+
+            // Update the appropriate planner and segment data.
+            pl_block->millimeters = mm_remaining;
         }
-        prep_segment->amass_level = level;
-        prep_segment->n_step <<= level;
-        // isrPeriod is stored as 16 bits, so limit timerTicks to the
-        // largest value that will fit in a uint16_t.
-        prep_segment->isrPeriod = timerTicks > 0xffff ? 0xffff : timerTicks;
-
-        // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
-        auto lastseg        = segment_next_head;
-        segment_next_head   = segment_next_head >= (config->_stepping->_segments - 1) ? 0 : segment_next_head + 1;
-        segment_buffer_head = lastseg;
-
-        // Update the appropriate planner and segment data.
-        pl_block->millimeters = mm_remaining;
-        prep.steps_remaining  = n_steps_remaining;
-        prep.dt_remainder     = (n_steps_remaining - step_dist_remaining) * inv_rate;
         // Check for exit conditions and flag to load next planner block.
         if (mm_remaining == prep.mm_complete) {
             // End of planner block or forced-termination. No more distance to be executed.
@@ -760,10 +959,14 @@ void Stepper::prep_buffer() {
                 // Reset prep parameters for resuming and then bail. Allow the stepper ISR to complete
                 // the segment queue, where realtime protocol will set new state upon receiving the
                 // cycle stop flag from the ISR. Prep_segment is blocked until then.
-                sys.step_control.endMotion = true;
                 if (!(prep.recalculate_flag.parking)) {
                     prep.recalculate_flag.holdPartialBlock = 1;
                 }
+                if (prep.shaped) {
+                    prep.draining = true;  // endMotion is set once the shaped motion stops
+                    continue;
+                }
+                sys.step_control.endMotion = true;
                 return;  // Bail!
             } else {     // End of planner block
                 // The planner block is complete. All steps are set to be executed in the segment buffer.
@@ -771,6 +974,14 @@ void Stepper::prep_buffer() {
                     sys.step_control.endMotion = true;
                     return;
                 }
+                if (prep.shaped) {
+                    // The next block starts where this one ends
+                    auto n_axis = config->_axes->_numberAxis;
+                    for (size_t idx = 0; idx < n_axis; idx++) {
+                        int32_t steps = shaped_source.steps[idx] >> maxAmassLevel;
+                        shaped_start[idx] += bitnum_is_true(shaped_source.direction_bits, idx) ? -steps : steps;
+                    }
+                }
                 pl_block = NULL;  // Set pointer to indicate check and load next planner block.
                 plan_discard_current_block();
             }
@@ -778,6 +989,14 @@ void Stepper::prep_buffer() {
     }
 }
 
+void Stepper::prep_buffer() {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+    prep_segments();
+
+    // If the ISR runs out of segments before the next pass, motion stalls
+    more_planned = !sys.step_control.endMotion && (pl_block != NULL || plan_get_current_block() != NULL || !shaper.settled());
+}
+
 // Called by realtime status reporting to fetch the current speed being executed. This value
 // however is not exactly the current speed, but the speed computed in the last step segment
 // in the segment buffer. It will always be behind by up to the number of segment blocks (-1)
@@ -794,3 +1013,92 @@ float Stepper::get_realtime_rate() {
             return 0.0f;
     }
 }
+
+std::recursive_mutex Stepper::prep_mutex;
+
+static TaskHandle_t prepTask = nullptr;
+
+// Prep task timing, reported with the motion telemetry
+static uint32_t stat_passes    = 0;
+static uint32_t stat_max_ticks = 0;
+
+static bool motion_active() {
+    switch (sys.state) {
+        case State::Cycle:
+        case State::Hold:
+        case State::SafetyDoor:
+        case State::Homing:
+        case State::Jog:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void prepTaskLoop(void* unused) {
+    for (;;) {
+        // While motion is active the task tops up the buffer every tick, and
+        // request_prep() wakes it early.  Otherwise it sleeps until cycle start
+        // or plan_buffer_line() wakes it.
+        ulTaskNotifyTake(pdTRUE, motion_active() ? 1 : portMAX_DELAY);
+
+        std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+        if (motion_active()) {
+            uint32_t head  = segment_buffer_head;
+            int32_t  start = getCpuTicks();
+            prep_buffer();
+            uint32_t ticks = getCpuTicks() - start;
+            if (segment_buffer_head != head) {
+                ++stat_passes;
+                if (ticks > stat_max_ticks) {
+                    stat_max_ticks = ticks;
+                }
+            }
+        }
+    }
+}
+
+void Stepper::start_prep_task() {
+    if (!prepTask) {
+        xTaskCreatePinnedToCore(prepTaskLoop,                // task
+                                "segprep",                   // name for task
+                                4096,                        // size of task stack
+                                0,                           // parameters
+                                SEGMENT_PREP_TASK_PRIORITY,  // priority
+                                &prepTask,                   // task handle
+                                SEGMENT_PREP_TASK_CORE       // core
+        );
+    }
+}
+
+void Stepper::request_prep() {
+    if (prepTask) {
+        xTaskNotifyGive(prepTask);
+    } else {
+        prep_buffer();
+    }
+}
+
+void Stepper::get_motion_stats(motion_stats_t& stats) {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+    stats.segments     = segment_fill;
+    stats.planner      = planner_fill;
+    stats.segment_size = config->_stepping->_segments - 1;
+    stats.planner_size = config->_planner_blocks - 1;
+    stats.prep_passes  = stat_passes;
+    stats.prep_max_us  = stat_max_ticks / ticks_per_us;
+    stats.starvations  = stat_starvations;
+    stats.n_starved    = stats.starvations < STARVED_LINES ? stats.starvations : STARVED_LINES;
+    for (size_t i = 0; i < stats.n_starved; i++) {
+        stats.starved_lines[i] = starved_lines[STARVED_LINES - stats.n_starved + i];
+    }
+}
+
+void Stepper::clear_motion_stats() {
+    std::lock_guard<std::recursive_mutex> lock(prep_mutex);
+    segment_fill.clear();
+    planner_fill.clear();
+    stat_starvations = 0;
+    stat_passes      = 0;
+    stat_max_ticks   = 0;
+}
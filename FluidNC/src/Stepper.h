@@ -10,8 +10,11 @@
 */
 
 #include "EnumItem.h"
+#include "OccupancyHistogram.h"
 
 #include <cstdint>
+#include <cstddef>
+#include <mutex>
 
 namespace Stepper {
     void init();
@@ -30,15 +33,50 @@ namespace Stepper {
     // Reset the stepper subsystem variables
     void reset();
 
+    // Discards all queued motion, resetting the stepper subsystem and the
+    // planner under one lock so that the prep task cannot load a block
+    // between the two
+    void flush();
+
     // Changes the run state of the step segment buffer to execute the special parking motion.
     void parking_setup_buffer();
 
     // Restores the step segment buffer to the normal run state after a parking motion.
     void parking_restore_buffer();
 
-    // Reloads step segment buffer. Called continuously by realtime execution system.
+    // Reloads step segment buffer. Called continuously by the prep task.
     void prep_buffer();
 
+    // Segment preparation runs in a task of its own on the support core,
+    // so G-code parsing on the main core cannot starve the step segment
+    // buffer.  Code in other tasks holds prep_mutex while it changes the
+    // planner blocks or the flags that prep_buffer() follows.
+    extern std::recursive_mutex prep_mutex;
+
+    void start_prep_task();
+
+    // Wakes the prep task to refill the step segment buffer, or refills
+    // it directly if there is no prep task.
+    void request_prep();
+
+    // Motion telemetry.  A starvation is the ISR running out of segments
+    // while more motion is planned, so the machine stalls.
+    const size_t STARVED_LINES = 8;
+
+    struct motion_stats_t {
+        OccupancyHistogram segments;      // Ready segments, sampled as each segment is prepped
+        OccupancyHistogram planner;       // Planner blocks, sampled at the same times
+        uint32_t           segment_size;  // Most segments that can be ready
+        uint32_t           planner_size;  // Most blocks the planner can hold
+        uint32_t           prep_passes;   // Prep task passes that added segments
+        uint32_t           prep_max_us;   // Longest of those passes
+        uint32_t           starvations;
+        size_t             n_starved;
+        int32_t            starved_lines[STARVED_LINES];  // Line numbers of the latest starvations, oldest first
+    };
+    void get_motion_stats(motion_stats_t& stats);
+    void clear_motion_stats();
+
     // Called by planner_recalculate() when the executing block is updated by the new plan.
     bool update_plan_block_parameters();
 
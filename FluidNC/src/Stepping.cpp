@@ -41,6 +41,7 @@ namespace Machine {
     void Stepping::beginLowLatency() {
         _switchedStepper = _engine == I2S_STREAM;
         if (_switchedStepper) {
+            ++_lowLatencySwitches;
             _engine = I2S_STATIC;
             i2s_out_set_passthrough();
             i2s_out_delay();  // Wait for a change in mode.
@@ -47,6 +47,9 @@ namespace Machine {
 
         static int _engine;
 
+        // Times that I2S_STREAM fell back to I2S_STATIC for homing or probing, reported by $I2SO/Stats
+        uint32_t _lowLatencySwitches = 0;
+
         // Interfaces to stepping engine
         void init();
 
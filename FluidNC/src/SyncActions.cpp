@@ -0,0 +1,95 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "SyncActions.h"
+
+#include "Machine/MachineConfig.h"  // config
+#include "Protocol.h"               // protocol_send_event_from_ISR
+
+#include <esp_attr.h>  // IRAM_ATTR
+
+namespace {
+    struct SyncAction {
+        uint32_t       id;
+        SyncActionType type;
+        uint8_t        io_num;
+        float          value;
+    };
+
+    // A handful of entries covers the output changes that fit in the planner
+    // queue of a typical dispensing job; when it fills up, GCode falls back
+    // to synchronizing.
+    const int  queueSize = 16;
+    SyncAction queue[queueSize];
+    int        head = 0;  // Next free entry
+    int        tail = 0;  // Oldest queued entry
+
+    uint32_t          lastId    = 0;  // Id of the most recently queued action
+    uint32_t          claimedId = 0;  // Newest id attached to a planner block
+    volatile uint32_t reachedId = 0;  // Newest id whose planner block the stepper has started
+
+    int next(int index) { return index == queueSize - 1 ? 0 : index + 1; }
+
+    void perform(const SyncAction& action) {
+        switch (action.type) {
+            case SyncActionType::Digital:
+                config->_userOutputs->setDigital(action.io_num, action.value != 0.0f);
+                break;
+            case SyncActionType::Analog:
+                config->_userOutputs->setAnalogPercent(action.io_num, action.value);
+                break;
+        }
+    }
+
+    void run_through(uint32_t id) {
+        while (tail != head && int32_t(id - queue[tail].id) >= 0) {
+            perform(queue[tail]);
+            tail = next(tail);
+        }
+    }
+}
+
+const NoArgEvent syncActionEvent { sync_action_run_reached };
+
+bool sync_action_queue(SyncActionType type, uint8_t io_num, float value) {
+    if (next(head) == tail) {
+        return false;
+    }
+    if (++lastId == 0) {
+        lastId = 1;  // 0 means "no action" in planner blocks
+    }
+    queue[head] = { lastId, type, io_num, value };
+    head        = next(head);
+    return true;
+}
+
+bool sync_action_pending() {
+    return head != tail;
+}
+
+uint32_t sync_action_claim() {
+    if (head == tail || claimedId == lastId) {
+        return 0;
+    }
+    claimedId = lastId;
+    return claimedId;
+}
+
+void IRAM_ATTR sync_action_reached_from_ISR(uint32_t id) {
+    reachedId = id;
+    protocol_send_event_from_ISR(&syncActionEvent);
+}
+
+void sync_action_run_reached() {
+    run_through(reachedId);
+}
+
+void sync_action_run_all() {
+    run_through(lastId);
+}
+
+void sync_action_reset() {
+    tail      = head;
+    claimedId = lastId;
+    reachedId = lastId;
+}
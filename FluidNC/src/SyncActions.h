@@ -0,0 +1,42 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Synchronized output changes (M62, M63 and M67) are queued here instead of
+// draining the planner.  Each queued action gets an increasing id, and the
+// next planner block that is buffered claims the newest id.  When the stepper
+// ISR starts that block it reports the id, and the protocol task performs
+// every action up to it.  Whatever is still queued when motion comes to a
+// complete stop is performed then.  Motion thus keeps its speed across the
+// output change, which takes effect at the block boundary.
+
+#include <cstdint>
+
+enum class SyncActionType : uint8_t {
+    Digital,
+    Analog,
+};
+
+// Returns false if the queue is full, in which case the caller must
+// synchronize and perform the action itself.
+bool sync_action_queue(SyncActionType type, uint8_t io_num, float value);
+
+// True if an action is waiting for motion to reach it
+bool sync_action_pending();
+
+// Id of the newest action not yet attached to a planner block, or 0.
+// Called by the planner when it buffers a block.
+uint32_t sync_action_claim();
+
+// Called by the stepper ISR when it starts a block that claimed an id
+void sync_action_reached_from_ISR(uint32_t id);
+
+// Performs the actions whose blocks have been reached
+void sync_action_run_reached();
+
+// Performs every queued action; used when motion has stopped
+void sync_action_run_all();
+
+// Discards queued actions after a reset
+void sync_action_reset();
@@ -109,9 +109,12 @@ size_t UartChannel::timedReadBytes(char* buffer, size_t length, TickType_t timeo
     // used in situations where the UART is not receiving GCode commands
     // and Grbl realtime characters.
     size_t remlen = length;
-    while (remlen && _queue.size()) {
-        *buffer++ = _queue.front();
-        _queue.pop();
+    if (queued()) {
+        size_t len = std::min(remlen, queued());
+        memcpy(buffer, queuedSpan().data(), len);
+        consume(len);
+        buffer += len;
+        remlen -= len;
     }
 
     int res = _uart->timedReadBytes(buffer, remlen, timeout);
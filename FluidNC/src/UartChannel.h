@@ -39,6 +39,7 @@ public:
     size_t timedReadBytes(uint8_t* buffer, size_t length, TickType_t timeout) { return timedReadBytes((char*)buffer, length, timeout); };
     bool   realtimeOkay(char c) override;
     bool   lineComplete(char* line, char c) override;
+    bool   scanLine(char* line, std::string_view& span) override { return scanLineBytewise(line, span); }
 
     void out(const std::string& s, const char* tag) override;
     void out_acked(const std::string& s, const char* tag) override;
@@ -0,0 +1,26 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "NotificationServer.h"
+
+#include <cstdlib>
+
+namespace WebUI {
+    bool NotificationServer::parse(const std::string& ts) {
+        size_t hash  = ts.find('#');
+        size_t colon = ts.rfind(':');
+        if (hash == std::string::npos || colon == std::string::npos || colon <= hash + 1 || hash == 0) {
+            return false;
+        }
+        std::string digits = ts.substr(colon + 1);
+        char*       end;
+        long        value = strtol(digits.c_str(), &end, 10);
+        if (digits.empty() || *end || value < 1 || value > 65535) {
+            return false;
+        }
+        address = ts.substr(0, hash);
+        host    = ts.substr(hash + 1, colon - hash - 1);
+        port    = uint16_t(value);
+        return true;
+    }
+}
@@ -0,0 +1,21 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace WebUI {
+    // The EMAIL notification TS setting, "address#server:port".  The
+    // address is used as both the sender and the recipient.
+    struct NotificationServer {
+        std::string address;
+        std::string host;
+        uint16_t    port = 0;
+
+        // Returns false, leaving the members unchanged, unless ts has a
+        // non-empty address and host and a port in 1..65535
+        bool parse(const std::string& ts);
+    };
+}
@@ -14,11 +14,13 @@
 
 #include "src/Settings.h"
 #include "NotificationsService.h"
+#include "NotificationServer.h"
 
 #include "src/Machine/MachineConfig.h"
 
 #include <WiFiClientSecure.h>
 #include <base64.h>
+#include <memory>
 
 namespace WebUI {
     static const int PUSHOVER_NOTIFICATION = 1;
@@ -42,7 +44,15 @@ namespace WebUI {
 
     static const int EMAILTIMEOUT = 5000;
 
-    bool        NotificationsService::_started = false;
+    static const size_t   MAX_QUEUED       = 8;     // Notifications waiting for delivery
+    static const size_t   MAX_MESSAGE      = 1024;  // Longest combined message
+    static const uint32_t COALESCE_MS      = 500;   // Wait for the rest of a burst
+    static const int      MAX_ATTEMPTS     = 4;
+    static const uint32_t FIRST_BACKOFF_MS = 2000;  // Doubled after each failure
+    static const uint32_t DELIVERY_STACK   = 8192;  // TLS handshakes need most of this; see $Notification/Stats
+
+    bool        NotificationsService::_started   = false;
+    bool        NotificationsService::_plainText = false;
     uint8_t     NotificationsService::_notificationType;
     std::string NotificationsService::_token1;
     std::string NotificationsService::_token2;
@@ -50,6 +60,12 @@ namespace WebUI {
     std::string NotificationsService::_serveraddress;
     uint16_t    NotificationsService::_port;
 
+    std::deque<NotificationsService::Notification> NotificationsService::_queue;
+    std::mutex                                     NotificationsService::_queueMutex;
+    volatile TaskHandle_t                          NotificationsService::_deliveryTask = nullptr;
+    std::atomic<bool>                              NotificationsService::_stopping     = false;
+    NotificationsService::Stats                    NotificationsService::_stats        = {};
+
     const enum_opt_t notificationOptions = {
         { "NONE", 0 },
         { "LINE", 3 },
@@ -60,6 +76,7 @@ namespace WebUI {
     StringSetting* notification_t1;
     StringSetting* notification_t2;
     StringSetting* notification_ts;
+    EnumSetting*   notification_plain;
 
     static Error showSetNotification(const char* parameter, AuthenticationLevel auth_level, Channel& out) {  // ESP610
         if (*parameter == '\0') {
@@ -108,14 +125,138 @@ namespace WebUI {
             log_string(out, "Invalid message!");
             return Error::InvalidValue;
         }
-        if (!sendMSG("GRBL Notification", parameter)) {
+        // Delivery failures are reported by the delivery task
+        if (!queueMSG("GRBL Notification", parameter)) {
             log_string(out, "Cannot send message!");
             return Error::MessageFailed;
         }
         return Error::Ok;
     }
 
-    bool Wait4Answer(WiFiClientSecure& client, const char* linetrigger, const char* expected_answer, uint32_t timeout) {
+    Error NotificationsService::showStats(const char* parameter, AuthenticationLevel auth_level, Channel& out) {
+        Stats  stats;
+        size_t waiting;
+        {
+            std::lock_guard<std::mutex> lock(_queueMutex);
+            stats   = _stats;
+            waiting = _queue.size();
+        }
+        log_stream(out,
+                   "Notifications queued:" << stats.queued << " coalesced:" << stats.coalesced << " dropped:" << stats.dropped
+                                           << " waiting:" << waiting);
+        log_stream(out, "Delivered:" << stats.sent << " failed:" << stats.failed << " retries:" << stats.retries);
+        if (_deliveryTask) {
+            log_stream(out, "Delivery task stack unused:" << uxTaskGetStackHighWaterMark(_deliveryTask) << " of " << DELIVERY_STACK);
+        }
+        if (stats.sent) {
+            log_stream(out,
+                       "Latency ms min:" << stats.minLatencyMs << " avg:" << uint32_t(stats.totalLatencyMs / stats.sent)
+                                         << " max:" << stats.maxLatencyMs);
+        }
+        return Error::Ok;
+    }
+
+    bool NotificationsService::queueMSG(const char* title, const char* message) {
+        if (!_started || !_deliveryTask) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_queueMutex);
+            ++_stats.queued;
+            // The last entry has not been picked up by the delivery task yet
+            if (!_queue.empty()) {
+                auto& last = _queue.back();
+                if (last.title == title && last.message.length() + strlen(message) < MAX_MESSAGE) {
+                    last.message += "\n";
+                    last.message += message;
+                    ++last.count;
+                    ++_stats.coalesced;
+                    return true;
+                }
+            }
+            if (_queue.size() >= MAX_QUEUED) {
+                ++_stats.dropped;
+                return false;
+            }
+            // Truncate a message that is too long on its own
+            _queue.push_back({ title, std::string(message, strnlen(message, MAX_MESSAGE)), millis(), 1 });
+        }
+        xTaskNotifyGive(_deliveryTask);
+        return true;
+    }
+
+    // The task exits when deinit() sets _stopping, so that the settings it
+    // reads are not cleared while a message is being sent.
+    void NotificationsService::deliveryTask(void* arg) {
+        while (!_stopping) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            // Let a burst of messages collect so they are sent together
+            vTaskDelay(COALESCE_MS / portTICK_PERIOD_MS);
+            while (!_stopping) {
+                Notification notification;
+                {
+                    std::lock_guard<std::mutex> lock(_queueMutex);
+                    if (_queue.empty()) {
+                        break;
+                    }
+                    notification = std::move(_queue.front());
+                    _queue.pop_front();
+                }
+                deliver(notification);
+            }
+        }
+        _deliveryTask = nullptr;
+        vTaskDelete(nullptr);
+    }
+
+    void NotificationsService::deliver(Notification& notification) {
+        uint32_t backoff = FIRST_BACKOFF_MS;
+        for (int attempt = 1; _started; ++attempt) {
+            if (sendMSG(notification.title.c_str(), notification.message.c_str())) {
+                uint32_t latency = millis() - notification.queuedMs;
+
+                std::lock_guard<std::mutex> lock(_queueMutex);
+                if (!_stats.sent || latency < _stats.minLatencyMs) {
+                    _stats.minLatencyMs = latency;
+                }
+                if (latency > _stats.maxLatencyMs) {
+                    _stats.maxLatencyMs = latency;
+                }
+                _stats.totalLatencyMs += latency;
+                ++_stats.sent;
+                return;
+            }
+            if (attempt == MAX_ATTEMPTS) {
+                break;
+            }
+            log_debug("Notification failed, retrying in " << backoff << " ms");
+            // Short sleeps so that deinit() does not wait out the backoff
+            for (uint32_t waited = 0; _started && waited < backoff; waited += 100) {
+                vTaskDelay(100 / portTICK_PERIOD_MS);
+            }
+            backoff *= 2;
+
+            std::lock_guard<std::mutex> lock(_queueMutex);
+            ++_stats.retries;
+        }
+        log_error("Cannot send notification " << notification.title);
+
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        ++_stats.failed;
+    }
+
+    WiFiClient* NotificationsService::newClient(bool insecure) {
+        if (_plainText) {
+            return new WiFiClient();
+        }
+        auto client = new WiFiClientSecure();
+        if (insecure) {
+            client->setInsecure();
+        }
+        return client;
+    }
+
+    bool Wait4Answer(WiFiClient& client, const char* linetrigger, const char* expected_answer, uint32_t timeout) {
         if (client.connected()) {
             std::string answer;
             uint32_t    start_time = millis();
@@ -186,9 +327,10 @@ namespace WebUI {
     //Messages are currently limited to 1024 4-byte UTF-8 characters
     //but we do not do any check
     bool NotificationsService::sendPushoverMSG(const char* title, const char* message) {
-        std::string      data, postcmd;
-        bool             res;
-        WiFiClientSecure Notificationclient;
+        std::string                 data, postcmd;
+        bool                        res;
+        std::unique_ptr<WiFiClient> client(newClient(false));
+        WiFiClient&                 Notificationclient = *client;
         if (!Notificationclient.connect(_serveraddress.c_str(), _port)) {
             return false;
         }
@@ -218,15 +360,18 @@ namespace WebUI {
     }
 
     bool NotificationsService::sendEmailMSG(const char* title, const char* message) {
-        WiFiClientSecure Notificationclient;
         // Switch off secure mode because the connect command always fails in secure mode:(
-        Notificationclient.setInsecure();
+        std::unique_ptr<WiFiClient> client(newClient(true));
+        WiFiClient&                 Notificationclient = *client;
 
         if (!Notificationclient.connect(_serveraddress.c_str(), _port)) {
             //Read & log error message (in debug mode)
             if (atMsgLevel(MsgLevelDebug)) {
-                char      errMsg[150];
-                const int lastError = Notificationclient.lastError(errMsg, sizeof(errMsg));
+                char errMsg[150];
+                int  lastError = 0;
+                if (!_plainText) {
+                    lastError = static_cast<WiFiClientSecure&>(Notificationclient).lastError(errMsg, sizeof(errMsg));
+                }
                 if (0 == lastError) {
                     errMsg[0] = 0;
                 }
@@ -294,9 +439,10 @@ namespace WebUI {
         return true;
     }
     bool NotificationsService::sendLineMSG(const char* title, const char* message) {
-        std::string      data, postcmd;
-        bool             res;
-        WiFiClientSecure Notificationclient;
+        std::string                 data, postcmd;
+        bool                        res;
+        std::unique_ptr<WiFiClient> client(newClient(false));
+        WiFiClient&                 Notificationclient = *client;
         (void)title;
         if (!Notificationclient.connect(_serveraddress.c_str(), _port)) {
             return false;
@@ -320,49 +466,12 @@ namespace WebUI {
         Notificationclient.stop();
         return res;
     }
-    //Email#serveraddress:port
-    bool NotificationsService::getPortFromSettings() {
-        std::string tmp(notification_ts->get());
-        size_t      pos = tmp.rfind(':');
-        if (pos == std::string::npos) {
-            return false;
-        }
-
-        try {
-            _port = stoi(tmp.substr(pos + 1));
-        } catch (...) { return false; }
-        return true;
-    }
-    //Email#serveraddress:port
-    bool NotificationsService::getServerAddressFromSettings() {
-        std::string tmp(notification_ts->get());
-        int         pos1 = tmp.find('#');
-        int         pos2 = tmp.rfind(':');
-        if ((pos1 == std::string::npos) || (pos2 == std::string::npos)) {
-            return false;
-        }
-
-        //TODO add a check for valid email ?
-        _serveraddress = tmp.substr(pos1 + 1, pos2 - pos1 - 1);
-        return true;
-    }
-    //Email#serveraddress:port
-    bool NotificationsService::getEmailFromSettings() {
-        std::string tmp(notification_ts->get());
-        int         pos = tmp.find('#');
-        if (pos == std::string::npos) {
-            return false;
-        }
-        _settings = tmp.substr(0, pos);
-        //TODO add a check for valid email ?
-        return true;
-    }
-
     void NotificationsService::init() {
         deinit();
 
         new WebCommand(
             "TYPE=NONE|PUSHOVER|EMAIL|LINE T1=token1 T2=token2 TS=settings", WEBCMD, WA, "ESP610", "Notification/Setup", showSetNotification);
+        notification_plain = new EnumSetting("Notification Plain Text", WEBSET, WA, NULL, "Notification/PlainText", false, &onoffOptions);
         notification_ts = new StringSetting(
             "Notification Settings", WEBSET, WA, NULL, "Notification/TS", DEFAULT_TOKEN, 0, MAX_NOTIFICATION_SETTING_LENGTH);
         notification_t2 = new StringSetting("Notification Token 2",
@@ -384,6 +493,7 @@ namespace WebUI {
         notification_type =
             new EnumSetting("Notification type", WEBSET, WA, NULL, "Notification/Type", DEFAULT_NOTIFICATION_TYPE, &notificationOptions);
         new WebCommand("message", WEBCMD, WU, "ESP600", "Notification/Send", sendMessage);
+        new WebCommand(NULL, WEBCMD, WU, NULL, "Notification/Stats", showStats, anyState);
 
         _notificationType = notification_type->get();
         switch (_notificationType) {
@@ -400,13 +510,22 @@ namespace WebUI {
                 _port          = LINEPORT;
                 _serveraddress = LINESERVER;
                 break;
-            case EMAIL_NOTIFICATION:
-                _token1 = base64::encode(notification_t1->get()).c_str();
-                _token2 = base64::encode(notification_t2->get()).c_str();
-                if (!getEmailFromSettings() || !getPortFromSettings() || !getServerAddressFromSettings()) {
+            case EMAIL_NOTIFICATION: {
+                NotificationServer server;
+                if (!server.parse(notification_ts->get())) {
                     return;
                 }
-                break;
+                _token1        = base64::encode(notification_t1->get()).c_str();
+                _token2        = base64::encode(notification_t2->get()).c_str();
+                _settings      = server.address;
+                _serveraddress = server.host;
+                _port          = server.port;
+                // Only for a local stand-in server; AUTH LOGIN sends the credentials as they are
+                _plainText = notification_plain->get();
+                if (_plainText) {
+                    log_warn("Notification email is sent without TLS");
+                }
+            } break;
             default:
                 return;
                 break;
@@ -419,6 +538,20 @@ namespace WebUI {
             deinit();
         }
         _started = res;
+
+        if (_started && !_deliveryTask) {
+            TaskHandle_t task;
+            _stopping = false;
+            xTaskCreatePinnedToCore(deliveryTask,       // task
+                                    "notifications",    // name for task
+                                    DELIVERY_STACK,     // size of task stack
+                                    nullptr,            // parameters
+                                    1,                  // priority - same as the poller
+                                    &task,              // task handle
+                                    SUPPORT_TASK_CORE  // core
+            );
+            _deliveryTask = task;
+        }
     }
 
     void NotificationsService::deinit() {
@@ -426,13 +559,26 @@ namespace WebUI {
             return;
         }
 
-        _started          = false;
+        _started = false;
+        {
+            std::lock_guard<std::mutex> lock(_queueMutex);
+            _queue.clear();
+        }
+        // Wait for the delivery task to finish its current attempt and exit
+        if (_deliveryTask) {
+            _stopping = true;
+            xTaskNotifyGive(_deliveryTask);
+            while (_deliveryTask) {
+                vTaskDelay(10 / portTICK_PERIOD_MS);
+            }
+        }
         _notificationType = 0;
         _token1           = "";
-        _token1           = "";
+        _token2           = "";
         _settings         = "";
         _serveraddress    = "";
         _port             = 0;
+        _plainText        = false;
     }
 
     NotificationsService::~NotificationsService() {
@@ -444,5 +590,5 @@ namespace WebUI {
 
 // Override weak link
 void notify(const char* title, const char* msg) {
-    WebUI::NotificationsService::sendMSG(title, msg);
+    WebUI::NotificationsService::queueMSG(title, msg);
 }
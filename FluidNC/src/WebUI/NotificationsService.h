@@ -6,20 +6,38 @@
 #include "src/Module.h"  // Module
 #include "src/WebUI/Authentication.h"
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
 #include <cstdint>
+#include <deque>
+#include <mutex>
+
+class WiFiClient;
 
 namespace WebUI {
+    // Notifications are queued by notify(), which is called from time
+    // critical tasks such as the input poller, and are delivered by a
+    // background task, because sending one can take seconds.  Messages
+    // with the same title that arrive while delivery is pending are
+    // combined into one notification.
     class NotificationsService : public Module {
     public:
         NotificationsService(const char* name) : Module(name) {
             _started          = false;
             _notificationType = 0;
             _token1           = "";
-            _token1           = "";
+            _token2           = "";
             _settings         = "";
         }
 
-        static bool        sendMSG(const char* title, const char* message);
+        // Sends a message immediately, blocking until the server answers
+        static bool sendMSG(const char* title, const char* message);
+
+        // Queues a message for the delivery task; returns false if it was dropped
+        static bool queueMSG(const char* title, const char* message);
+
         static const char* getTypeString();
         static bool        started();
 
@@ -30,6 +48,7 @@ namespace WebUI {
 
     private:
         static bool        _started;
+        static bool        _plainText;  // EMAIL without TLS, for a local stand-in server
         static uint8_t     _notificationType;
         static std::string _token1;
         static std::string _token2;
@@ -37,12 +56,39 @@ namespace WebUI {
         static std::string _serveraddress;
         static uint16_t    _port;
 
+        struct Notification {
+            std::string title;
+            std::string message;
+            uint32_t    queuedMs;  // When the first message was queued
+            uint32_t    count;     // Number of messages combined
+        };
+
+        struct Stats {
+            uint32_t queued;
+            uint32_t coalesced;
+            uint32_t dropped;
+            uint32_t sent;
+            uint32_t failed;
+            uint32_t retries;
+            uint32_t minLatencyMs;
+            uint32_t maxLatencyMs;
+            uint64_t totalLatencyMs;
+        };
+
+        static std::deque<Notification> _queue;
+        static std::mutex               _queueMutex;
+        static volatile TaskHandle_t    _deliveryTask;  // Cleared by the task when it exits
+        static std::atomic<bool>        _stopping;
+        static Stats                    _stats;
+
+        static void        deliveryTask(void* arg);
+        static void        deliver(Notification& notification);
+        static WiFiClient* newClient(bool insecure);
+
         static Error sendMessage(const char* parameter, AuthenticationLevel auth_level, Channel& out);
+        static Error showStats(const char* parameter, AuthenticationLevel auth_level, Channel& out);
         static bool  sendPushoverMSG(const char* title, const char* message);
         static bool  sendEmailMSG(const char* title, const char* message);
         static bool  sendLineMSG(const char* title, const char* message);
-        static bool  getPortFromSettings();
-        static bool  getServerAddressFromSettings();
-        static bool  getEmailFromSettings();
     };
 }
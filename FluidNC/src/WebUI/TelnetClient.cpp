@@ -19,6 +19,7 @@ namespace WebUI {
     }
 
     void TelnetClient::flushRx() {
+        _rxHead = _rxTail = 0;
         Channel::flushRx();
     }
 
@@ -26,13 +27,15 @@ namespace WebUI {
         return write(&data, 1);
     }
 
+    // The translated output is collected in a stack buffer large enough
+    // for a typical message, so most messages cost a single send().
     size_t TelnetClient::write(const uint8_t* buffer, size_t length) {
         // Replace \n with \r\n
         size_t  rem      = length;
         uint8_t lastchar = '\0';
         size_t  j        = 0;
         while (rem) {
-            const int bufsize = 128;
+            const int bufsize = 256;
             uint8_t   modbuf[bufsize];
             // bufsize-1 in case the last character is \n
             size_t k = 0;
@@ -55,12 +58,39 @@ namespace WebUI {
         return length;
     }
 
+    // Reads whatever the socket has into the receive buffer, counting
+    // empty reads for the periodic disconnect check
+    bool TelnetClient::fill() {
+        if (_state == -1) {
+            return false;
+        }
+        int res = _wifiClient->read(_rxbuf, sizeof(_rxbuf));
+        if (res <= 0) {
+            // calling _wifiClient->connected() is expensive when the client is
+            // connected because it calls recv() to double check, so we check
+            // infrequently, only after quite a few reads have returned no data
+            if (++_state >= DISCONNECT_CHECK_COUNTS) {
+                _state = 0;
+                closeOnDisconnect();  // sets _state to -1 if disconnected
+            }
+            return false;
+        }
+        // Reset the counter if we have data
+        _state  = 0;
+        _rxHead = 0;
+        _rxTail = res;
+        return true;
+    }
+
     int TelnetClient::peek(void) {
-        return _wifiClient->peek();
+        if (buffered() || fill()) {
+            return _rxbuf[_rxHead];
+        }
+        return -1;
     }
 
     int TelnetClient::available() {
-        return _wifiClient->available();
+        return buffered() + _wifiClient->available();
     }
 
     int TelnetClient::rx_buffer_available() {
@@ -68,23 +98,22 @@ namespace WebUI {
     }
 
     int TelnetClient::read(void) {
-        if (_state == -1) {
-            return -1;
+        if (buffered() || fill()) {
+            return _rxbuf[_rxHead++];
         }
-        auto ret = _wifiClient->read();
-        if (ret < 0) {
-            // calling _wifiClient->connected() is expensive when the client is
-            // connected because it calls recv() to double check, so we check
-            // infrequently, only after quite a few reads have returned no data
-            if (++_state >= DISCONNECT_CHECK_COUNTS) {
-                _state = 0;
-                closeOnDisconnect();  // sets _state to -1 if disconnected
-            }
-        } else {
-            // Reset the counter if we have data
-            _state = 0;
+        return -1;
+    }
+
+    // Telnet does no line editing, so everything the socket has can be
+    // taken in one call and scanned for lines as a block.
+    size_t TelnetClient::readSpan(uint8_t* buffer, size_t length) {
+        if (!buffered() && !fill()) {
+            return 0;
         }
-        return ret;
+        size_t len = std::min(length, buffered());
+        memcpy(buffer, _rxbuf + _rxHead, len);
+        _rxHead += len;
+        return len;
     }
 
     TelnetClient::~TelnetClient() {
@@ -23,6 +23,16 @@ namespace WebUI {
 
         int _state = 0;
 
+        // Each socket read takes as much as the client has, up to a full
+        // frame, so the lwIP layer is entered once per batch rather than
+        // once per character.  readSpan() hands out the batch from here.
+        uint8_t _rxbuf[WIFI_CLIENT_READ_BUFFER_SIZE];
+        size_t  _rxHead = 0;
+        size_t  _rxTail = 0;
+
+        size_t buffered() const { return _rxTail - _rxHead; }
+        bool   fill();
+
     public:
         TelnetClient(WiFiClient* wifiClient);
 
@@ -30,6 +40,7 @@ namespace WebUI {
         size_t write(uint8_t data) override;
         size_t write(const uint8_t* buffer, size_t size) override;
         int    read(void) override;
+        size_t readSpan(uint8_t* buffer, size_t length) override;
         int    peek(void) override;
         int    available() override;
         void   flush() override {}
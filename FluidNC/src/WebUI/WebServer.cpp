@@ -27,6 +27,7 @@
 #include "src/JSONEncoder.h"
 
 #include "src/HashFS.h"
+#include "src/DirIndex.h"
 #include <list>
 
 namespace WebUI {
@@ -939,6 +940,7 @@ namespace WebUI {
             if (action == "delete") {
                 if (stdfs::remove(fpath / filename, ec)) {
                     sstatus = filename + " deleted";
+                    DirIndex::invalidate(fpath / filename);
                     HashFS::delete_file(fpath / filename);
                 } else {
                     sstatus = "Cannot delete ";
@@ -950,6 +952,7 @@ namespace WebUI {
                 int count = stdfs::remove_all(dirpath, ec);
                 if (count > 0) {
                     sstatus = filename + " deleted";
+                    DirIndex::invalidate(dirpath);
                     HashFS::report_change();
                 } else {
                     log_debug("remove_all returned " << count);
@@ -959,6 +962,7 @@ namespace WebUI {
             } else if (action == "createdir") {
                 if (stdfs::create_directory(fpath / filename, ec)) {
                     sstatus = filename + " created";
+                    DirIndex::invalidate(fpath / filename);
                     HashFS::report_change();
                 } else {
                     sstatus = "Cannot create ";
@@ -975,6 +979,8 @@ namespace WebUI {
                         sstatus += filename + " " + ec.message();
                     } else {
                         sstatus = filename + " renamed to " + newname;
+                        DirIndex::invalidate(fpath / filename);
+                        DirIndex::invalidate(fpath / newname);
                         HashFS::rename_file(fpath / filename, fpath / newname);
                     }
                 }
@@ -986,19 +992,23 @@ namespace WebUI {
             list_files = false;
         }
 
-        std::string s;
-        JSONencoder j(&s);
+        // Large directories make long listings, so send the JSON in
+        // chunks as it is encoded instead of building it in memory
+        _webserver->sendHeader("Cache-Control", "no-cache");
+        _webserver->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        _webserver->send(200, "application/json", "");
+        JSONencoder j([](const char* data, size_t length) { _webserver->sendContent(data, length); });
         j.begin();
 
         if (list_files) {
-            auto iter = stdfs::directory_iterator { fpath, ec };
+            auto entries = DirIndex::get(fpath, ec);
             if (!ec) {
                 j.begin_array("files");
-                for (auto const& dir_entry : iter) {
+                for (auto const& entry : *entries) {
                     j.begin_object();
-                    j.member("name", dir_entry.path().filename());
-                    j.member("shortname", dir_entry.path().filename());
-                    j.member("size", dir_entry.is_directory() ? -1 : dir_entry.file_size());
+                    j.member("name", entry.name);
+                    j.member("shortname", entry.name);
+                    j.member("size", std::to_string(entry.size));
                     j.member("datetime", "");
                     j.end_object();
                 }
@@ -1019,7 +1029,7 @@ namespace WebUI {
         j.member("occupation", percent);
         j.member("status", sstatus);
         j.end();
-        sendJSON(200, s);
+        _webserver->sendContent("");
     }
 
     void Web_Server::handle_direct_SDFileList() {
@@ -1143,6 +1153,7 @@ namespace WebUI {
                 delete _uploadFile;
                 _uploadFile = nullptr;
                 stdfs::remove(filepath, error_code);
+                DirIndex::invalidate(filepath);
                 HashFS::rehash_file(filepath);
             }
         }
@@ -0,0 +1,137 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/Kinematics/DeltaTable.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace Kinematics;
+
+// The default ParallelDelta geometry
+static const DeltaArm arm = { 70.0, 179.437, 133.50, 86.603 };
+
+static const float radius = 100;
+static const float minZ   = -210;
+static const float maxZ   = -40;
+
+// Targets along random lines through the work envelope, 1 mm apart like
+// kinematic segments, expressed in the frames of the three arms the way
+// ParallelDelta::transform_cartesian_to_motors() does
+static std::vector<float> targets(size_t n) {
+    const float sin120 = std::sqrt(3.0f) / 2;
+    const float cos120 = -0.5;
+
+    std::mt19937                          gen(1234);
+    std::uniform_real_distribution<float> xy(-60, 60);
+    std::uniform_real_distribution<float> z(-180, -80);
+    std::vector<float>                    v;
+    float                                 from[3] = { 0, 0, -130 };
+    while (v.size() < n * 9) {
+        float to[3] = { xy(gen), xy(gen), z(gen) };
+        float d[3]  = { to[0] - from[0], to[1] - from[1], to[2] - from[2] };
+        int   steps = int(std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2])) + 1;
+        for (int i = 1; i <= steps; i++) {
+            float x = from[0] + d[0] * i / steps, y = from[1] + d[1] * i / steps, zz = from[2] + d[2] * i / steps;
+            float frames[3][3] = { { x, y, zz },
+                                   { x * cos120 + y * sin120, y * cos120 - x * sin120, zz },
+                                   { x * cos120 - y * sin120, y * cos120 + x * sin120, zz } };
+            for (auto& p : frames) {
+                v.insert(v.end(), p, p + 3);
+            }
+        }
+        std::copy(to, to + 3, from);
+    }
+    return v;
+}
+
+TEST(DeltaTable, MatchesExactSolution) {
+    DeltaTable table;
+    ASSERT_TRUE(table.build(arm, radius, minZ, maxZ, 2, 5e-4));
+    EXPECT_GT(table.maxError(), 0);
+    EXPECT_LE(table.maxError(), 5e-4);
+    EXPECT_GT(table.coverage(), 0.8);
+
+    auto   v         = targets(20000);
+    size_t reachable = 0;
+    for (size_t i = 0; i < v.size(); i += 3) {
+        float exact, interpolated;
+        bool  ok = arm.angle(v[i], v[i + 1], v[i + 2], exact);
+        EXPECT_EQ(table.angle(v[i], v[i + 1], v[i + 2], interpolated), ok);
+        if (ok) {
+            ++reachable;
+            // The build check samples each cell, so allow some margin
+            EXPECT_NEAR(interpolated, exact, 2 * table.maxError());
+        }
+    }
+    EXPECT_GT(reachable, v.size() / 3 / 2);
+
+    // Outside the table, the exact solution is used
+    float exact, interpolated;
+    ASSERT_TRUE(arm.angle(0, 40, maxZ + 10, exact));
+    ASSERT_TRUE(table.angle(0, 40, maxZ + 10, interpolated));
+    EXPECT_EQ(interpolated, exact);
+
+    // A coarser grid meets the same tolerance in fewer cells
+    DeltaTable coarse;
+    ASSERT_TRUE(coarse.build(arm, radius, minZ, maxZ, 8, 5e-4));
+    EXPECT_LT(coarse.coverage(), table.coverage());
+    EXPECT_LT(coarse.bytes(), table.bytes());
+}
+
+// Compares the throughput of the exact and tabulated solutions.  Host
+// timings only indicate the ratio to expect on the controller, and only
+// in a build without the sanitizers (env:tests_nosan).
+TEST(DeltaTable, GridFitsMemory) {
+    // The default lookup_min_z_mm and max_z_mm at 4 mm need nearly 1 MB
+    size_t full = DeltaTable::bytesFor(150, -300, 0, 4);
+    EXPECT_GT(full, 900000u);
+    EXPECT_EQ(4, DeltaTable::gridFor(150, -300, 0, 4, full));
+
+    const size_t budget = 64 * 1024;
+    float        grid   = DeltaTable::gridFor(150, -300, 0, 4, budget);
+    EXPECT_GT(grid, 4);
+    EXPECT_LE(DeltaTable::bytesFor(150, -300, 0, grid), budget);
+    EXPECT_GT(DeltaTable::bytesFor(150, -300, 0, grid / 1.1f), budget);
+
+    DeltaTable table;
+    ASSERT_TRUE(table.build(arm, 150, -300, 0, grid, 0.0005f));
+    EXPECT_EQ(DeltaTable::bytesFor(150, -300, 0, grid), table.bytes());
+    EXPECT_EQ(grid, table.grid());
+
+    EXPECT_EQ(0, DeltaTable::gridFor(150, -300, 0, 4, 16));
+    EXPECT_EQ(0, DeltaTable::gridFor(150, 0, -300, 4, budget));
+}
+
+TEST(DeltaTable, Benchmark) {
+    DeltaTable table;
+    ASSERT_TRUE(table.build(arm, radius, minZ, maxZ, 4, 5e-4));
+    auto v = targets(100000);
+
+    auto time = [&](auto solve) {
+        float sum   = 0;
+        auto  start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < v.size(); i += 3) {
+            float theta = 0;
+            solve(v[i], v[i + 1], v[i + 2], theta);
+            sum += theta;
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return std::make_pair(elapsed.count() / (v.size() / 3), sum);
+    };
+    auto exact = time([](float x, float y, float z, float& t) { return arm.angle(x, y, z, t); });
+    auto table_time = time([&](float x, float y, float z, float& t) { return table.angle(x, y, z, t); });
+
+    printf("DeltaTable: exact %.1f ns, table %.1f ns per arm, %zu KB, %.0f%% interpolated, max error %.2e rad\n",
+           exact.first,
+           table_time.first,
+           table.bytes() / 1024,
+           table.coverage() * 100,
+           table.maxError());
+
+    // The sums keep the loops from being optimized away and agree closely
+    EXPECT_NEAR(exact.second, table_time.second, std::fabs(exact.second) * 1e-3);
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/HeightMap.h"
+
+// A 3x2 grid over X0..20 Y0..10 tilted along X and raised at one corner
+static HeightMap tiltedMap() {
+    HeightMap map;
+    map.setup(0, 0, 20, 10, 3, 2);
+    for (size_t n = 0; n < map.points(); n++) {
+        size_t i, j;
+        map.point(n, i, j);
+        map.set(i, j, 1.0f + 0.1f * i + (i == 2 && j == 1 ? 0.4f : 0.0f));
+    }
+    return map;
+}
+
+TEST(HeightMap, SerpentineOrder) {
+    HeightMap map;
+    ASSERT_TRUE(map.setup(0, 0, 20, 20, 3, 3));
+
+    const size_t expected[][2] = { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 2, 1 }, { 1, 1 }, { 0, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } };
+    for (size_t n = 0; n < map.points(); n++) {
+        size_t i, j;
+        map.point(n, i, j);
+        EXPECT_EQ(i, expected[n][0]) << "point " << n;
+        EXPECT_EQ(j, expected[n][1]) << "point " << n;
+        EXPECT_FALSE(map.valid());
+        map.set(i, j, 0);
+    }
+    EXPECT_TRUE(map.valid());
+}
+
+TEST(HeightMap, BilinearOffset) {
+    auto map = tiltedMap();
+    map.enable(true);
+    ASSERT_TRUE(map.active());
+
+    // Relative to the origin, exact at the grid points
+    EXPECT_FLOAT_EQ(map.offset(0, 0), 0.0f);
+    EXPECT_FLOAT_EQ(map.offset(10, 0), 0.1f);
+    EXPECT_FLOAT_EQ(map.offset(20, 10), 0.6f);
+
+    // Interpolated within a cell and clamped outside the grid
+    EXPECT_NEAR(map.offset(15, 5), (0.1f + 0.2f + 0.1f + 0.6f) / 4, 1e-6);
+    EXPECT_NEAR(map.offset(-5, -5), 0.0f, 1e-6);
+    EXPECT_NEAR(map.offset(30, 20), 0.6f, 1e-6);
+}
+
+TEST(HeightMap, Segments) {
+    auto map = tiltedMap();
+
+    // Cells are 10x10 so pieces are at most 5mm
+    EXPECT_EQ(map.segments(0, 0, 0, 0), 1u);
+    EXPECT_EQ(map.segments(0, 0, 4, 0), 1u);
+    EXPECT_EQ(map.segments(0, 0, 20, 0), 4u);
+    EXPECT_EQ(map.segments(0, 0, 30, 40), 10u);
+}
+
+TEST(HeightMap, SaveAndLoad) {
+    auto      map = tiltedMap();
+    HeightMap copy;
+    ASSERT_TRUE(copy.parse(map.serialize()));
+    ASSERT_TRUE(copy.valid());
+    EXPECT_EQ(copy.nx(), 3u);
+    EXPECT_EQ(copy.ny(), 2u);
+    EXPECT_FLOAT_EQ(copy.x(2), 20.0f);
+    EXPECT_FLOAT_EQ(copy.z(2, 1), map.z(2, 1));
+    EXPECT_FALSE(copy.enabled());
+
+    EXPECT_FALSE(copy.parse("heightmap 0 0 20 10 3 2\n1 2 3\n"));
+    EXPECT_FALSE(copy.valid());
+    EXPECT_FALSE(copy.parse("garbage"));
+}
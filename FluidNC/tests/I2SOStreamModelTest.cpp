@@ -0,0 +1,57 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/I2SOStreamModel.h"
+
+// The default firmware layout: 5 buffers of 2000 bytes, 4us samples
+static I2SOStreamModel defaultModel() {
+    return I2SOStreamModel(5, 2000, 4);
+}
+
+TEST(I2SOStreamModel, SlowRateIsExact) {
+    I2SOStreamModel::Costs costs;
+    auto                   r = defaultModel().run(1000, 3, 4, 1000, costs);
+
+    EXPECT_EQ(r.underruns, 0u);
+    EXPECT_EQ(r.overlong, 0u);
+    EXPECT_NEAR(r.step_rate, 1000.0f, 10.0f);
+    EXPECT_LT(r.cpu_load, 0.1f);
+}
+
+TEST(I2SOStreamModel, PulseWidthLimitsRate) {
+    I2SOStreamModel::Costs costs;
+    costs.pulse_base_us     = 0;
+    costs.pulse_per_axis_us = 0;
+    costs.sample_us         = 0;
+
+    // With free CPU, the only limit is that a 20us pulse plus one idle
+    // sample must fit in the period
+    auto rate = defaultModel().max_step_rate(1, 20, 100, costs);
+    EXPECT_LE(rate, 1000000u / 24);
+    EXPECT_GT(rate, 1000000u / 24 - 1000);
+
+    auto r = defaultModel().run(50000, 1, 20, 100, costs);
+    EXPECT_GT(r.overlong, 0u);
+}
+
+TEST(I2SOStreamModel, CpuCostCausesUnderruns) {
+    I2SOStreamModel::Costs costs;
+    costs.pulse_base_us     = 10;
+    costs.pulse_per_axis_us = 2;
+
+    // Each pulse costs 22us of CPU, so 50k pulses/s cannot be sustained
+    auto r = defaultModel().run(50000, 6, 4, 200, costs);
+    EXPECT_GT(r.underruns, 0u);
+    EXPECT_LT(r.step_rate, 50000.0f);
+}
+
+TEST(I2SOStreamModel, MoreAxesLowerMaxRate) {
+    I2SOStreamModel::Costs costs;
+    auto                   model = defaultModel();
+
+    auto rate3 = model.max_step_rate(3, 4, 200, costs);
+    auto rate6 = model.max_step_rate(6, 4, 200, costs);
+    EXPECT_GT(rate3, 0u);
+    EXPECT_GE(rate3, rate6);
+}
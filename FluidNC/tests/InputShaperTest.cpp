@@ -0,0 +1,191 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/InputShaper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+TEST(InputShaper, Impulses) {
+    InputShaper shaper;
+    EXPECT_FALSE(shaper.enabled());
+    EXPECT_FALSE(shaper.configure(0, InputShaper::ZV, 0, 0.1));
+    EXPECT_FALSE(shaper.configure(0, InputShaper::ZV, 40, 1));
+    EXPECT_FALSE(shaper.enabled());
+
+    const float f = 40, zeta = 0.1;
+    double      td = 1 / (f * std::sqrt(1 - zeta * zeta));
+    ASSERT_TRUE(shaper.configure(0, InputShaper::ZV, f, zeta));
+    ASSERT_TRUE(shaper.configure(1, InputShaper::ZVD, f, zeta));
+    ASSERT_TRUE(shaper.configure(2, InputShaper::MZV, f, zeta));
+    EXPECT_NEAR(shaper.duration(), td, 1e-6);
+
+    const size_t n[]    = { 2, 3, 3, 1 };
+    const double last[] = { td / 2, td, 0.75 * td, 0 };
+    for (size_t axis = 0; axis < 4; axis++) {
+        ASSERT_EQ(shaper.impulses(axis), n[axis]);
+        double sum = 0;
+        for (size_t i = 0; i < n[axis]; i++) {
+            sum += shaper.impulse(axis, i).amplitude;
+        }
+        EXPECT_NEAR(sum, 1, 1e-12);
+        EXPECT_NEAR(shaper.impulse(axis, n[axis] - 1).delay, last[axis], 1e-6);
+
+        // The impulses cancel a vibration at the damped frequency
+        double re = 0, im = 0, w = 2 * M_PI / td, s = zeta * 2 * M_PI * f;
+        for (size_t i = 0; i < n[axis] && axis < 3; i++) {
+            auto& imp = shaper.impulse(axis, i);
+            re += imp.amplitude * std::exp(s * imp.delay) * std::cos(w * imp.delay);
+            im += imp.amplitude * std::exp(s * imp.delay) * std::sin(w * imp.delay);
+        }
+        if (axis < 3) {
+            EXPECT_LT(std::hypot(re, im), 0.01) << "axis " << axis;
+        }
+    }
+}
+
+TEST(InputShaper, SettlesExactly) {
+    InputShaper shaper;
+    shaper.configure(0, InputShaper::ZVD, 25, 0.05);
+    double pos[MAX_N_AXIS] = {};
+    shaper.reset(pos);
+    EXPECT_TRUE(shaper.settled());
+
+    // Uneven samples, some much shorter than the spacing, then a stop
+    double out[MAX_N_AXIS];
+    double time = 0;
+    for (int i = 1; i <= 500; i++) {
+        double dt = (i % 7 == 0) ? 0.01 : 0.0001;
+        time += dt;
+        pos[0] = 1234.5 * time;
+        shaper.add(dt, pos);
+        shaper.shaped(out);
+        EXPECT_LE(out[0], pos[0] + 1e-9);
+    }
+    EXPECT_FALSE(shaper.settled());
+    while (!shaper.settled()) {
+        shaper.add(0.01, pos);
+    }
+    shaper.shaped(out);
+    EXPECT_EQ(out[0], pos[0]);
+}
+
+// A step-trace model of one move through the segment generator.  The raw
+// motion is a trapezoidal speed profile on X followed, around a square
+// corner, by the same on Y.  Like Stepper::prep_buffer() with shaping
+// on, each 5 ms segment moves each axis to the rounded shaped position, with its steps
+// evenly spaced.  The tool is a damped mass on a spring from the motor
+// position, and the residual vibration is its largest deviation after the
+// motion of the axis ends.
+struct Trace {
+    double seconds;      // Time of the last step
+    double residual[2];  // mm
+};
+
+static Trace trace(InputShaper::Type type, double accel) {
+    const double stepsPerMm = 400;
+    const double speed      = 100;  // mm/sec
+    const double distance   = 20;   // mm
+    const double f = 40, zeta = 0.05;
+    const double segment    = 0.005;
+
+    InputShaper shaper;
+    shaper.configure(0, type, f, zeta);
+    shaper.configure(1, type, f, zeta);
+    double zero[MAX_N_AXIS] = {};
+    shaper.reset(zero);
+
+    // The raw position of the trapezoid at time t
+    double ta   = speed / accel;
+    double tc   = (distance - speed * ta) / speed;
+    double tmov = 2 * ta + tc;
+    auto   trap = [&](double t) {
+        if (t <= 0) {
+            return 0.0;
+        }
+        if (t >= tmov) {
+            return distance;
+        }
+        if (t < ta) {
+            return 0.5 * accel * t * t;
+        }
+        if (t < ta + tc) {
+            return 0.5 * accel * ta * ta + speed * (t - ta);
+        }
+        double r = tmov - t;
+        return distance - 0.5 * accel * r * r;
+    };
+
+    // Step times for each axis
+    std::vector<double> steps[2];
+    long                emitted[2] = {};
+    double              t          = 0;
+    while (t < 2 * tmov || !shaper.settled()) {
+        double dt = std::min(segment, std::max(2 * tmov - t, segment));
+        t += dt;
+        double raw[MAX_N_AXIS] = { trap(t) * stepsPerMm, trap(t - tmov) * stepsPerMm };
+        shaper.add(dt, raw);
+        double out[MAX_N_AXIS];
+        shaper.shaped(out);
+        for (int axis = 0; axis < 2; axis++) {
+            long n = std::lround(out[axis]) - emitted[axis];
+            EXPECT_GE(n, 0);
+            for (long i = 0; i < n; i++) {
+                steps[axis].push_back(t - dt + (i + 0.5) * dt / n);
+            }
+            emitted[axis] += n;
+        }
+    }
+    EXPECT_EQ(emitted[0], std::lround(distance * stepsPerMm));
+    EXPECT_EQ(emitted[1], std::lround(distance * stepsPerMm));
+
+    Trace result;
+    result.seconds = steps[1].back();
+    for (int axis = 0; axis < 2; axis++) {
+        const double w = 2 * M_PI * f, h = 1e-5;
+        double       y = 0, v = 0, max = 0;
+        size_t       n   = 0;
+        double       end = steps[axis].back();
+        for (double time = 0; time < end + 0.5; time += h) {
+            while (n < steps[axis].size() && steps[axis][n] <= time) {
+                ++n;
+            }
+            double u = n / stepsPerMm;
+            v += h * (w * w * (u - y) - 2 * zeta * w * v);
+            y += h * v;
+            if (time > end) {
+                max = std::max(max, std::fabs(y - u));
+            }
+        }
+        result.residual[axis] = max;
+    }
+    return result;
+}
+
+TEST(InputShaper, CornerRinging) {
+    const double accel = 3000;  // mm/sec^2
+    auto         plain = trace(InputShaper::None, accel);
+    auto         slow  = trace(InputShaper::None, accel / 4);
+    printf("InputShaper: none %.1f ms %.4f/%.4f mm, accel/4 %.1f ms %.4f/%.4f mm\n",
+           plain.seconds * 1000,
+           plain.residual[0],
+           plain.residual[1],
+           slow.seconds * 1000,
+           slow.residual[0],
+           slow.residual[1]);
+
+    for (auto type : { InputShaper::ZV, InputShaper::ZVD, InputShaper::MZV }) {
+        auto shaped = trace(type, accel);
+        printf("InputShaper: type %d %.1f ms %.4f/%.4f mm\n", type, shaped.seconds * 1000, shaped.residual[0], shaped.residual[1]);
+        for (int axis = 0; axis < 2; axis++) {
+            EXPECT_LT(shaped.residual[axis], plain.residual[axis] / 4) << "type " << type << " axis " << axis;
+            EXPECT_LT(shaped.residual[axis], slow.residual[axis]) << "type " << type << " axis " << axis;
+        }
+        // The cost is the duration of the shaper, much less than lowering the acceleration
+        EXPECT_LT(shaped.seconds, plain.seconds + 0.03);
+        EXPECT_LT(shaped.seconds, slow.seconds);
+    }
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/JobScan.h"
+
+// 6000 mm/min and 100 mm/sec^2 on every axis
+static JobScan::Machine machine() {
+    JobScan::Machine m;
+    for (size_t axis = 0; axis < MAX_N_AXIS; axis++) {
+        m.maxRate[axis]      = 6000;
+        m.acceleration[axis] = 100;
+    }
+    return m;
+}
+
+static JobScan scan(const std::vector<const char*>& lines, const JobScan::Machine& m = machine()) {
+    JobScan  job(m);
+    uint32_t offset = 0;
+    for (auto line : lines) {
+        offset += strlen(line) + 1;
+        job.line(line, offset);
+    }
+    job.finish();
+    return job;
+}
+
+TEST(JobScan, StraightMove) {
+    // 10 mm/sec reached in 0.1 sec over 0.5 mm at each end
+    EXPECT_NEAR(scan({ "G1 X100 F600" }).seconds(), 10.1f, 1e-3);
+
+    // 25.4 mm at 254 mm/min, then a dwell in seconds
+    EXPECT_NEAR(scan({ "G20", "G1 X1 F10", "G4 P2" }).seconds(), 6.0f + 0.0423f + 2.0f, 1e-3);
+
+    // Comments and commands do not move
+    EXPECT_EQ(scan({ "(G1 X100 F600)", "; G1 X100", "$X" }).seconds(), 0.0f);
+}
+
+TEST(JobScan, Junctions) {
+    // Continuing in the same direction is faster than turning a corner,
+    // which is faster than reversing
+    float straight = scan({ "G1 X50 F3000", "X100" }).seconds();
+    float corner   = scan({ "G1 X50 F3000", "Y50" }).seconds();
+    float reverse  = scan({ "G1 X50 F3000", "X0" }).seconds();
+    EXPECT_LT(straight, corner);
+    EXPECT_LT(corner, reverse);
+    EXPECT_NEAR(straight, scan({ "G1 X100 F3000" }).seconds(), 1e-3);
+}
+
+TEST(JobScan, Bounds) {
+    // A half circle counterclockwise from +X through +Y
+    auto job = scan({ "G0 X10 Y0", "G3 X-10 Y0 I-10 J0 F600", "G91 G1 Z-2", "G90 G92 X0", "G1 X5" });
+    ASSERT_TRUE(job.moved());
+    EXPECT_NEAR(job.min(0), -10, 1e-3);
+    EXPECT_NEAR(job.max(0), 10, 1e-3);
+    EXPECT_NEAR(job.min(1), 0, 1e-3);
+    EXPECT_NEAR(job.max(1), 10, 1e-3);
+    EXPECT_NEAR(job.min(2), -2, 1e-3);
+    EXPECT_NEAR(job.max(2), 0, 1e-3);
+}
+
+TEST(JobScan, CacheAndProgress) {
+    std::vector<std::string> text;
+    std::vector<const char*> lines;
+    for (int i = 1; i <= 200; i++) {
+        text.push_back("G1 X" + std::to_string(i % 2 ? 100 : 0) + " F6000");
+    }
+    for (auto& line : text) {
+        lines.push_back(line.c_str());
+    }
+    auto job = scan(lines);
+
+    JobScan copy;
+    ASSERT_TRUE(copy.parse(job.serialize("123 456"), "123 456"));
+    EXPECT_FALSE(copy.parse(job.serialize("123 456"), "123 457"));
+    EXPECT_NEAR(copy.seconds(), job.seconds(), 0.1);
+    EXPECT_NEAR(copy.max(0), 100, 1e-3);
+
+    // Time grows with position through the file
+    float half = copy.seconds_at(1000);
+    EXPECT_GT(half, 0);
+    EXPECT_LT(half, copy.seconds());
+    EXPECT_LE(copy.seconds_at(500), half);
+    EXPECT_EQ(copy.seconds_at(100000), copy.seconds());
+}
+
+TEST(JobScan, ParserModalRules) {
+    // These cases follow the checks in gc_execute_line(), so that a change
+    // there that the scanner does not follow shows up here.
+
+    // The motion mode is modal, so axis words alone repeat it
+    EXPECT_NEAR(scan({ "G1 X50 F600", "X100" }).seconds(), scan({ "G1 X100 F600" }).seconds(), 1e-3);
+
+    // A feed move needs a feed rate; without one the line is rejected
+    EXPECT_FALSE(scan({ "G1 X10" }).moved());
+    EXPECT_TRUE(scan({ "G0 X10" }).moved());
+
+    // After G80 axis words do not move
+    EXPECT_NEAR(scan({ "G1 X10 F600", "G80", "X20" }).max(0), 10, 1e-3);
+
+    // G10 and G92 take the axis words, so there is no move
+    auto job = scan({ "G1 X10 F600", "G10 L20 P1 X50", "G92 X0" });
+    EXPECT_NEAR(job.max(0), 10, 1e-3);
+
+    // An inverse time feed rate applies only to its own line: 1/6 minute
+    // for the first move, and the second has no feed rate
+    job = scan({ "G93 G1 X10 F6", "X20" });
+    EXPECT_NEAR(job.max(0), 10, 1e-3);
+    EXPECT_NEAR(job.seconds(), 10, 0.1);
+
+    // Returning to G94 leaves the feed rate undefined until an F word sets it
+    EXPECT_NEAR(scan({ "G1 X10 F600", "G93 X20 F6", "G94 X30", "X40 F600" }).seconds(),
+                scan({ "G1 X10 F600", "G93 X20 F6", "G94 X40 F600" }).seconds(),
+                1e-3);
+
+    // Inches scale the linear axes and the feed rate, but not the rotary axes
+    auto m  = machine();
+    m.nAxes = 4;
+    job     = scan({ "G20 G1 X1 A1 F60" }, m);
+    EXPECT_NEAR(job.max(0), 25.4, 1e-3);
+    EXPECT_NEAR(job.max(3), 1, 1e-3);
+    EXPECT_NEAR(job.seconds(), 1.0f + 0.254f, 0.01);  // 25.4 mm at 1524 mm/min, plus the ramps
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/WebUI/NotificationServer.h"
+
+using WebUI::NotificationServer;
+
+TEST(NotificationServer, ParsesStandInServer) {
+    NotificationServer server;
+    ASSERT_TRUE(server.parse("me@example.com#127.0.0.1:2525"));
+    EXPECT_EQ("me@example.com", server.address);
+    EXPECT_EQ("127.0.0.1", server.host);
+    EXPECT_EQ(2525, server.port);
+
+    ASSERT_TRUE(server.parse("me@example.com#smtp.example.com:465"));
+    EXPECT_EQ("smtp.example.com", server.host);
+    EXPECT_EQ(465, server.port);
+}
+
+TEST(NotificationServer, RejectsIncompleteSettings) {
+    NotificationServer server;
+    ASSERT_TRUE(server.parse("me@example.com#localhost:25"));
+
+    const char* bad[] = {
+        "",
+        "me@example.com",
+        "me@example.com#localhost",
+        "#localhost:25",
+        "me@example.com#:25",
+        "me@example.com#localhost:",
+        "me@example.com#localhost:0",
+        "me@example.com#localhost:65536",
+        "me@example.com#localhost:25x",
+        "localhost:25",
+    };
+    for (auto ts : bad) {
+        EXPECT_FALSE(server.parse(ts)) << ts;
+    }
+    // A failed parse leaves the previous server in place
+    EXPECT_EQ("me@example.com", server.address);
+    EXPECT_EQ("localhost", server.host);
+    EXPECT_EQ(25, server.port);
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/OccupancyHistogram.h"
+
+TEST(OccupancyHistogram, Summary) {
+    OccupancyHistogram hist;
+    EXPECT_EQ(hist.samples(), 0u);
+    EXPECT_EQ(hist.mean(), 0.0f);
+    EXPECT_EQ(hist.percentile(0.5), 0u);
+
+    // Mostly full, with a few dips
+    for (int i = 0; i < 90; i++) {
+        hist.add(11);
+    }
+    for (int i = 0; i < 8; i++) {
+        hist.add(5);
+    }
+    hist.add(0);
+    hist.add(1000);  // Clamped to the top level
+
+    EXPECT_EQ(hist.samples(), 100u);
+    EXPECT_EQ(hist.count(11), 90u);
+    EXPECT_EQ(hist.count(OccupancyHistogram::MAX_LEVELS - 1), 1u);
+    EXPECT_EQ(hist.min(), 0u);
+    EXPECT_EQ(hist.max(), OccupancyHistogram::MAX_LEVELS - 1);
+    EXPECT_EQ(hist.percentile(0.01), 0u);
+    EXPECT_EQ(hist.percentile(0.05), 5u);
+    EXPECT_EQ(hist.percentile(0.5), 11u);
+    EXPECT_NEAR(hist.mean(), (90 * 11 + 8 * 5 + 0 + 127) / 100.0, 1e-4);
+
+    hist.clear();
+    EXPECT_EQ(hist.samples(), 0u);
+    EXPECT_EQ(hist.count(11), 0u);
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/PathBlender.h"
+
+#include <cmath>
+#include <vector>
+
+using Point = std::vector<float>;
+
+// Feeds the moves through zig-zag vertices and returns the blended path
+static std::vector<Point> blend(const std::vector<Point>& vertices, float tolerance) {
+    PathBlender blender;
+    blender.setAxes(3);
+    std::vector<Point> path = { vertices[0] };
+    PathBlender::Points pts;
+    for (size_t i = 1; i < vertices.size(); i++) {
+        blender.add(vertices[i - 1].data(), vertices[i].data(), tolerance, pts);
+        for (size_t j = 0; j < pts.count; j++) {
+            path.push_back(Point(pts.point[j], pts.point[j] + 3));
+        }
+    }
+    Point end(3);
+    EXPECT_TRUE(blender.flush(end.data()));
+    EXPECT_FALSE(blender.flush(end.data()));
+    path.push_back(end);
+    return path;
+}
+
+static float distance(const Point& a, const Point& b) {
+    return std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+// Distance from p to the segment ab
+static float toSegment(const Point& p, const Point& a, const Point& b) {
+    float len2 = distance(a, b) * distance(a, b);
+    float t    = 0;
+    for (int i = 0; i < 3; i++) {
+        t += (p[i] - a[i]) * (b[i] - a[i]);
+    }
+    t = len2 > 0 ? std::fmax(0, std::fmin(1, t / len2)) : 0;
+    Point q(3);
+    for (int i = 0; i < 3; i++) {
+        q[i] = a[i] + t * (b[i] - a[i]);
+    }
+    return distance(p, q);
+}
+
+TEST(PathBlender, RoundsWithinTolerance) {
+    const float              tolerance = 0.05;
+    const std::vector<Point> vertices  = { { 0, 0, 0 }, { 10, 0, 0 }, { 10, 10, 1 }, { 12, 11, 1 }, { 0, 0, 0 } };
+    auto                     path      = blend(vertices, tolerance);
+    EXPECT_GT(path.size(), vertices.size());
+    EXPECT_EQ(path.front(), vertices.front());
+    EXPECT_EQ(path.back(), vertices.back());
+
+    // Every corner is within the tolerance of the blended path, and every
+    // point of the path is near the original one
+    for (size_t v = 1; v + 1 < vertices.size(); v++) {
+        float closest = 1e9;
+        for (size_t i = 1; i < path.size(); i++) {
+            closest = std::fmin(closest, toSegment(vertices[v], path[i - 1], path[i]));
+        }
+        EXPECT_LE(closest, tolerance * 1.001) << "corner " << v;
+    }
+    for (auto& p : path) {
+        float closest = 1e9;
+        for (size_t i = 1; i < vertices.size(); i++) {
+            closest = std::fmin(closest, toSegment(p, vertices[i - 1], vertices[i]));
+        }
+        EXPECT_LE(closest, tolerance * 1.001);
+    }
+}
+
+TEST(PathBlender, EqualTurns) {
+    // A right angle turns by at most maxTurn at each junction, all equal
+    auto path = blend({ { 0, 0, 0 }, { 10, 0, 0 }, { 10, 10, 0 } }, 0.1);
+    ASSERT_GE(path.size(), 5u);
+    std::vector<float> turns;
+    for (size_t i = 1; i + 1 < path.size(); i++) {
+        float a0 = std::atan2(path[i][1] - path[i - 1][1], path[i][0] - path[i - 1][0]);
+        float a1 = std::atan2(path[i + 1][1] - path[i][1], path[i + 1][0] - path[i][0]);
+        turns.push_back(a1 - a0);
+    }
+    for (auto turn : turns) {
+        EXPECT_NEAR(turn, turns[0], 1e-4);
+        EXPECT_LE(turn, PathBlender::maxTurn + 1e-4);
+    }
+}
+
+TEST(PathBlender, ShortMoves) {
+    // Short moves give up at most half of their length to each corner
+    auto path = blend({ { 0, 0, 0 }, { 0.1, 0, 0 }, { 0.1, 0.1, 0 }, { 0.2, 0.1, 0 } }, 1);
+    for (size_t i = 1; i < path.size(); i++) {
+        EXPECT_LE(distance(path[i - 1], path[i]), 0.1 + 1e-6);
+    }
+    EXPECT_NEAR(path[1][0], 0.05, 1e-6);
+}
+
+TEST(PathBlender, Unchanged) {
+    // Straight on, zero tolerance, and reversals pass the vertices through
+    const std::vector<std::vector<Point>> cases = {
+        { { 0, 0, 0 }, { 1, 1, 0 }, { 3, 3, 0 } },
+        { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 0, 0 } },
+    };
+    for (auto& vertices : cases) {
+        EXPECT_EQ(blend(vertices, 0.1), vertices);
+    }
+    EXPECT_EQ(blend({ { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 } }, 0).size(), 3u);
+}
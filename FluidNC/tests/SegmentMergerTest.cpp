@@ -0,0 +1,69 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/SegmentMerger.h"
+
+#include <cmath>
+#include <vector>
+
+using Point = std::vector<float>;
+using Move  = std::pair<Point, Point>;
+
+// Feeds the moves through the vertices and returns the merged moves
+static std::vector<Move> merge(SegmentMerger& merger, const std::vector<Point>& vertices, float tolerance) {
+    std::vector<Move> moves;
+    float             start[3], end[3];
+    for (size_t i = 1; i < vertices.size(); i++) {
+        if (merger.add(vertices[i - 1].data(), vertices[i].data(), tolerance, start, end)) {
+            moves.push_back({ Point(start, start + 3), Point(end, end + 3) });
+        }
+    }
+    if (merger.flush(start, end)) {
+        moves.push_back({ Point(start, start + 3), Point(end, end + 3) });
+    }
+    EXPECT_FALSE(merger.held());
+    return moves;
+}
+
+TEST(SegmentMerger, MergesNearlyColinear) {
+    // A slightly wavy line of tiny moves, then a corner
+    std::vector<Point> vertices;
+    for (int i = 0; i <= 10; i++) {
+        vertices.push_back({ 0.1f * i, (i % 2) * 0.001f, 0 });
+    }
+    vertices.push_back({ 1, 1, 0 });
+
+    SegmentMerger merger;
+    auto          moves = merge(merger, vertices, 0.002);
+    ASSERT_EQ(moves.size(), 2u);
+    EXPECT_EQ(moves[0].first, vertices[0]);
+    EXPECT_EQ(moves[0].second, vertices[10]);
+    EXPECT_EQ(moves[1].first, vertices[10]);
+    EXPECT_EQ(moves[1].second, vertices[11]);
+    EXPECT_EQ(merger.moves(), 11u);
+    EXPECT_EQ(merger.blocks(), 2u);
+
+    // A tighter tolerance keeps the waves
+    SegmentMerger tight;
+    EXPECT_EQ(merge(tight, vertices, 0.0004).size(), 11u);
+    EXPECT_EQ(merge(tight, vertices, 0).size(), 11u);
+}
+
+TEST(SegmentMerger, KeepsReversals) {
+    // Moving back along the same line must not be merged away
+    SegmentMerger merger;
+    auto          moves = merge(merger, { { 0, 0, 0 }, { 1, 0, 0 }, { 2, 0, 0 }, { 1.5, 0, 0 }, { 3, 0, 0 } }, 0.01);
+    ASSERT_EQ(moves.size(), 3u);
+    EXPECT_EQ(moves[0].second, Point({ 2, 0, 0 }));
+    EXPECT_EQ(moves[1].second, Point({ 1.5, 0, 0 }));
+}
+
+TEST(SegmentMerger, LimitsRunLength) {
+    std::vector<Point> vertices;
+    for (size_t i = 0; i <= 2 * (SegmentMerger::MAX_POINTS + 1); i++) {
+        vertices.push_back({ float(i), 0, 0 });
+    }
+    SegmentMerger merger;
+    EXPECT_EQ(merge(merger, vertices, 0.01).size(), 2u);
+}
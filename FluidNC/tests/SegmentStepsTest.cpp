@@ -0,0 +1,141 @@
+// Copyright (c) 2026 - agent
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "gtest/gtest.h"
+#include "src/SegmentSteps.h"
+
+#include <cmath>
+#include <vector>
+
+const float TICKS_PER_MINUTE = 20000000.0f * 60;  // A 20 MHz step timer
+const float DT               = 1.0f / (100 * 60);  // 100 segments per second, in minutes
+
+// The distance from the end of the block, in mm, at the end of each segment
+// of a move that accelerates to 'speed' mm/min and back down to a stop.
+static std::vector<float> profile(float millimeters, float speed, float accel) {
+    std::vector<float> remaining;
+    float              ramp = speed * speed / (2 * accel);
+    if (2 * ramp > millimeters) {
+        ramp  = millimeters / 2;
+        speed = sqrtf(2 * accel * ramp);
+    }
+    float cruise = (millimeters - 2 * ramp) / speed;
+    float total  = 2 * speed / accel + cruise;
+    for (float t = DT; t < total; t += DT) {
+        float done;
+        if (t < speed / accel) {
+            done = 0.5f * accel * t * t;
+        } else if (t < speed / accel + cruise) {
+            done = ramp + speed * (t - speed / accel);
+        } else {
+            float left = total - t;
+            done       = millimeters - 0.5f * accel * left * left;
+        }
+        remaining.push_back(millimeters - done);
+    }
+    remaining.push_back(0);
+    return remaining;
+}
+
+struct Segment {
+    uint32_t steps;
+    uint32_t period;
+};
+
+// The float formulation that SegmentSteps replaced
+static std::vector<Segment> float_segments(uint32_t step_count, float millimeters, const std::vector<float>& remaining) {
+    std::vector<Segment> segments;
+    float                steps_remaining = float(step_count);
+    float                step_per_mm     = steps_remaining / millimeters;
+    float                dt_remainder    = 0;
+    for (float mm : remaining) {
+        float step_dist_remaining    = step_per_mm * mm;
+        float n_steps_remaining      = ceilf(step_dist_remaining);
+        float last_n_steps_remaining = ceilf(steps_remaining);
+        float dt                     = DT + dt_remainder;
+        float inv_rate               = dt / (last_n_steps_remaining - step_dist_remaining);
+        segments.push_back({ uint32_t(last_n_steps_remaining - n_steps_remaining), uint32_t(ceilf(TICKS_PER_MINUTE * inv_rate)) });
+        steps_remaining = n_steps_remaining;
+        dt_remainder    = (n_steps_remaining - step_dist_remaining) * inv_rate;
+    }
+    return segments;
+}
+
+static std::vector<Segment> fixed_segments(uint32_t step_count, float millimeters, const std::vector<float>& remaining) {
+    std::vector<Segment> segments;
+    SegmentSteps         steps;
+    float                step_per_mm = step_count / millimeters;
+    steps.begin(step_count);
+    for (float mm : remaining) {
+        Segment segment;
+        segment.steps = steps.take(step_per_mm * mm, uint32_t(DT * TICKS_PER_MINUTE + 0.5f), segment.period);
+        segments.push_back(segment);
+    }
+    EXPECT_EQ(steps.remaining(), 0u);
+    return segments;
+}
+
+static uint64_t total_steps(const std::vector<Segment>& segments) {
+    uint64_t total = 0;
+    for (auto& segment : segments) {
+        total += segment.steps;
+    }
+    return total;
+}
+
+TEST(SegmentSteps, MatchesFloatSteps) {
+    // Where floats resolve every step, the steps in each segment are the same
+    // and the periods agree to within the float round-off
+    for (uint32_t step_count : { 1u, 7u, 1000u, 12345u, 800000u }) {
+        float millimeters = step_count / 80.0f;
+        auto  remaining   = profile(millimeters, 3000, 36000);
+        auto  reference   = float_segments(step_count, millimeters, remaining);
+        auto  segments    = fixed_segments(step_count, millimeters, remaining);
+        ASSERT_EQ(segments.size(), reference.size());
+        EXPECT_EQ(total_steps(segments), step_count);
+        EXPECT_EQ(total_steps(reference), step_count);
+        for (size_t i = 0; i < segments.size(); i++) {
+            EXPECT_EQ(segments[i].steps, reference[i].steps) << "segment " << i << " of " << step_count;
+            if (segments[i].steps) {
+                EXPECT_NEAR(double(segments[i].period), double(reference[i].period), 1 + reference[i].period * 1e-4) << "segment " << i;
+            }
+        }
+    }
+}
+
+TEST(SegmentSteps, LongMovesEndOnTheStep) {
+    // Step counts that a float cannot hold exactly still come out exactly
+    for (uint32_t step_count : { (1u << 24) + 1, (1u << 25) + 3, 100000001u }) {
+        float millimeters = step_count / 3200.0f;
+        auto  remaining   = profile(millimeters, 20000, 1000000);
+        EXPECT_EQ(total_steps(fixed_segments(step_count, millimeters, remaining)), step_count);
+        EXPECT_NE(total_steps(float_segments(step_count, millimeters, remaining)), step_count);
+    }
+}
+
+TEST(SegmentSteps, CarriesPartialSteps) {
+    // 2.5 steps per segment at a steady speed run at a steady period
+    SegmentSteps steps;
+    const int    n_segments = 1000;
+    steps.begin(n_segments * 5 / 2);
+    uint32_t total = 0;
+    for (int i = 1; i <= n_segments; i++) {
+        uint32_t period;
+        uint32_t n_step = steps.take((n_segments - i) * 2.5f, 1000, period);
+        EXPECT_TRUE(n_step == 2 || n_step == 3);
+        EXPECT_EQ(period, 400u);
+        total += n_step;
+    }
+    EXPECT_EQ(total, uint32_t(n_segments * 5 / 2));
+    EXPECT_EQ(steps.remaining(), 0u);
+}
+
+TEST(SegmentSteps, SegmentWithoutMotion) {
+    // The time of a segment that does not move goes to the next one
+    SegmentSteps steps;
+    uint32_t     period;
+    steps.begin(10);
+    EXPECT_EQ(steps.take(10, 1000, period), 0u);
+    EXPECT_EQ(steps.take(5, 1000, period), 5u);
+    EXPECT_EQ(period, 400u);
+}